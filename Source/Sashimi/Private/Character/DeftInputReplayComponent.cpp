@@ -0,0 +1,388 @@
+#include "Character/DeftInputReplayComponent.h"
+#include "Character/PlayerCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY(LogDeftReplay);
+
+FArchive& operator<<(FArchive& aAr, FDeftReplayInputEvent& aEvent)
+{
+	aAr << aEvent.m_Frame << aEvent.m_Input << aEvent.m_Value;
+	return aAr;
+}
+
+FArchive& operator<<(FArchive& aAr, FDeftReplaySample& aSample)
+{
+	aAr << aSample.m_Location << aSample.m_Velocity;
+	return aAr;
+}
+
+FArchive& operator<<(FArchive& aAr, FDeftInputReplay& aReplay)
+{
+	uint32 magic = FDeftInputReplay::Magic;
+	uint32 version = FDeftInputReplay::Version;
+	aAr << magic << version;
+	if (magic != FDeftInputReplay::Magic || version != FDeftInputReplay::Version)
+	{
+		aAr.SetError();
+		return aAr;
+	}
+
+	aAr << aReplay.m_FixedDeltaTime;
+	aAr << aReplay.m_StartLocation << aReplay.m_StartVelocity << aReplay.m_StartRotation << aReplay.m_StartControlRotation << aReplay.m_StartMovementMode;
+	aAr << aReplay.m_Events;
+	aAr << aReplay.m_Trajectory;
+	return aAr;
+}
+
+FString FDeftInputReplay::GetReplayPath(const FString& aName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InputReplays"), aName + TEXT(".deftreplay"));
+}
+
+bool FDeftInputReplay::Save(const FString& aName) const
+{
+	TArray<uint8> bytes;
+	FMemoryWriter writer(bytes);
+	writer << const_cast<FDeftInputReplay&>(*this);
+	return FFileHelper::SaveArrayToFile(bytes, *GetReplayPath(aName));
+}
+
+bool FDeftInputReplay::Load(const FString& aName)
+{
+	TArray<uint8> bytes;
+	if (!FFileHelper::LoadFileToArray(bytes, *GetReplayPath(aName)))
+		return false;
+
+	FMemoryReader reader(bytes);
+	reader << *this;
+	return !reader.IsError();
+}
+
+
+UDeftInputReplayComponent::UDeftInputReplayComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void UDeftInputReplayComponent::EndPlay(const EEndPlayReason::Type aEndPlayReason)
+{
+	Stop();
+	Super::EndPlay(aEndPlayReason);
+}
+
+void UDeftInputReplayComponent::StartRecording(const FString& aName, float aFixedDeltaTime)
+{
+	const ACharacter* character = Cast<ACharacter>(GetOwner());
+	if (!character || m_State != EReplayState::Idle)
+		return;
+
+	m_ReplayName = aName;
+	m_Replay = FDeftInputReplay();
+	m_Replay.m_FixedDeltaTime = aFixedDeltaTime;
+	m_Replay.m_StartLocation = character->GetActorLocation();
+	m_Replay.m_StartVelocity = character->GetCharacterMovement()->Velocity;
+	m_Replay.m_StartRotation = character->GetActorRotation();
+	m_Replay.m_StartControlRotation = character->GetControlRotation();
+	m_Replay.m_StartMovementMode = character->GetCharacterMovement()->MovementMode;
+
+	Begin(EReplayState::Recording);
+	UE_LOG(LogDeftReplay, Display, TEXT("recording %s at %.1f Hz"), *m_ReplayName, 1.f / aFixedDeltaTime);
+}
+
+void UDeftInputReplayComponent::StartPlayback(const FString& aName, float aTolerance)
+{
+	ACharacter* character = Cast<ACharacter>(GetOwner());
+	if (!character || m_State != EReplayState::Idle)
+		return;
+
+	if (!m_Replay.Load(aName))
+	{
+		UE_LOG(LogDeftReplay, Error, TEXT("couldn't load replay %s"), *FDeftInputReplay::GetReplayPath(aName));
+		return;
+	}
+
+	m_ReplayName = aName;
+	m_Tolerance = aTolerance;
+	m_PlaybackResults = PlaybackResults();
+	m_bPlaybackFinished = false;
+	m_FrameTimesMs.Reset(m_Replay.m_Trajectory.Num());
+
+	// put the character back exactly where the recording started
+	UCharacterMovementComponent* movementComponent = character->GetCharacterMovement();
+	character->SetActorLocationAndRotation(m_Replay.m_StartLocation, m_Replay.m_StartRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	if (AController* controller = character->GetController())
+		controller->SetControlRotation(m_Replay.m_StartControlRotation);
+	movementComponent->SetMovementMode((EMovementMode)m_Replay.m_StartMovementMode);
+	movementComponent->Velocity = m_Replay.m_StartVelocity;
+
+	// live input would mix with the recorded input
+	if (APlayerController* playerController = Cast<APlayerController>(character->GetController()))
+		character->DisableInput(playerController);
+
+	Begin(EReplayState::Playback);
+	UE_LOG(LogDeftReplay, Display, TEXT("playing %s: %d frames, %d input events"), *m_ReplayName, m_Replay.m_Trajectory.Num(), m_Replay.m_Events.Num());
+}
+
+void UDeftInputReplayComponent::Stop()
+{
+	if (m_State == EReplayState::Recording)
+	{
+		m_Replay.m_Trajectory.Add(MakeSample());
+		if (m_Replay.Save(m_ReplayName))
+			UE_LOG(LogDeftReplay, Display, TEXT("saved %s: %d frames, %d input events"), *FDeftInputReplay::GetReplayPath(m_ReplayName), m_Replay.m_Trajectory.Num(), m_Replay.m_Events.Num());
+		else
+			UE_LOG(LogDeftReplay, Error, TEXT("couldn't save replay %s"), *FDeftInputReplay::GetReplayPath(m_ReplayName));
+		End();
+	}
+	else if (m_State == EReplayState::Playback)
+	{
+		UE_LOG(LogDeftReplay, Warning, TEXT("playback of %s stopped at frame %u of %d"), *m_ReplayName, m_Frame, m_Replay.m_Trajectory.Num());
+		End();
+	}
+}
+
+void UDeftInputReplayComponent::Begin(EReplayState aState)
+{
+	m_State = aState;
+	m_Frame = 0;
+	m_NextEvent = 0;
+	m_HeldMoveValue = FVector2f::ZeroVector;
+	m_QueuedInputs.Reset();
+
+	// frames are only reproducible if every frame has the same delta
+	m_bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	m_PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(m_Replay.m_FixedDeltaTime);
+
+	AddTickPrerequisites();
+	SetComponentTickEnabled(true);
+}
+
+void UDeftInputReplayComponent::AddTickPrerequisites()
+{
+	const ACharacter* character = Cast<ACharacter>(GetOwner());
+	if (!character)
+		return;
+
+	// recording samples and playback sends input before the controller ticks, which is where Enhanced Input runs the
+	// handlers and UpdateRotation applies look input, so both see a frame's input at the same point
+	character->GetCharacterMovement()->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+	if (AController* controller = character->GetController())
+	{
+		controller->AddTickPrerequisiteComponent(this);
+		m_PrerequisiteController = controller;
+	}
+}
+
+void UDeftInputReplayComponent::RemoveTickPrerequisites()
+{
+	if (const ACharacter* character = Cast<ACharacter>(GetOwner()))
+		character->GetCharacterMovement()->PrimaryComponentTick.RemovePrerequisite(this, PrimaryComponentTick);
+	if (AController* controller = m_PrerequisiteController.Get())
+		controller->RemoveTickPrerequisiteComponent(this);
+	m_PrerequisiteController.Reset();
+}
+
+void UDeftInputReplayComponent::End()
+{
+	FApp::SetUseFixedTimeStep(m_bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(m_PreviousFixedDeltaTime);
+
+	RemoveTickPrerequisites();
+	if (m_State == EReplayState::Playback)
+	{
+		ACharacter* character = Cast<ACharacter>(GetOwner());
+		if (APlayerController* playerController = character ? Cast<APlayerController>(character->GetController()) : nullptr)
+			character->EnableInput(playerController);
+	}
+
+	SetComponentTickEnabled(false);
+	m_State = EReplayState::Idle;
+}
+
+void UDeftInputReplayComponent::RecordInput(EDeftReplayInput aInput, const FVector2D& aValue)
+{
+	// input from before the first recorded frame was applied before the start state was taken
+	if (m_Replay.m_Trajectory.IsEmpty())
+		return;
+
+	const FVector2f value(aValue);
+	if (aInput == EDeftReplayInput::Move)
+	{
+		// Enhanced Input repeats the held value every frame, only changes are stored
+		if (value == m_HeldMoveValue)
+			return;
+		m_HeldMoveValue = value;
+	}
+	else if (aInput == EDeftReplayInput::Look && value.IsZero())
+	{
+		return;
+	}
+
+	FDeftReplayInputEvent& inputEvent = m_Replay.m_Events.AddDefaulted_GetRef();
+	inputEvent.m_Frame = m_Frame;
+	inputEvent.m_Input = aInput;
+	inputEvent.m_Value = value;
+}
+
+void UDeftInputReplayComponent::QueueInput(EDeftReplayInput aInput, const FVector2D& aValue)
+{
+	if (m_State == EReplayState::Recording)
+		m_QueuedInputs.Add({ 0, aInput, FVector2f(aValue) });
+}
+
+FDeftReplaySample UDeftInputReplayComponent::MakeSample() const
+{
+	const ACharacter* character = CastChecked<ACharacter>(GetOwner());
+	FDeftReplaySample sample;
+	sample.m_Location = FVector3f(character->GetActorLocation());
+	sample.m_Velocity = FVector3f(character->GetCharacterMovement()->Velocity);
+	return sample;
+}
+
+void UDeftInputReplayComponent::TickComponent(float aDeltaTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction)
+{
+	Super::TickComponent(aDeltaTime, aTickType, aThisTickFunction);
+
+	if (m_State == EReplayState::Recording)
+	{
+		// the controller ticks after this, so the handlers record this frame's input against the sample taken before it
+		m_Frame = m_Replay.m_Trajectory.Num();
+		m_Replay.m_Trajectory.Add(MakeSample());
+		for (const FDeftReplayInputEvent& inputEvent : m_QueuedInputs)
+			DispatchInput(inputEvent);
+		m_QueuedInputs.Reset();
+		return;
+	}
+
+	if (m_State != EReplayState::Playback)
+		return;
+
+	// GGameThreadTime is the previous frame, which is the one that ran the previous replay frame
+	if (m_Frame > 0)
+		m_FrameTimesMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	const FDeftReplaySample sample = MakeSample();
+	const FDeftReplaySample& golden = m_Replay.m_Trajectory[m_Frame];
+	const float deviation = FVector3f::Dist(sample.m_Location, golden.m_Location);
+	if (deviation > m_PlaybackResults.m_MaxDeviation)
+	{
+		m_PlaybackResults.m_MaxDeviation = deviation;
+		m_PlaybackResults.m_MaxDeviationFrame = m_Frame;
+	}
+	if (deviation > m_Tolerance)
+		++m_PlaybackResults.m_FramesOverTolerance;
+
+	if ((int32)m_Frame + 1 >= m_Replay.m_Trajectory.Num())
+	{
+		FinishPlayback();
+		return;
+	}
+
+	bool bMoveDispatched = false;
+	while (m_Replay.m_Events.IsValidIndex(m_NextEvent) && m_Replay.m_Events[m_NextEvent].m_Frame <= m_Frame)
+	{
+		const FDeftReplayInputEvent& inputEvent = m_Replay.m_Events[m_NextEvent++];
+		bMoveDispatched |= inputEvent.m_Input == EDeftReplayInput::Move;
+		DispatchInput(inputEvent);
+	}
+
+	if (!bMoveDispatched && !m_HeldMoveValue.IsZero())
+		DispatchInput({ m_Frame, EDeftReplayInput::Move, m_HeldMoveValue });
+
+	++m_Frame;
+}
+
+void UDeftInputReplayComponent::DispatchInput(const FDeftReplayInputEvent& aEvent)
+{
+	APlayerCharacter* character = Cast<APlayerCharacter>(GetOwner());
+	if (!character)
+		return;
+
+	switch (aEvent.m_Input)
+	{
+		case EDeftReplayInput::JumpPressed:		character->OnJumpPressed(); break;
+		case EDeftReplayInput::JumpReleased:	character->OnJumpReleased(); break;
+		case EDeftReplayInput::AirDash:			character->AirDash(); break;
+		case EDeftReplayInput::Look:			character->Look(FInputActionValue(FVector2D(aEvent.m_Value))); break;
+		case EDeftReplayInput::Move:
+			m_HeldMoveValue = aEvent.m_Value;
+			character->Move(FInputActionValue(FVector2D(aEvent.m_Value)));
+			break;
+	}
+}
+
+void UDeftInputReplayComponent::FinishPlayback()
+{
+	m_FrameTimesMs.Sort();
+	float averageMs = 0.f;
+	for (const float frameTimeMs : m_FrameTimesMs)
+		averageMs += frameTimeMs;
+	averageMs /= FMath::Max(m_FrameTimesMs.Num(), 1);
+	const float p95Ms = m_FrameTimesMs.Num() > 0 ? m_FrameTimesMs[FMath::Min(m_FrameTimesMs.Num() - 1, (int32)(m_FrameTimesMs.Num() * 0.95f))] : 0.f;
+	const float maxMs = m_FrameTimesMs.Num() > 0 ? m_FrameTimesMs.Last() : 0.f;
+
+	m_PlaybackResults.m_Frames = m_Replay.m_Trajectory.Num();
+	m_bPlaybackFinished = true;
+
+	const bool bPassed = m_PlaybackResults.m_FramesOverTolerance == 0;
+	UE_LOG(LogDeftReplay, Display, TEXT("%s %s: max deviation %.2f cm at frame %u, %u of %d frames over %.2f cm"),
+		*m_ReplayName, bPassed ? TEXT("PASSED") : TEXT("FAILED"), m_PlaybackResults.m_MaxDeviation, m_PlaybackResults.m_MaxDeviationFrame, m_PlaybackResults.m_FramesOverTolerance, m_PlaybackResults.m_Frames, m_Tolerance);
+	UE_LOG(LogDeftReplay, Display, TEXT("%s game thread: avg %.3f ms, p95 %.3f ms, max %.3f ms"), *m_ReplayName, averageMs, p95Ms, maxMs);
+
+	End();
+}
+
+
+#if !UE_BUILD_SHIPPING
+static UDeftInputReplayComponent* FindReplayComponent(UWorld* aWorld)
+{
+	const ACharacter* character = UGameplayStatics::GetPlayerCharacter(aWorld, 0);
+	return character ? character->FindComponentByClass<UDeftInputReplayComponent>() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdReplayRecord(
+	TEXT("d.Replay.Record"),
+	TEXT("records the local player's input and trajectory until d.Replay.Stop. args: <name> [fixedHz=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& aArgs, UWorld* aWorld)
+	{
+		UDeftInputReplayComponent* replay = FindReplayComponent(aWorld);
+		if (replay && aArgs.Num() > 0)
+		{
+			const float fixedHz = aArgs.Num() > 1 ? FMath::Max(1.f, FCString::Atof(*aArgs[1])) : 60.f;
+			replay->StartRecording(aArgs[0], 1.f / fixedHz);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdReplayPlay(
+	TEXT("d.Replay.Play"),
+	TEXT("plays a recording back on the local player and compares against its trajectory. args: <name> [toleranceCm=1]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& aArgs, UWorld* aWorld)
+	{
+		UDeftInputReplayComponent* replay = FindReplayComponent(aWorld);
+		if (replay && aArgs.Num() > 0)
+		{
+			const float tolerance = aArgs.Num() > 1 ? FCString::Atof(*aArgs[1]) : 1.f;
+			replay->StartPlayback(aArgs[0], tolerance);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdReplayStop(
+	TEXT("d.Replay.Stop"),
+	TEXT("saves the current recording or abandons the current playback"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* aWorld)
+	{
+		if (UDeftInputReplayComponent* replay = FindReplayComponent(aWorld))
+			replay->Stop();
+	}));
+#endif
@@ -6,6 +6,9 @@
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
 #include "DeftLocks.h"
+#include "DeftDebugOverlay.h"
+#include "Character/DeftInputReplayComponent.h"
+#include "GameFramework/ForceFeedbackEffect.h"
 
 // DEBUG VISUALIZATION
 static TAutoConsoleVariable<bool> CVarDebugInput(TEXT("d.DebugInput"), false, TEXT("shows debug info for input"));
@@ -19,6 +22,7 @@ APlayerCharacter::APlayerCharacter(const FObjectInitializer& aObjectInitializer)
 
 	SpringArmComp = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArmComp"));
 	CameraComp = CreateDefaultSubobject<UCameraComponent>(TEXT("CameraComp"));
+	InputReplayComp = CreateDefaultSubobject<UDeftInputReplayComponent>(TEXT("InputReplayComp"));
 
 	// Set the location and rotation of the character mesh transform
 	if (USkeletalMeshComponent* skeletalMesh = GetMesh())
@@ -51,7 +55,19 @@ void APlayerCharacter::BeginPlay()
 
 	if (UDeftMovementComponent* deftCharacterMovementComponent = Cast<UDeftMovementComponent>(GetCharacterMovement()))
 	{
-		// landed from air callback
+		deftCharacterMovementComponent->OnMovementEvent().AddUObject(this, &APlayerCharacter::OnMovementEvent);
+	}
+}
+
+void APlayerCharacter::OnMovementEvent(UDeftMovementComponent* aMovement, EDeftMovementEvent aEvent)
+{
+	if (aEvent == EDeftMovementEvent::LedgeUpStarted && aMovement->GetLedgeUpFeedback() && IsLocallyControlled())
+	{
+		if (APlayerController* playerController = Cast<APlayerController>(Controller))
+		{
+			FForceFeedbackParameters feedbackParams;
+			playerController->ClientPlayForceFeedback(aMovement->GetLedgeUpFeedback(), feedbackParams);
+		}
 	}
 }
 
@@ -59,6 +75,8 @@ void APlayerCharacter::BeginPlay()
 void APlayerCharacter::Move(const FInputActionValue& aValue)
 {
 	FVector2D inputVector = aValue.Get<FVector2D>();
+	if (InputReplayComp->IsRecording())
+		InputReplayComp->RecordInput(EDeftReplayInput::Move, inputVector);
 #if DEBUG_VIEW
 	m_MoveInputVector = inputVector;
 #endif
@@ -70,10 +88,14 @@ void APlayerCharacter::Move(const FInputActionValue& aValue)
 		const FRotator rotation = Controller->GetControlRotation();
 		const FRotator yawRotation(0, rotation.Yaw, 0);
 
+		const UDeftMovementComponent* deftCharacterMovementComponent = Cast<UDeftMovementComponent>(GetCharacterMovement());
+		const bool bForwardBackLocked = deftCharacterMovementComponent && deftCharacterMovementComponent->GetDeftLocks().IsMoveInputForwardBackLocked();
+		const bool bRightLeftLocked = deftCharacterMovementComponent && deftCharacterMovementComponent->GetDeftLocks().IsMoveInputRightLeftLocked();
+
 		// get forward vector
 		// note: is there a benefit from getting forward form the rotation and not just ActorForwardVector?
-		const FVector forwardDir = DeftLocks::IsMoveInputForwardBackLocked() ? FVector::ZeroVector : FRotationMatrix(yawRotation).GetUnitAxis(EAxis::X);
-		const FVector rightDir = DeftLocks::IsMoveInputRightLeftLocked() ? FVector::ZeroVector : FRotationMatrix(yawRotation).GetUnitAxis(EAxis::Y);
+		const FVector forwardDir = bForwardBackLocked ? FVector::ZeroVector : FRotationMatrix(yawRotation).GetUnitAxis(EAxis::X);
+		const FVector rightDir = bRightLeftLocked ? FVector::ZeroVector : FRotationMatrix(yawRotation).GetUnitAxis(EAxis::Y);
 
 		AddMovementInput(forwardDir, inputVector.Y);
 		AddMovementInput(rightDir, inputVector.X);
@@ -84,6 +106,8 @@ void APlayerCharacter::Move(const FInputActionValue& aValue)
 void APlayerCharacter::Look(const FInputActionValue& aValue)
 {
 	FVector2D inputVector = aValue.Get<FVector2D>();
+	if (InputReplayComp->IsRecording())
+		InputReplayComp->RecordInput(EDeftReplayInput::Look, inputVector);
 
 	if (Controller)
 	{
@@ -95,6 +119,8 @@ void APlayerCharacter::Look(const FInputActionValue& aValue)
 
 void APlayerCharacter::OnJumpPressed()
 {
+	if (InputReplayComp->IsRecording())
+		InputReplayComp->RecordInput(EDeftReplayInput::JumpPressed);
 	Jump();
 	if (UDeftMovementComponent* deftCharacterMovementComponent = Cast<UDeftMovementComponent>(GetCharacterMovement()))
 	{
@@ -104,6 +130,8 @@ void APlayerCharacter::OnJumpPressed()
 
 void APlayerCharacter::OnJumpReleased()
 {
+	if (InputReplayComp->IsRecording())
+		InputReplayComp->RecordInput(EDeftReplayInput::JumpReleased);
 	// TODO: obviously change to be _my_ jump
 	if (UDeftMovementComponent* deftCharacterMovementComponent = Cast<UDeftMovementComponent>(GetCharacterMovement()))
 	{
@@ -113,6 +141,8 @@ void APlayerCharacter::OnJumpReleased()
 
 void APlayerCharacter::AirDash()
 {
+	if (InputReplayComp->IsRecording())
+		InputReplayComp->RecordInput(EDeftReplayInput::AirDash);
 	if (UDeftMovementComponent* deftCharacterMovementComponent = Cast<UDeftMovementComponent>(GetCharacterMovement()))
 	{
 		deftCharacterMovementComponent->OnAirDash(); // tell the movement component to stop counting the time
@@ -124,7 +154,8 @@ void APlayerCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 #if DEBUG_VIEW
-	DrawDebug();
+	if (DeftDebugOverlay::IsEnabled())
+		DrawDebug();
 #endif
 }
 
@@ -162,7 +193,9 @@ void APlayerCharacter::DrawDebug()
 {
 	if (CVarDebugInput.GetValueOnGameThread())
 	{
-		GEngine->AddOnScreenDebugMessage(-1, 0.01f, FColor::Yellow, FString::Printf(TEXT("Forward/Back: %2.f\nRight/Left: %.2f"), m_MoveInputVector.Y, m_MoveInputVector.X));
+		DeftDebugOverlay::AddHeader(TEXT("-Input-"), FColor::Yellow);
+		DeftDebugOverlay::AddFloat(TEXT("Forward/Back"), m_MoveInputVector.Y, FColor::Yellow);
+		DeftDebugOverlay::AddFloat(TEXT("Right/Left"), m_MoveInputVector.X, FColor::Yellow);
 	}
 }
 #endif
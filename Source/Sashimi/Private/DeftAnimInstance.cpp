@@ -0,0 +1,71 @@
+#include "DeftAnimInstance.h"
+#include "GameFramework/Character.h"
+
+static_assert((int32)EDeftMovementEvent::COUNT <= 16, "FDeftAnimMovementState::m_Events has a bit per EDeftMovementEvent");
+
+void FDeftAnimInstanceProxy::PreUpdate(UAnimInstance* aInstance, float aDeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(aInstance, aDeltaSeconds);
+
+	UDeftAnimInstance* animInstance = CastChecked<UDeftAnimInstance>(aInstance);
+	if (const UDeftMovementComponent* movement = animInstance->m_Movement.Get())
+		movement->FillAnimState(m_MovementState);
+
+	m_MovementState.m_Events = animInstance->m_PendingEvents;
+	animInstance->m_PendingEvents = 0;
+}
+
+
+void UDeftAnimInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	const ACharacter* character = Cast<ACharacter>(TryGetPawnOwner());
+	UDeftMovementComponent* movement = character ? Cast<UDeftMovementComponent>(character->GetCharacterMovement()) : nullptr;
+	if (movement != m_Movement.Get())
+	{
+		if (UDeftMovementComponent* previousMovement = m_Movement.Get())
+			previousMovement->OnMovementEvent().Remove(m_MovementEventHandle);
+		m_MovementEventHandle.Reset();
+		if (movement)
+			m_MovementEventHandle = movement->OnMovementEvent().AddUObject(this, &UDeftAnimInstance::OnMovementEvent);
+		m_Movement = movement;
+	}
+}
+
+void UDeftAnimInstance::NativeUninitializeAnimation()
+{
+	if (UDeftMovementComponent* movement = m_Movement.Get())
+		movement->OnMovementEvent().Remove(m_MovementEventHandle);
+	m_MovementEventHandle.Reset();
+	m_Movement.Reset();
+
+	Super::NativeUninitializeAnimation();
+}
+
+void UDeftAnimInstance::NativeThreadSafeUpdateAnimation(float aDeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(aDeltaSeconds);
+
+	MovementState = GetProxyOnAnyThread<FDeftAnimInstanceProxy>().GetMovementState();
+}
+
+FAnimInstanceProxy* UDeftAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FDeftAnimInstanceProxy(this);
+}
+
+void UDeftAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* aProxy)
+{
+	delete static_cast<FDeftAnimInstanceProxy*>(aProxy);
+}
+
+bool UDeftAnimInstance::WasMovementEventRaised(EDeftMovementEvent aEvent) const
+{
+	return (MovementState.m_Events & (1 << (int32)aEvent)) != 0;
+}
+
+void UDeftAnimInstance::OnMovementEvent(UDeftMovementComponent* aMovement, EDeftMovementEvent aEvent)
+{
+	m_PendingEvents |= (uint16)(1 << (int32)aEvent);
+}
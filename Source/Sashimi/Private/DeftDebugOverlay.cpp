@@ -0,0 +1,117 @@
+#include "DeftDebugOverlay.h"
+
+#if DEBUG_VIEW
+#include "Debug/DebugDrawService.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+
+DeftDebugOverlay::Entry DeftDebugOverlay::m_Entries[DeftDebugOverlay::Capacity];
+uint32 DeftDebugOverlay::m_Head = 0;
+uint64 DeftDebugOverlay::m_Frame = 0;
+bool DeftDebugOverlay::m_bEnabled = false;
+FDelegateHandle DeftDebugOverlay::m_DrawHandle;
+FAutoConsoleVariableRef DeftDebugOverlay::m_CVarEnabled(
+	TEXT("d.DebugOverlay"),
+	DeftDebugOverlay::m_bEnabled,
+	TEXT("shows the deft debug text overlay, the d.Debug* sections only draw while this is on"),
+	FConsoleVariableDelegate::CreateStatic(&DeftDebugOverlay::OnEnabledChanged));
+
+void DeftDebugOverlay::AddHeader(const TCHAR* aLabel, FColor aColor)
+{
+	AddEntry(aLabel, aColor, EValueType::Header);
+}
+
+void DeftDebugOverlay::AddText(const TCHAR* aLabel, const TCHAR* aText, FColor aColor)
+{
+	AddEntry(aLabel, aColor, EValueType::Text).m_Text = aText;
+}
+
+void DeftDebugOverlay::AddBool(const TCHAR* aLabel, bool aValue, FColor aColor)
+{
+	AddEntry(aLabel, aColor, EValueType::Bool).m_Bool = aValue;
+}
+
+void DeftDebugOverlay::AddInt(const TCHAR* aLabel, int32 aValue, FColor aColor)
+{
+	AddEntry(aLabel, aColor, EValueType::Int).m_Int = aValue;
+}
+
+void DeftDebugOverlay::AddFloat(const TCHAR* aLabel, float aValue, FColor aColor)
+{
+	AddEntry(aLabel, aColor, EValueType::Float).m_Float = aValue;
+}
+
+void DeftDebugOverlay::AddVector(const TCHAR* aLabel, const FVector& aValue, FColor aColor)
+{
+	Entry& entry = AddEntry(aLabel, aColor, EValueType::Vector);
+	entry.m_Vector[0] = (float)aValue.X;
+	entry.m_Vector[1] = (float)aValue.Y;
+	entry.m_Vector[2] = (float)aValue.Z;
+}
+
+DeftDebugOverlay::Entry& DeftDebugOverlay::AddEntry(const TCHAR* aLabel, FColor aColor, EValueType aType)
+{
+	check(IsInGameThread());
+	// the first line of a new frame starts the buffer over, every viewport draws the same frame's lines
+	if (m_Frame != GFrameCounter)
+	{
+		m_Frame = GFrameCounter;
+		m_Head = 0;
+	}
+	Entry& entry = m_Entries[m_Head % Capacity];
+	++m_Head;
+	entry.m_Label = aLabel;
+	entry.m_Color = aColor;
+	entry.m_Type = aType;
+	return entry;
+}
+
+void DeftDebugOverlay::OnEnabledChanged(IConsoleVariable* aVariable)
+{
+	if (m_bEnabled && !m_DrawHandle.IsValid())
+	{
+		m_DrawHandle = UDebugDrawService::Register(TEXT("Game"), FDebugDrawDelegate::CreateStatic(&DeftDebugOverlay::Draw));
+	}
+	else if (!m_bEnabled && m_DrawHandle.IsValid())
+	{
+		UDebugDrawService::Unregister(m_DrawHandle);
+		m_DrawHandle.Reset();
+	}
+}
+
+void DeftDebugOverlay::Draw(UCanvas* aCanvas, APlayerController* aPlayerController)
+{
+	// nothing recorded this frame, whatever is left in the buffer is stale
+	if (m_Frame != GFrameCounter)
+		return;
+
+	const UFont* font = GEngine->GetSmallFont();
+	const float lineHeight = font->GetMaxCharHeight();
+	const float indent = 16.f;
+	float y = 50.f;
+
+	const uint32 count = FMath::Min(m_Head, (uint32)Capacity);
+	for (uint32 i = m_Head - count; i < m_Head; ++i)
+	{
+		const Entry& entry = m_Entries[i % Capacity];
+
+		FString line;
+		switch (entry.m_Type)
+		{
+			case EValueType::Header:	line = entry.m_Label; break;
+			case EValueType::Text:		line = FString::Printf(TEXT("%s: %s"), entry.m_Label, entry.m_Text); break;
+			case EValueType::Bool:		line = FString::Printf(TEXT("%s: %d"), entry.m_Label, (int32)entry.m_Bool); break;
+			case EValueType::Int:		line = FString::Printf(TEXT("%s: %d"), entry.m_Label, entry.m_Int); break;
+			case EValueType::Float:		line = FString::Printf(TEXT("%s: %.2f"), entry.m_Label, entry.m_Float); break;
+			case EValueType::Vector:	line = FString::Printf(TEXT("%s: X=%.2f Y=%.2f Z=%.2f"), entry.m_Label, entry.m_Vector[0], entry.m_Vector[1], entry.m_Vector[2]); break;
+		}
+
+		if (entry.m_Type == EValueType::Header)
+			y += lineHeight * 0.5f;
+
+		aCanvas->SetDrawColor(entry.m_Color);
+		aCanvas->DrawText(font, line, entry.m_Type == EValueType::Header ? 10.f : 10.f + indent, y);
+		y += lineHeight;
+	}
+}
+#endif//DEBUG_VIEW
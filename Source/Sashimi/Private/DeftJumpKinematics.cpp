@@ -0,0 +1,198 @@
+#include "DeftJumpKinematics.h"
+#include "Sashimi/Sashimi.h"
+
+float DeftJumpKinematics::SimulateApexHeight(float aVelocityZ, float aGravityZ, float aTimeStep)
+{
+	float height = 0.f;
+	float apex = 0.f;
+	float velocityZ = aVelocityZ;
+	while (velocityZ > 0.f)
+	{
+		const float newVelocityZ = velocityZ + aGravityZ * aTimeStep;
+		height += 0.5f * (velocityZ + newVelocityZ) * aTimeStep;
+		apex = FMath::Max(apex, height);
+		velocityZ = newVelocityZ;
+	}
+	return apex;
+}
+
+
+namespace
+{
+	constexpr int32 BatchWidth = 4;
+}
+
+void DeftJumpKinematicsBatch::CalculateInitialVelocityZ(const float* aTime, const float* aHeight, float* outVelocityZ, int32 aNum)
+{
+	const VectorRegister4Float two = VectorSetFloat1(2.f);
+	int32 i = 0;
+	for (; i + BatchWidth <= aNum; i += BatchWidth)
+	{
+		const VectorRegister4Float velocityZ = VectorDivide(VectorMultiply(two, VectorLoad(aHeight + i)), VectorLoad(aTime + i));
+		VectorStore(velocityZ, outVelocityZ + i);
+	}
+	for (; i < aNum; ++i)
+		outVelocityZ[i] = DeftJumpKinematics::CalculateInitialVelocityZ(aTime[i], aHeight[i]);
+}
+
+void DeftJumpKinematicsBatch::CalculateGravityScale(const float* aTime, const float* aHeight, float aDefaultGravityZ, float* outGravityScale, int32 aNum)
+{
+	const VectorRegister4Float minusTwo = VectorSetFloat1(-2.f);
+	const VectorRegister4Float defaultGravityZ = VectorSetFloat1(aDefaultGravityZ);
+	int32 i = 0;
+	for (; i + BatchWidth <= aNum; i += BatchWidth)
+	{
+		const VectorRegister4Float time = VectorLoad(aTime + i);
+		const VectorRegister4Float gravityZ = VectorDivide(VectorMultiply(minusTwo, VectorLoad(aHeight + i)), VectorMultiply(time, time));
+		VectorStore(VectorDivide(gravityZ, defaultGravityZ), outGravityScale + i);
+	}
+	for (; i < aNum; ++i)
+		outGravityScale[i] = DeftJumpKinematics::CalculateGravityScale(aTime[i], aHeight[i], aDefaultGravityZ);
+}
+
+void DeftJumpKinematicsBatch::CalculateHoldTimeGravityScale(const float* aHoldTime, const float* aMaxHoldTime, const float* aMaxPreJumpScale, const float* aMinPreJumpScale, float* outGravityScale, int32 aNum)
+{
+	const VectorRegister4Float zero = VectorZeroFloat();
+	const VectorRegister4Float one = VectorOneFloat();
+	int32 i = 0;
+	for (; i + BatchWidth <= aNum; i += BatchWidth)
+	{
+		const VectorRegister4Float val = VectorMin(VectorMax(VectorDivide(VectorLoad(aHoldTime + i), VectorLoad(aMaxHoldTime + i)), zero), one);
+		const VectorRegister4Float minPreJump = VectorLoad(aMinPreJumpScale + i);
+		VectorStore(VectorMultiplyAdd(val, VectorSubtract(VectorLoad(aMaxPreJumpScale + i), minPreJump), minPreJump), outGravityScale + i);
+	}
+	for (; i < aNum; ++i)
+		outGravityScale[i] = DeftJumpKinematics::CalculateHoldTimeGravityScale(aHoldTime[i], aMaxHoldTime[i], { aMaxPreJumpScale[i], aMinPreJumpScale[i], 0.f });
+}
+
+void DeftJumpKinematicsBatch::ApplyForwardBoost(float* ioVelocityX, float* ioVelocityY, const float* aForwardX, const float* aForwardY, const float* aBoost, const float* aDeltaTime, int32 aNum)
+{
+	int32 i = 0;
+	for (; i + BatchWidth <= aNum; i += BatchWidth)
+	{
+		const VectorRegister4Float boost = VectorMultiply(VectorLoad(aBoost + i), VectorLoad(aDeltaTime + i));
+		VectorStore(VectorMultiplyAdd(VectorLoad(aForwardX + i), boost, VectorLoad(ioVelocityX + i)), ioVelocityX + i);
+		VectorStore(VectorMultiplyAdd(VectorLoad(aForwardY + i), boost, VectorLoad(ioVelocityY + i)), ioVelocityY + i);
+	}
+	for (; i < aNum; ++i)
+	{
+		const float boost = aBoost[i] * aDeltaTime[i];
+		ioVelocityX[i] += aForwardX[i] * boost;
+		ioVelocityY[i] += aForwardY[i] * boost;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	FDeftJumpTuning MakeBenchmarkTuning()
+	{
+		FDeftJumpTuning tuning;
+		tuning.m_JumpMaxHeight = 250.f;
+		tuning.m_TimeToJumpMaxHeight = 0.45f;
+		tuning.m_JumpMinHeight = 100.f;
+		tuning.m_PostTimeToJumpMaxHeight = 0.3f;
+		tuning.m_JumpKeyMaxHoldTime = 0.2f;
+		tuning.m_AirDashDistance = 500.f;
+		tuning.m_AirDashTime = 0.25f;
+		tuning.m_AirDashVerticalHeight = 20.f;
+		tuning.m_DefaultGravityZ = -980.f;
+		return tuning;
+	}
+}
+
+static FAutoConsoleCommand CmdJumpKinematicsBenchmark(
+	TEXT("d.Jump.BenchmarkKinematics"),
+	TEXT("times the per-jump kinematics setup, apex accuracy is covered by the Sashimi.Movement.JumpKinematics automation spec. args: [iterations=1000000]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& aArgs)
+	{
+		const int32 iterations = aArgs.Num() > 0 ? FMath::Max(1, FCString::Atoi(*aArgs[0])) : 1000000;
+		const FDeftJumpTuning tuning = MakeBenchmarkTuning();
+		const FDeftJumpGravityScales scales = DeftJumpKinematics::CalculateGravityScales(tuning);
+
+		// one "jump setup" is everything the component evaluates between pressing jump and the dash: launch, release and dash
+		float sink = 0.f;
+		const uint64 start = FPlatformTime::Cycles64();
+		for (int32 i = 0; i < iterations; ++i)
+		{
+			const FDeftJumpLaunch launch = DeftJumpKinematics::CalculateJumpLaunch(tuning, (uint8)(1 + (i & 1)));
+			const float releaseScale = DeftJumpKinematics::CalculateHoldTimeGravityScale((i & 255) * (1.f / 1024.f), tuning.m_JumpKeyMaxHoldTime, scales);
+			const FDeftAirDashLaunch dash = DeftJumpKinematics::CalculateAirDashLaunch(tuning, FVector::ForwardVector);
+			sink += launch.m_VelocityZ + launch.m_GravityScale + releaseScale + dash.m_Velocity.X;
+		}
+		const double elapsedMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - start);
+		UE_LOG(LogTemp, Display, TEXT("JumpKinematics benchmark: %d jump setups in %.3f ms, %.2f ns/setup (sink %.1f)"), iterations, elapsedMs, elapsedMs * 1e6 / iterations, sink);
+	}));
+
+static FAutoConsoleCommand CmdJumpKinematicsBatchBenchmark(
+	TEXT("d.Jump.BenchmarkBatchKinematics"),
+	TEXT("times the scalar jump kinematics against the DeftJumpKinematicsBatch vector kernel for 1 to 1000 characters and logs the largest difference between them, agreement is asserted by the Sashimi.Movement.JumpKinematics automation spec. args: [evaluations per size=1000000]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& aArgs)
+	{
+		const int32 evaluations = aArgs.Num() > 0 ? FMath::Max(1, FCString::Atoi(*aArgs[0])) : 1000000;
+		const FDeftJumpTuning tuning = MakeBenchmarkTuning();
+
+		// structure of arrays, one entry per character, filled with plausible spread out tuning
+		TArray<float> time, height, holdTime, maxHoldTime, maxPreJump, minPreJump, velocityX, velocityY, forwardX, forwardY, boost, deltaTime;
+		TArray<float> scalarVelocityZ, scalarGravityScale, scalarHoldScale, batchVelocityZ, batchGravityScale, batchHoldScale;
+		const int32 sizes[] = { 1, 4, 10, 100, 1000 };
+		for (const int32 size : sizes)
+		{
+			FRandomStream random(size);
+			for (TArray<float>* array : { &time, &height, &holdTime, &maxHoldTime, &maxPreJump, &minPreJump, &velocityX, &velocityY, &forwardX, &forwardY, &boost, &deltaTime, &scalarVelocityZ, &scalarGravityScale, &scalarHoldScale, &batchVelocityZ, &batchGravityScale, &batchHoldScale })
+				array->SetNumZeroed(size);
+			for (int32 i = 0; i < size; ++i)
+			{
+				time[i] = random.FRandRange(0.2f, 0.6f);
+				height[i] = random.FRandRange(50.f, 300.f);
+				holdTime[i] = random.FRandRange(0.f, 0.3f);
+				maxHoldTime[i] = tuning.m_JumpKeyMaxHoldTime;
+				maxPreJump[i] = random.FRandRange(1.f, 2.f);
+				minPreJump[i] = maxPreJump[i] + random.FRandRange(0.5f, 1.5f);
+				const float yaw = random.FRandRange(0.f, 2.f * UE_PI);
+				forwardX[i] = FMath::Cos(yaw);
+				forwardY[i] = FMath::Sin(yaw);
+				boost[i] = random.FRandRange(0.f, 600.f);
+				deltaTime[i] = 1.f / 60.f;
+			}
+
+			const int32 repeats = FMath::Max(1, evaluations / size);
+			const uint64 scalarStart = FPlatformTime::Cycles64();
+			for (int32 repeat = 0; repeat < repeats; ++repeat)
+			{
+				for (int32 i = 0; i < size; ++i)
+				{
+					scalarVelocityZ[i] = DeftJumpKinematics::CalculateInitialVelocityZ(time[i], height[i]);
+					scalarGravityScale[i] = DeftJumpKinematics::CalculateGravityScale(time[i], height[i], tuning.m_DefaultGravityZ);
+					scalarHoldScale[i] = DeftJumpKinematics::CalculateHoldTimeGravityScale(holdTime[i], maxHoldTime[i], { maxPreJump[i], minPreJump[i], 0.f });
+					const float frameBoost = boost[i] * deltaTime[i];
+					velocityX[i] += forwardX[i] * frameBoost;
+					velocityY[i] += forwardY[i] * frameBoost;
+				}
+			}
+			const double scalarMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - scalarStart);
+
+			const uint64 batchStart = FPlatformTime::Cycles64();
+			for (int32 repeat = 0; repeat < repeats; ++repeat)
+			{
+				DeftJumpKinematicsBatch::CalculateInitialVelocityZ(time.GetData(), height.GetData(), batchVelocityZ.GetData(), size);
+				DeftJumpKinematicsBatch::CalculateGravityScale(time.GetData(), height.GetData(), tuning.m_DefaultGravityZ, batchGravityScale.GetData(), size);
+				DeftJumpKinematicsBatch::CalculateHoldTimeGravityScale(holdTime.GetData(), maxHoldTime.GetData(), maxPreJump.GetData(), minPreJump.GetData(), batchHoldScale.GetData(), size);
+				DeftJumpKinematicsBatch::ApplyForwardBoost(velocityX.GetData(), velocityY.GetData(), forwardX.GetData(), forwardY.GetData(), boost.GetData(), deltaTime.GetData(), size);
+			}
+			const double batchMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - batchStart);
+
+			float maxError = 0.f;
+			for (int32 i = 0; i < size; ++i)
+			{
+				maxError = FMath::Max(maxError, FMath::Abs(scalarVelocityZ[i] - batchVelocityZ[i]) / FMath::Max(FMath::Abs(scalarVelocityZ[i]), 1.f));
+				maxError = FMath::Max(maxError, FMath::Abs(scalarGravityScale[i] - batchGravityScale[i]) / FMath::Max(FMath::Abs(scalarGravityScale[i]), 1.f));
+				maxError = FMath::Max(maxError, FMath::Abs(scalarHoldScale[i] - batchHoldScale[i]) / FMath::Max(FMath::Abs(scalarHoldScale[i]), 1.f));
+			}
+
+			const double characterEvaluations = (double)repeats * size;
+			UE_LOG(LogTemp, Display, TEXT("JumpKinematics batch: %4d characters: scalar %.2f ns/character, vector %.2f ns/character, speedup %.2fx, max relative difference %g (sink %.1f)"),
+				size, scalarMs * 1e6 / characterEvaluations, batchMs * 1e6 / characterEvaluations, batchMs > 0.0 ? scalarMs / batchMs : 0.0, maxError, velocityX[0] + velocityY[size - 1]);
+		}
+	}));
+#endif
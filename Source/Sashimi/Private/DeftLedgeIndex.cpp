@@ -0,0 +1,420 @@
+#include "DeftLedgeIndex.h"
+#include "DeftLedgeIndexSubsystem.h"
+#include "DeftMovementComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "DrawDebugHelpers.h"
+#include "EngineUtils.h"
+#include "Serialization/CustomVersion.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+const FGuid FDeftLedgeIndexVersion::GUID(0xA3AB6F6C, 0xC6AA4F8E, 0xB82B2822, 0x40F6CE67);
+static FCustomVersionRegistration GRegisterDeftLedgeIndexVersion(FDeftLedgeIndexVersion::GUID, FDeftLedgeIndexVersion::LatestVersion, TEXT("DeftLedgeIndex"));
+
+namespace DeftLedgeIndex
+{
+	// the probe's forward has to be within 60 degrees of facing the wall, same as a wall ray that can still reach it
+	static constexpr float FacingCos = 0.5f;
+
+	static const FVector2D ApproachDirections[] = { FVector2D(1.f, 0.f), FVector2D(-1.f, 0.f), FVector2D(0.f, 1.f), FVector2D(0.f, -1.f) };
+}
+
+ADeftLedgeIndexActor::ADeftLedgeIndexActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	IndexBounds = CreateDefaultSubobject<UBoxComponent>(TEXT("IndexBounds"));
+	IndexBounds->SetBoxExtent(FVector(1600.f, 1600.f, 800.f));
+	IndexBounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	IndexBounds->SetMobility(EComponentMobility::Static);
+	RootComponent = IndexBounds;
+}
+
+void ADeftLedgeIndexActor::Serialize(FArchive& Ar)
+{
+	Ar.UsingCustomVersion(FDeftLedgeIndexVersion::GUID);
+	Super::Serialize(Ar);
+
+	const int32 version = Ar.CustomVer(FDeftLedgeIndexVersion::GUID);
+	if (Ar.IsLoading() && version < FDeftLedgeIndexVersion::VersionedBlob)
+	{
+		SerializeIndex(Ar, FDeftLedgeIndexVersion::BeforeCustomVersionWasAdded);
+		return;
+	}
+
+	TArray<uint8> blob;
+	if (Ar.IsSaving())
+	{
+		FMemoryWriter writer(blob, Ar.IsPersistent());
+		SerializeIndex(writer, FDeftLedgeIndexVersion::LatestVersion);
+	}
+	Ar << blob;
+
+	if (Ar.IsLoading())
+	{
+		if (version < FDeftLedgeIndexVersion::OldestReadableVersion)
+		{
+			UE_LOG(LogDeftLedge, Warning, TEXT("%s: ledge index version %d is no longer supported, re-bake it (d.Ledge.BuildIndex)"), *GetActorNameOrLabel(), version);
+			ResetIndex();
+			return;
+		}
+
+		FMemoryReader reader(blob, Ar.IsPersistent());
+		SerializeIndex(reader, version);
+	}
+}
+
+void ADeftLedgeIndexActor::SerializeIndex(FArchive& Ar, int32 aVersion)
+{
+	// every version so far shares this layout, branch on aVersion here when it changes.
+	// segments are POD so they go out as one contiguous block
+	m_Segments.BulkSerialize(Ar);
+	Ar << m_CellStarts;
+	Ar << m_GridOrigin;
+	Ar << m_GridDims;
+	Ar << m_GridCellSize;
+}
+
+void ADeftLedgeIndexActor::ResetIndex()
+{
+	m_Segments.Reset();
+	m_CellStarts.Reset();
+	m_GridOrigin = FVector2f::ZeroVector;
+	m_GridDims = FIntPoint::ZeroValue;
+	m_GridCellSize = 0.f;
+}
+
+void ADeftLedgeIndexActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UDeftLedgeIndexSubsystem* ledgeIndex = UWorld::GetSubsystem<UDeftLedgeIndexSubsystem>(GetWorld()))
+	{
+		ledgeIndex->RegisterIndex(this);
+	}
+}
+
+void ADeftLedgeIndexActor::EndPlay(const EEndPlayReason::Type aEndPlayReason)
+{
+	// World Partition unloading our cell ends play, from then on ledges here are traced again
+	if (UDeftLedgeIndexSubsystem* ledgeIndex = UWorld::GetSubsystem<UDeftLedgeIndexSubsystem>(GetWorld()))
+	{
+		ledgeIndex->UnregisterIndex(this);
+	}
+
+	Super::EndPlay(aEndPlayReason);
+}
+
+bool ADeftLedgeIndexActor::Covers(const FVector& aLocation) const
+{
+	return m_GridDims.X > 0 && IndexBounds->Bounds.GetBox().IsInsideOrOn(aLocation);
+}
+
+bool ADeftLedgeIndexActor::FindLedge(const FDeftLedgeProbe& aProbe, FDeftLedgeIndexHit& outHit) const
+{
+	if (m_Segments.IsEmpty())
+		return false;
+
+	const FVector2f origin2D(aProbe.m_Origin.X, aProbe.m_Origin.Y);
+	const FVector2f forward2D = FVector2f(aProbe.m_Forward.X, aProbe.m_Forward.Y).GetSafeNormal();
+	const float reach = aProbe.m_WallReach;
+
+	// segments are bucketed by their midpoint and never longer than a cell so one extra cell covers them
+	const int32 minX = FMath::Clamp(FMath::FloorToInt32((origin2D.X - reach - m_GridOrigin.X) / m_GridCellSize) - 1, 0, m_GridDims.X - 1);
+	const int32 maxX = FMath::Clamp(FMath::FloorToInt32((origin2D.X + reach - m_GridOrigin.X) / m_GridCellSize) + 1, 0, m_GridDims.X - 1);
+	const int32 minY = FMath::Clamp(FMath::FloorToInt32((origin2D.Y - reach - m_GridOrigin.Y) / m_GridCellSize) - 1, 0, m_GridDims.Y - 1);
+	const int32 maxY = FMath::Clamp(FMath::FloorToInt32((origin2D.Y + reach - m_GridOrigin.Y) / m_GridCellSize) + 1, 0, m_GridDims.Y - 1);
+
+	// the edge has to sit above the wall ray (so it would hit the wall) and below the space ray (so that one is clear)
+	const float minHeight = aProbe.m_Origin.Z;
+	const float maxHeight = aProbe.m_Origin.Z + aProbe.m_LedgeHeightOrigin;
+
+	const FDeftLedgeSegment* bestSegment = nullptr;
+	float bestDistance = FLT_MAX;
+	float bestAlpha = 0.f;
+
+	for (int32 y = minY; y <= maxY; ++y)
+	{
+		for (int32 x = minX; x <= maxX; ++x)
+		{
+			const int32 cell = GetCellIndex(x, y);
+			for (uint32 i = m_CellStarts[cell]; i < m_CellStarts[cell + 1]; ++i)
+			{
+				const FDeftLedgeSegment& segment = m_Segments[i];
+
+				const FVector2f wallNormal2D(segment.m_WallNormal.X, segment.m_WallNormal.Y);
+				if (FVector2f::DotProduct(forward2D, -wallNormal2D) < DeftLedgeIndex::FacingCos)
+					continue;
+
+				// 2D intersection of the wall ray with the segment
+				const FVector2f segStart(segment.m_Start.X, segment.m_Start.Y);
+				const FVector2f segDir = FVector2f(segment.m_End.X, segment.m_End.Y) - segStart;
+				const float denom = FVector2f::CrossProduct(forward2D, segDir);
+				if (FMath::IsNearlyZero(denom))
+					continue;
+
+				const FVector2f toSegment = segStart - origin2D;
+				const float distance = FVector2f::CrossProduct(toSegment, segDir) / denom;
+				const float alpha = FVector2f::CrossProduct(toSegment, forward2D) / denom;
+				if (distance < 0.f || distance > reach || alpha < 0.f || alpha > 1.f || distance >= bestDistance)
+					continue;
+
+				const float edgeHeight = FMath::Lerp(segment.m_Start.Z, segment.m_End.Z, alpha);
+				if (edgeHeight <= minHeight || edgeHeight > maxHeight)
+					continue;
+
+				bestSegment = &segment;
+				bestDistance = distance;
+				bestAlpha = alpha;
+			}
+		}
+	}
+
+	if (!bestSegment)
+		return false;
+
+	outHit.m_LedgeEdge = FVector(FMath::Lerp(bestSegment->m_Start, bestSegment->m_End, bestAlpha));
+	outHit.m_SurfaceNormal = FVector(bestSegment->m_SurfaceNormal);
+	outHit.m_WallNormal = FVector(bestSegment->m_WallNormal);
+	outHit.m_SegmentStart = FVector(bestSegment->m_Start);
+	outHit.m_SegmentEnd = FVector(bestSegment->m_End);
+	outHit.m_Distance = bestDistance;
+	outHit.m_bCapsuleFits = (bestSegment->m_Flags & LSF_CapsuleFits) != 0;
+
+	// the runtime surface ray would have landed at the end of the space ray, at the height of the edge
+	const FVector forwardFlat = FVector(forward2D.X, forward2D.Y, 0.f);
+	outHit.m_SurfaceLocation = FVector(aProbe.m_Origin.X, aProbe.m_Origin.Y, outHit.m_LedgeEdge.Z) + forwardFlat * FMath::Max(aProbe.m_LedgeHeightForwardReach, bestDistance);
+	return true;
+}
+
+#if WITH_EDITOR
+void ADeftLedgeIndexActor::BuildLedgeIndex()
+{
+	UWorld* world = GetWorld();
+	const ACharacter* characterCDO = CharacterClass ? CharacterClass->GetDefaultObject<ACharacter>() : nullptr;
+	const UDeftMovementComponent* movementCDO = characterCDO ? Cast<UDeftMovementComponent>(characterCDO->GetCharacterMovement()) : nullptr;
+	if (!world || !movementCDO)
+	{
+		UE_LOG(LogDeftLedge, Error, TEXT("%s: needs a CharacterClass using UDeftMovementComponent to bake a ledge index"), *GetActorNameOrLabel());
+		return;
+	}
+
+	const UCapsuleComponent* capsuleCDO = characterCDO->GetCapsuleComponent();
+	const FName profileName = capsuleCDO->GetCollisionProfileName();
+	const FCollisionShape capsuleShape = FCollisionShape::MakeCapsule(capsuleCDO->GetScaledCapsuleRadius(), capsuleCDO->GetScaledCapsuleHalfHeight());
+
+	FDeftLedgeProbe probe;
+	movementCDO->FillLedgeProbeTuning(probe);
+	probe.m_CapsuleHalfHeight = capsuleCDO->GetScaledCapsuleHalfHeight();
+
+	// only static geometry goes in the index, anything movable is still traced at runtime
+	FCollisionQueryParams queryParams(SCENE_QUERY_STAT(DeftLedgeIndexBake), false, this);
+	queryParams.MobilityType = EQueryMobilityType::Static;
+
+	const FBox bounds = IndexBounds->Bounds.GetBox();
+	const int32 samplesX = FMath::Max(1, FMath::CeilToInt32(bounds.GetSize().X / SampleSpacing));
+	const int32 samplesY = FMath::Max(1, FMath::CeilToInt32(bounds.GetSize().Y / SampleSpacing));
+
+	// 1. height field of the top most static surface
+	struct FSurfaceSample
+	{
+		float m_Height = 0.f;
+		bool m_bValid = false;
+	};
+	TArray<FSurfaceSample> surface;
+	surface.SetNum(samplesX * samplesY);
+	for (int32 y = 0; y < samplesY; ++y)
+	{
+		for (int32 x = 0; x < samplesX; ++x)
+		{
+			const FVector top(bounds.Min.X + (x + 0.5f) * SampleSpacing, bounds.Min.Y + (y + 0.5f) * SampleSpacing, bounds.Max.Z);
+			FHitResult hit;
+			if (world->LineTraceSingleByProfile(hit, top, FVector(top.X, top.Y, bounds.Min.Z), profileName, queryParams))
+			{
+				surface[y * samplesX + x] = { (float)hit.Location.Z, true };
+			}
+		}
+	}
+
+	// 2. anywhere the surface drops away is a ledge candidate, validate it with the same checks the character runs
+	struct FEdgeSample
+	{
+		FVector m_Edge;
+		FVector m_SurfaceNormal;
+		FVector m_WallNormal;
+		bool m_bCapsuleFits = false;
+		bool m_bValid = false;
+	};
+	const int32 numDirections = UE_ARRAY_COUNT(DeftLedgeIndex::ApproachDirections);
+	TArray<FEdgeSample> edges;
+	edges.SetNum(samplesX * samplesY * numDirections);
+
+	const float minDrop = probe.m_LedgeHeightOrigin * 0.5f;
+	for (int32 y = 0; y < samplesY; ++y)
+	{
+		for (int32 x = 0; x < samplesX; ++x)
+		{
+			const FSurfaceSample& sample = surface[y * samplesX + x];
+			if (!sample.m_bValid)
+				continue;
+
+			for (int32 dir = 0; dir < numDirections; ++dir)
+			{
+				const FVector2D& approach = DeftLedgeIndex::ApproachDirections[dir];
+				const int32 nx = x - (int32)approach.X;
+				const int32 ny = y - (int32)approach.Y;
+				const bool bNeighbourValid = nx >= 0 && ny >= 0 && nx < samplesX && ny < samplesY && surface[ny * samplesX + nx].m_bValid;
+				if (bNeighbourValid && surface[ny * samplesX + nx].m_Height > sample.m_Height - minDrop)
+					continue;
+
+				// virtual character in front of the drop, halfway up the window where the runtime check would fire
+				const FVector samplePoint(bounds.Min.X + (x + 0.5f) * SampleSpacing, bounds.Min.Y + (y + 0.5f) * SampleSpacing, sample.m_Height);
+				probe.m_Forward = FVector(approach.X, approach.Y, 0.f);
+				probe.m_Origin = samplePoint - probe.m_Forward * (SampleSpacing + probe.m_WallReach * 0.5f) - probe.m_Up * (probe.m_LedgeHeightOrigin * 0.5f);
+
+				FVector rayStart, rayEnd;
+				FHitResult wallHit, spaceHit, floorHit, clearanceHit;
+
+				probe.GetWallRay(rayStart, rayEnd);
+				if (!world->LineTraceSingleByProfile(wallHit, rayStart, rayEnd, profileName, queryParams))
+					continue;
+
+				probe.GetSpaceRay(rayStart, rayEnd);
+				if (world->LineTraceSingleByProfile(spaceHit, rayStart, rayEnd, profileName, queryParams))
+					continue;
+
+				probe.GetSurfaceRay(rayStart, rayEnd);
+				if (!world->LineTraceSingleByProfile(floorHit, rayStart, rayEnd, profileName, queryParams))
+					continue;
+
+				probe.GetClearanceSweep(floorHit.Location, rayStart, rayEnd);
+				const bool bCapsuleBlocked = world->SweepSingleByProfile(clearanceHit, rayStart, rayEnd, FQuat(probe.m_Forward.Rotation()), profileName, capsuleShape, queryParams);
+
+				FEdgeSample& edge = edges[(y * samplesX + x) * numDirections + dir];
+				edge.m_Edge = FDeftLedgeProbe::GetLedgeEdge(probe.m_Origin, floorHit.Location, floorHit.Normal, wallHit.Location);
+				edge.m_SurfaceNormal = floorHit.Normal;
+				edge.m_WallNormal = wallHit.Normal;
+				edge.m_bCapsuleFits = !bCapsuleBlocked;
+				edge.m_bValid = true;
+			}
+		}
+	}
+
+	// 3. merge neighbouring edge samples running perpendicular to the approach direction into segments
+	TArray<FDeftLedgeSegment> segments;
+	auto emitSegment = [&](const FEdgeSample& aFirst, const FEdgeSample& aLast)
+	{
+		const FVector span = aLast.m_Edge - aFirst.m_Edge;
+		const int32 pieces = FMath::Max(1, FMath::CeilToInt32(span.Size() / GridCellSize));
+		for (int32 i = 0; i < pieces; ++i)
+		{
+			FDeftLedgeSegment& segment = segments.AddDefaulted_GetRef();
+			segment.m_Start = FVector3f(aFirst.m_Edge + span * ((float)i / pieces));
+			segment.m_End = FVector3f(aFirst.m_Edge + span * ((float)(i + 1) / pieces));
+			segment.m_SurfaceNormal = FVector3f(aFirst.m_SurfaceNormal);
+			segment.m_WallNormal = FVector3f(aFirst.m_WallNormal);
+			segment.m_Flags = aFirst.m_bCapsuleFits ? LSF_CapsuleFits : LSF_None;
+		}
+	};
+
+	for (int32 dir = 0; dir < numDirections; ++dir)
+	{
+		// walk along the edge: approaching along X the edge runs along Y and vice versa
+		const bool bRunAlongY = DeftLedgeIndex::ApproachDirections[dir].X != 0.f;
+		const int32 numLines = bRunAlongY ? samplesX : samplesY;
+		const int32 lineLength = bRunAlongY ? samplesY : samplesX;
+		for (int32 line = 0; line < numLines; ++line)
+		{
+			const FEdgeSample* runStart = nullptr;
+			const FEdgeSample* runEnd = nullptr;
+			for (int32 i = 0; i <= lineLength; ++i)
+			{
+				const FEdgeSample* edge = nullptr;
+				if (i < lineLength)
+				{
+					const int32 x = bRunAlongY ? line : i;
+					const int32 y = bRunAlongY ? i : line;
+					edge = &edges[(y * samplesX + x) * numDirections + dir];
+				}
+
+				const bool bContinuesRun = edge && edge->m_bValid && runEnd
+					&& FMath::Abs(edge->m_Edge.Z - runEnd->m_Edge.Z) <= MergeHeightTolerance
+					&& edge->m_bCapsuleFits == runStart->m_bCapsuleFits;
+				if (bContinuesRun)
+				{
+					runEnd = edge;
+					continue;
+				}
+
+				if (runStart)
+					emitSegment(*runStart, *runEnd);
+
+				runStart = (edge && edge->m_bValid) ? edge : nullptr;
+				runEnd = runStart;
+			}
+		}
+	}
+
+	// 4. bucket by midpoint into the lookup grid
+	m_GridCellSize = GridCellSize;
+	m_GridOrigin = FVector2f(bounds.Min.X, bounds.Min.Y);
+	m_GridDims = FIntPoint(FMath::Max(1, FMath::CeilToInt32(bounds.GetSize().X / GridCellSize)), FMath::Max(1, FMath::CeilToInt32(bounds.GetSize().Y / GridCellSize)));
+
+	auto getCell = [this](const FDeftLedgeSegment& aSegment)
+	{
+		const FVector3f mid = (aSegment.m_Start + aSegment.m_End) * 0.5f;
+		const int32 x = FMath::Clamp(FMath::FloorToInt32((mid.X - m_GridOrigin.X) / m_GridCellSize), 0, m_GridDims.X - 1);
+		const int32 y = FMath::Clamp(FMath::FloorToInt32((mid.Y - m_GridOrigin.Y) / m_GridCellSize), 0, m_GridDims.Y - 1);
+		return GetCellIndex(x, y);
+	};
+
+	const int32 numCells = m_GridDims.X * m_GridDims.Y;
+	m_CellStarts.Reset();
+	m_CellStarts.SetNumZeroed(numCells + 1);
+	for (const FDeftLedgeSegment& segment : segments)
+	{
+		++m_CellStarts[getCell(segment) + 1];
+	}
+	for (int32 cell = 0; cell < numCells; ++cell)
+	{
+		m_CellStarts[cell + 1] += m_CellStarts[cell];
+	}
+
+	TArray<uint32> writeCursor(m_CellStarts.GetData(), numCells);
+	m_Segments.SetNumUninitialized(segments.Num());
+	for (const FDeftLedgeSegment& segment : segments)
+	{
+		m_Segments[writeCursor[getCell(segment)]++] = segment;
+	}
+
+	Modify();
+	UE_LOG(LogDeftLedge, Log, TEXT("%s: baked %d ledge segments into %dx%d cells"), *GetActorNameOrLabel(), m_Segments.Num(), m_GridDims.X, m_GridDims.Y);
+}
+
+static FAutoConsoleCommandWithWorld CmdLedgeBuildIndex(
+	TEXT("d.Ledge.BuildIndex"),
+	TEXT("re-bakes every loaded ledge index actor in the world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* aWorld)
+	{
+		for (TActorIterator<ADeftLedgeIndexActor> it(aWorld); it; ++it)
+		{
+			it->BuildLedgeIndex();
+		}
+	}));
+#endif//WITH_EDITOR
+
+#if DEBUG_VIEW
+void ADeftLedgeIndexActor::DrawIndex() const
+{
+	for (const FDeftLedgeSegment& segment : m_Segments)
+	{
+		const FVector start(segment.m_Start);
+		const FVector end(segment.m_End);
+		const FColor color = (segment.m_Flags & LSF_CapsuleFits) ? FColor::Green : FColor::Orange;
+		DrawDebugLine(GetWorld(), start, end, color, false, -1.f, 0, 2.f);
+		DrawDebugLine(GetWorld(), (start + end) * 0.5f, (start + end) * 0.5f + FVector(segment.m_WallNormal) * 20.f, FColor::Blue);
+	}
+}
+#endif
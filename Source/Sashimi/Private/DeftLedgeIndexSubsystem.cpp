@@ -0,0 +1,37 @@
+#include "DeftLedgeIndexSubsystem.h"
+
+void UDeftLedgeIndexSubsystem::RegisterIndex(ADeftLedgeIndexActor* aIndex)
+{
+	m_Indices.AddUnique(aIndex);
+}
+
+void UDeftLedgeIndexSubsystem::UnregisterIndex(ADeftLedgeIndexActor* aIndex)
+{
+	m_Indices.RemoveSwap(aIndex);
+}
+
+bool UDeftLedgeIndexSubsystem::IsCovered(const FVector& aLocation) const
+{
+	for (const ADeftLedgeIndexActor* index : m_Indices)
+	{
+		if (index && index->Covers(aLocation))
+			return true;
+	}
+	return false;
+}
+
+bool UDeftLedgeIndexSubsystem::FindLedge(const FDeftLedgeProbe& aProbe, FDeftLedgeIndexHit& outHit) const
+{
+	// cells can overlap at their borders, take the closest edge out of all of them
+	bool bFound = false;
+	FDeftLedgeIndexHit hit;
+	for (const ADeftLedgeIndexActor* index : m_Indices)
+	{
+		if (index && index->FindLedge(aProbe, hit) && (!bFound || hit.m_Distance < outHit.m_Distance))
+		{
+			outHit = hit;
+			bFound = true;
+		}
+	}
+	return bFound;
+}
@@ -0,0 +1,196 @@
+#include "DeftLedgeLaunchSolver.h"
+#include "Sashimi/Sashimi.h"
+
+// horizontal motion
+// Xf = X0 + V0 * cos(theta) * t
+
+// vertical motion
+// Yf = Y0 + V0 * sin(theta) * t - (1/2gt^2)
+
+// with u = tan(theta), d = Xf - X0 and h = Yf - Y0 the vertical launch speed needed to pass through the target is
+// Vy^2 = (g * d^2 * u^2) / ( 2 * (d * u - h) )
+// which only has a solution for u > h / d.
+
+namespace
+{
+	// t = ( Vy + sqrt(Vy^2 + 2gh) ) / g, same flight time measure the sweep always compared with
+	float FlightTimeFromVerticalSpeed(float aVerticalSpeed, float aVerticalDistance, float aGravity)
+	{
+		const float radicand = (aVerticalSpeed * aVerticalSpeed) + (2 * aGravity * aVerticalDistance);
+		return radicand >= 0.f ? (aVerticalSpeed + FMath::Sqrt(radicand)) / aGravity : FLT_MAX;
+	}
+
+	float VerticalSpeedSquared(float aTanTheta, float aHorizontalDistance, float aVerticalDistance, float aGravity)
+	{
+		return (aGravity * aHorizontalDistance * aHorizontalDistance * aTanTheta * aTanTheta) / (2 * (aHorizontalDistance * aTanTheta - aVerticalDistance));
+	}
+
+	FDeftLedgeLaunchSolution MakeSolution(float aTanTheta, float aVerticalSpeed, float aVerticalDistance, float aGravity)
+	{
+		FDeftLedgeLaunchSolution solution;
+
+		// ensure the projectile clears the ledge
+		// H = ( V0^2 * sin^2(theta) ) / 2g
+		const float maxHeight = (aVerticalSpeed * aVerticalSpeed) / (2 * aGravity);
+		if (maxHeight < aVerticalDistance - UE_KINDA_SMALL_NUMBER)
+			return solution;
+
+		solution.m_VerticalSpeed = aVerticalSpeed;
+		solution.m_HorizontalSpeed = aVerticalSpeed / aTanTheta;
+		solution.m_Speed = FMath::Sqrt(solution.m_HorizontalSpeed * solution.m_HorizontalSpeed + aVerticalSpeed * aVerticalSpeed);
+		solution.m_Angle = FMath::RadiansToDegrees(FMath::Atan(aTanTheta));
+		solution.m_FlightTime = FlightTimeFromVerticalSpeed(aVerticalSpeed, aVerticalDistance, aGravity);
+		solution.m_bValid = solution.m_FlightTime < FLT_MAX;
+		return solution;
+	}
+}
+
+FDeftLedgeLaunchSolution DeftLedgeLaunch::SolveMinFlightTime(float aHorizontalDistance, float aVerticalDistance, float aGravity)
+{
+	// straight up (or no gravity) has no finite angle solution, the sweep couldn't find one either
+	if (aHorizontalDistance <= UE_KINDA_SMALL_NUMBER || aGravity <= UE_KINDA_SMALL_NUMBER)
+		return FDeftLedgeLaunchSolution();
+
+	const float d = aHorizontalDistance;
+	const float h = aVerticalDistance;
+	const float g = aGravity;
+	const float minTan = FMath::Tan(FMath::DegreesToRadians(MinAngle));
+	const float maxTan = FMath::Tan(FMath::DegreesToRadians(MaxAngle));
+
+	// even the steepest angle can't pass through the target
+	if (d * maxTan - h <= UE_KINDA_SMALL_NUMBER)
+		return FDeftLedgeLaunchSolution();
+
+	// Flight time only grows with Vy so the fastest trajectory minimizes Vy^2(u).
+	// d/du [u^2 / (du - h)] = 0  ->  u = 2h / d, the trajectory whose apex is exactly at the target height
+	// (which also makes it the lowest one that satisfies maxHeight >= h). Below the target there's no
+	// interior minimum and the shallowest angle is best.
+	const float optimalTan = FMath::Clamp(2 * h / d, minTan, maxTan);
+	const float optimalVySq = VerticalSpeedSquared(optimalTan, d, h, g);
+	if (optimalVySq <= 0.f)
+		return FDeftLedgeLaunchSolution();
+
+	const float optimalVy = FMath::Sqrt(optimalVySq);
+	const float shortestTime = FlightTimeFromVerticalSpeed(optimalVy, h, g);
+
+	// Tie-break towards the steeper angle: take the steepest angle whose flight time is still within tolerance.
+	// Invert the flight time for Vy:  gT = Vy + sqrt(Vy^2 + 2gh)  ->  Vy = ((gT)^2 - 2gh) / 2gT
+	// then solve Vy^2(u) for the larger root:  u = Vy * (Vy + sqrt(Vy^2 - 2gh)) / (g * d)
+	const float gT = g * (shortestTime + FlightTimeTolerance);
+	const float toleranceVy = ((gT * gT) - (2 * g * h)) / (2 * gT);
+	const float discriminant = (toleranceVy * toleranceVy) - (2 * g * h);
+	if (discriminant >= 0.f)
+	{
+		const float steepestTan = (toleranceVy * (toleranceVy + FMath::Sqrt(discriminant))) / (g * d);
+		if (steepestTan > optimalTan)
+		{
+			const float tieTan = FMath::Min(steepestTan, maxTan);
+			const float tieVySq = VerticalSpeedSquared(tieTan, d, h, g);
+			if (tieVySq > 0.f)
+				return MakeSolution(tieTan, FMath::Sqrt(tieVySq), h, g);
+		}
+	}
+
+	return MakeSolution(optimalTan, optimalVy, h, g);
+}
+
+FDeftLedgeLaunchSolution DeftLedgeLaunch::SolveAngleSweep(float aHorizontalDistance, float aVerticalDistance, float aGravity)
+{
+	FDeftLedgeLaunchSolution best;
+
+	// numerical analysis: loop through angles to find a valid trajectory that clear the min height
+	for (float testAngle = MinAngle; testAngle <= MaxAngle; testAngle += SweepAngleStep)
+	{
+		const float theta = FMath::DegreesToRadians(testAngle);
+
+		// V0^2 = (g * d^2) / ( 2 * cos^2(theta) * (d * tan(theta) - (Yf - Y0)) )
+		const float numerator = aGravity * aHorizontalDistance * aHorizontalDistance;
+		const float denom = 2 * FMath::Cos(theta) * FMath::Cos(theta) * (aHorizontalDistance * FMath::Tan(theta) - aVerticalDistance);
+		if (FMath::IsNearlyEqual(denom, 0.f))
+			continue;
+
+		const float velocitySquared = numerator / denom;
+		if (velocitySquared <= 0.f)
+			continue;
+
+		const float initialVelocity = FMath::Sqrt(velocitySquared);
+		const float maxHeight = (initialVelocity * initialVelocity * FMath::Sin(theta) * FMath::Sin(theta)) / (2 * aGravity);
+		if (maxHeight < aVerticalDistance)
+			continue;
+
+		const float v0SinTheta = initialVelocity * FMath::Sin(theta);
+		const float flightTime = FlightTimeFromVerticalSpeed(v0SinTheta, aVerticalDistance, aGravity);
+
+		// prefer shorter flight times, same flight time prefer larger angle to stay closer to target position
+		const bool bNewBestFound = flightTime < best.m_FlightTime || (FMath::IsNearlyEqual(flightTime, best.m_FlightTime, FlightTimeTolerance) && testAngle > best.m_Angle);
+		if (bNewBestFound)
+		{
+			best.m_Angle = testAngle;
+			best.m_Speed = initialVelocity;
+			best.m_HorizontalSpeed = initialVelocity * FMath::Cos(theta);
+			best.m_VerticalSpeed = v0SinTheta;
+			best.m_FlightTime = flightTime;
+			best.m_bValid = true;
+		}
+	}
+
+	return best;
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CmdLedgeLaunchBenchmark(
+	TEXT("d.Ledge.BenchmarkLaunchSolver"),
+	TEXT("micro-benchmark of the closed form ledge launch solver against the angle sweep. args: [iterations=100000]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& aArgs)
+	{
+		const int32 iterations = aArgs.Num() > 0 ? FMath::Max(1, FCString::Atoi(*aArgs[0])) : 100000;
+		constexpr float gravity = 980.f * 2.f;
+
+		// same inputs for both so only the solvers differ
+		FRandomStream random(0xD3F7);
+		TArray<FVector2f> inputs;
+		inputs.SetNumUninitialized(iterations);
+		for (FVector2f& input : inputs)
+		{
+			input = FVector2f(random.FRandRange(10.f, 150.f), random.FRandRange(0.f, 200.f));
+		}
+
+		// accumulate something from the results so the optimizer can't throw the calls away
+		float sink = 0.f;
+
+		const uint64 closedFormStart = FPlatformTime::Cycles64();
+		for (const FVector2f& input : inputs)
+		{
+			sink += DeftLedgeLaunch::SolveMinFlightTime(input.X, input.Y, gravity).m_FlightTime;
+		}
+		const double closedFormMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - closedFormStart);
+
+		const uint64 sweepStart = FPlatformTime::Cycles64();
+		for (const FVector2f& input : inputs)
+		{
+			sink += DeftLedgeLaunch::SolveAngleSweep(input.X, input.Y, gravity).m_FlightTime;
+		}
+		const double sweepMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - sweepStart);
+
+		// the closed form should never be slower to land than the best grid angle
+		int32 bothValid = 0;
+		int32 closedFormFaster = 0;
+		double flightTimeSaved = 0.0;
+		for (const FVector2f& input : inputs)
+		{
+			const FDeftLedgeLaunchSolution closedForm = DeftLedgeLaunch::SolveMinFlightTime(input.X, input.Y, gravity);
+			const FDeftLedgeLaunchSolution sweep = DeftLedgeLaunch::SolveAngleSweep(input.X, input.Y, gravity);
+			if (closedForm.m_bValid && sweep.m_bValid)
+			{
+				++bothValid;
+				closedFormFaster += closedForm.m_FlightTime <= sweep.m_FlightTime + DeftLedgeLaunch::FlightTimeTolerance ? 1 : 0;
+				flightTimeSaved += sweep.m_FlightTime - closedForm.m_FlightTime;
+			}
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("LedgeLaunch benchmark (%d solves): closed form %.3f ms (%.1f ns/solve), sweep %.3f ms (%.1f ns/solve), speed up x%.2f"),
+			iterations, closedFormMs, closedFormMs * 1e6 / iterations, sweepMs, sweepMs * 1e6 / iterations, closedFormMs > 0.0 ? sweepMs / closedFormMs : 0.0);
+		UE_LOG(LogTemp, Display, TEXT("LedgeLaunch accuracy: %d/%d within tolerance of the sweep, avg flight time saved %.4f s (sink %.1f)"),
+			closedFormFaster, bothValid, bothValid > 0 ? flightTimeSaved / bothValid : 0.0, sink);
+	}));
+#endif
@@ -0,0 +1,46 @@
+#include "DeftLedgeProbe.h"
+
+void FDeftLedgeProbe::GetWallRay(FVector& outStart, FVector& outEnd) const
+{
+	outStart = m_Origin;
+	outEnd = outStart + m_Forward * m_WallReach;
+}
+
+void FDeftLedgeProbe::GetSpaceRay(FVector& outStart, FVector& outEnd) const
+{
+	outStart = m_Origin + m_Up * m_LedgeHeightOrigin;
+	outEnd = outStart + m_Forward * m_LedgeHeightForwardReach;
+}
+
+void FDeftLedgeProbe::GetSurfaceRay(FVector& outStart, FVector& outEnd) const
+{
+	FVector spaceRayStart;
+	GetSpaceRay(spaceRayStart, outStart);
+	outEnd = outStart - m_Up * m_LedgeHeightOrigin * 2; // check for a floor twice as far just to see if we hit something
+}
+
+void FDeftLedgeProbe::GetClearanceSweep(const FVector& aFloorLocation, FVector& outStart, FVector& outEnd) const
+{
+	// shape sweep needs to physically sweep _some_ distance, it can't be exactly the same.
+	const FVector capsuleBase = aFloorLocation + m_Up.GetSafeNormal() * 1.5f;				// start sweep: floor location raised by a tiny amount so we don't collide with the floor
+	const FVector capsuleBaseSlightlyHigher = capsuleBase + m_Up.GetSafeNormal() * 1.5f;	// end sweep: slightly above the start location again just because UE requires it to be different
+
+	// sweep puts the CENTER of the capsule at the start and end locations so we have to raise them by half height to have the BASE be at the start and end height
+	outStart = capsuleBase + m_CapsuleHalfHeight;
+	outEnd = capsuleBaseSlightlyHigher + m_CapsuleHalfHeight;
+}
+
+FVector FDeftLedgeProbe::GetLedgeEdge(const FVector& aViewerLocation, const FVector& aFloorLocation, const FVector& aFloorNormal, const FVector& aWallLocation)
+{
+	// starting from the floor location
+	// find a vector perpendicular to the floor's normal which should give us the surface
+	const FVector dirFloorToPlayer = aViewerLocation - aFloorLocation;
+	const FVector floorUp = aFloorNormal;
+	const FVector floorRight = floorUp.Cross(dirFloorToPlayer);
+	const FVector floorForward = floorRight.Cross(floorUp);
+
+	const FVector dirToWall = aWallLocation - aFloorLocation;
+	const FVector projWallDirOntoFloorSurface = (dirToWall.Dot(floorForward) / floorForward.Dot(floorForward)) * floorForward;
+	const float distToEdge = projWallDirOntoFloorSurface.Length();
+	return aFloorLocation + floorForward.GetSafeNormal() * distToEdge;
+}
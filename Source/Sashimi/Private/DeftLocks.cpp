@@ -1,25 +1,154 @@
 #include "DeftLocks.h"
+#include "DeftMovementComponent.h"
+#include "DeftMovementStats.h"
 
-int8 DeftLocks::m_MoveInputForwardBackLock = 0;
-bool DeftLocks::IsMoveInputForwardBackLocked() { return m_MoveInputForwardBackLock > 0; }
-void DeftLocks::IncrementMoveInputForwardBackLockRef() { ++m_MoveInputForwardBackLock; }
-void DeftLocks::DecrementMoveInputForwardBackLockRef() { m_MoveInputForwardBackLock = FMath::Max((int8)0, --m_MoveInputForwardBackLock); }
+DeftLockHandle::DeftLockHandle(DeftLockHandle&& aOther)
+	: m_Owner(aOther.m_Owner)
+	, m_Locks(aOther.m_Locks)
+	, m_Generation(aOther.m_Generation)
+{
+	aOther.m_Owner = nullptr;
+	aOther.m_Locks = EDeftLock::None;
+}
 
-int8 DeftLocks::m_MoveInputRightLeftLock = 0;
-bool DeftLocks::IsMoveInputRightLeftLocked() { return m_MoveInputRightLeftLock > 0; }
-void DeftLocks::IncrementMoveInputRightLeftockRef() { ++m_MoveInputRightLeftLock; }
-void DeftLocks::DecrementMoveInputRightLeftLockRef() { m_MoveInputRightLeftLock = FMath::Max((int8)0, --m_MoveInputRightLeftLock); }
+DeftLockHandle& DeftLockHandle::operator=(DeftLockHandle&& aOther)
+{
+	if (this != &aOther)
+	{
+		Release();
+		m_Owner = aOther.m_Owner;
+		m_Locks = aOther.m_Locks;
+		m_Generation = aOther.m_Generation;
+		aOther.m_Owner = nullptr;
+		aOther.m_Locks = EDeftLock::None;
+	}
+	return *this;
+}
 
-#if !UE_BUILD_SHIPPING
-void DeftLocks::DrawLockDebug()
+void DeftLockHandle::Release(EDeftLock aLocks)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 0.005f, DeftLocks::IsMoveInputForwardBackLocked() ? FColor::Red : FColor::White, FString::Printf(TEXT("\tMove Input Forward/Back: %u"), m_MoveInputForwardBackLock));
-	GEngine->AddOnScreenDebugMessage(-1, 0.005f, DeftLocks::IsMoveInputRightLeftLocked() ? FColor::Red : FColor::White, FString::Printf(TEXT("\tMove Input Right/Left: %u"), m_MoveInputRightLeftLock));
-	GEngine->AddOnScreenDebugMessage(-1, 0.005f, FColor::White, TEXT("\n-Locks-"));
+	const EDeftLock locksToRelease = m_Locks & aLocks;
+	if (m_Owner && locksToRelease != EDeftLock::None)
+	{
+		m_Owner->Release(locksToRelease, m_Generation);
+	}
+	m_Locks &= ~aLocks;
 }
+
+
+DeftLocks::~DeftLocks()
+{
+	CheckForLeaks(TEXT("destroyed"));
+}
+
+DeftLockHandle DeftLocks::Acquire(EDeftLock aLocks, const TCHAR* aDebugName)
+{
+	uint64 state = m_State.load(std::memory_order_relaxed);
+	uint64 newState;
+	do
+	{
+		newState = state;
+		for (int32 lock = 0; lock < NumLocks; ++lock)
+		{
+			if (EnumHasAnyFlags(aLocks, (EDeftLock)(1 << lock)))
+			{
+				const uint64 shift = lock * CountBits;
+				const uint64 count = (state >> shift) & CountMask;
+				checkf(count < CountMask, TEXT("DeftLocks: lock %d acquired too many times, last by %s"), lock, aDebugName);
+				newState += 1ull << shift;
+			}
+		}
+	} while (!m_State.compare_exchange_weak(state, newState, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	for (int32 lock = 0; lock < NumLocks; ++lock)
+	{
+		if (EnumHasAnyFlags(aLocks, (EDeftLock)(1 << lock)))
+			m_LastAcquiredBy[lock].store(aDebugName, std::memory_order_relaxed);
+	}
+	m_Acquires.fetch_add(1, std::memory_order_relaxed);
+	DeftMovementStats::AddCount(EDeftMovementCounter::LockTransitions);
+
+	return DeftLockHandle(this, aLocks, (uint32)(newState >> GenerationShift));
+}
+
+void DeftLocks::Release(EDeftLock aLocks, uint32 aGeneration)
+{
+	uint64 state = m_State.load(std::memory_order_relaxed);
+	uint64 newState;
+	do
+	{
+		// UnlockAll already dropped this handle's counts, don't take them from whoever acquired since
+		if ((uint32)(state >> GenerationShift) != aGeneration)
+		{
+			m_StaleReleases.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		newState = state;
+		for (int32 lock = 0; lock < NumLocks; ++lock)
+		{
+			const uint64 shift = lock * CountBits;
+			if (EnumHasAnyFlags(aLocks, (EDeftLock)(1 << lock)) && ((state >> shift) & CountMask) > 0)
+				newState -= 1ull << shift;
+		}
+	} while (!m_State.compare_exchange_weak(state, newState, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	m_Releases.fetch_add(1, std::memory_order_relaxed);
+	DeftMovementStats::AddCount(EDeftMovementCounter::LockTransitions);
+}
+
+bool DeftLocks::IsLocked(EDeftLock aLocks) const
+{
+	const uint64 state = m_State.load(std::memory_order_acquire);
+	for (int32 lock = 0; lock < NumLocks; ++lock)
+	{
+		if (EnumHasAnyFlags(aLocks, (EDeftLock)(1 << lock)) && ((state >> (lock * CountBits)) & CountMask) > 0)
+			return true;
+	}
+	return false;
+}
+
+uint8 DeftLocks::GetLockCount(EDeftLock aLock) const
+{
+	const int32 lock = FMath::FloorLog2((uint32)aLock);
+	return (uint8)((m_State.load(std::memory_order_acquire) >> (lock * CountBits)) & CountMask);
+}
+
+bool DeftLocks::CheckForLeaks(const TCHAR* aContext)
+{
+	const uint64 state = m_State.load(std::memory_order_acquire);
+	if ((state & MAX_uint32) == 0)
+		return false;
+
+	for (int32 lock = 0; lock < NumLocks; ++lock)
+	{
+		const uint64 count = (state >> (lock * CountBits)) & CountMask;
+		if (count > 0)
+		{
+			const TCHAR* lastAcquiredBy = m_LastAcquiredBy[lock].load(std::memory_order_relaxed);
+			UE_LOG(LogDeftMovement, Warning, TEXT("DeftLocks: lock %d still held %llu time(s) when %s, last acquired by %s"), lock, count, aContext, lastAcquiredBy ? lastAcquiredBy : TEXT("unknown"));
+		}
+	}
+
+	m_LeaksDetected.fetch_add(1, std::memory_order_relaxed);
+	UnlockAll();
+	return true;
+}
+
 void DeftLocks::UnlockAll()
 {
-	m_MoveInputForwardBackLock = 0;
-	m_MoveInputRightLeftLock = 0;
+	uint64 state = m_State.load(std::memory_order_relaxed);
+	while (!m_State.compare_exchange_weak(state, ((state >> GenerationShift) + 1) << GenerationShift, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+	}
+}
+
+DeftLocks::Stats DeftLocks::GetStats() const
+{
+	Stats stats;
+	stats.m_Acquires = m_Acquires.load(std::memory_order_relaxed);
+	stats.m_Releases = m_Releases.load(std::memory_order_relaxed);
+	stats.m_StaleReleases = m_StaleReleases.load(std::memory_order_relaxed);
+	stats.m_LeaksDetected = m_LeaksDetected.load(std::memory_order_relaxed);
+	return stats;
 }
-#endif//!UE_BUILD_SHIPPING
\ No newline at end of file
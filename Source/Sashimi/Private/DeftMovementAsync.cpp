@@ -0,0 +1,249 @@
+#include "DeftMovementAsync.h"
+#include "DeftMovementStats.h"
+#include "Engine/World.h"
+
+namespace DeftMovementAsync
+{
+	// further than this off the dash curve after a step and something got in the way of the move
+	static constexpr float AirDashBlockedTolerance = 1.f;
+}
+
+void FDeftAsyncSimState::Publish()
+{
+	FScopeLock lock(&m_PublishLock);
+	const uint8 pendingEvents = m_Published.m_Events;
+	m_Published = m_Sim;
+	m_Published.m_Events |= pendingEvents;
+	m_Sim.m_Events = DAME_None;
+}
+
+FDeftAsyncMoveState FDeftAsyncSimState::Consume()
+{
+	FScopeLock lock(&m_PublishLock);
+	FDeftAsyncMoveState state = m_Published;
+	m_Published.m_Events = DAME_None;
+	return state;
+}
+
+
+void FDeftCharacterAsyncInput::CheckJumpInput(float DeltaSeconds, const FCharacterMovementComponentAsyncInput& Input, FCharacterMovementComponentAsyncOutput& Output) const
+{
+	FCharacterAsyncInput::CheckJumpInput(DeltaSeconds, Input, Output);
+
+	if (!m_SimState.IsValid())
+		return;
+
+	FDeftAsyncSimState& simState = *m_SimState;
+	UpdateAfterMovement(DeltaSeconds, Input, Output, simState.m_Sim);
+	ApplyMoveInput(Input, Output, simState.m_Sim);
+	if (simState.m_Sim.m_bAirDashing)
+		StepAirDash(DeltaSeconds, Input, Output, simState.m_Sim);
+	simState.Publish();
+}
+
+void FDeftCharacterAsyncInput::UpdateAfterMovement(float aDeltaSeconds, const FCharacterMovementComponentAsyncInput& aInput, FCharacterMovementComponentAsyncOutput& aOutput, FDeftAsyncMoveState& outState) const
+{
+	const bool bFalling = aOutput.MovementMode == MOVE_Falling;
+	if (outState.m_bWasFalling && !bFalling)
+	{
+		// mirrors UDeftMovementComponent::OnMovementModeChanged leaving MOVE_Falling
+		ResetJump(outState);
+		if (aOutput.MovementMode == MOVE_Walking)
+		{
+			outState.m_bHasAirDashed = false;
+			outState.m_JumpInputCounter = 0;
+			outState.m_Events |= DAME_Landed;
+		}
+	}
+	outState.m_bWasFalling = bFalling;
+	if (!bFalling)
+		return;
+
+	// UpdateInternalMoveMode
+	if (outState.m_bInPlatformJump && outState.m_bIncrementJumpInputHoldTime)
+		outState.m_JumpKeyHoldTime += aDeltaSeconds;
+
+	const FVector location = aInput.UpdatedComponentInput->GetPosition();
+	const FQuat rotation = aInput.UpdatedComponentInput->GetRotation();
+	if (outState.m_bAirDashing)
+	{
+		// PhysAirDash ends the dash at the top of the curve or on anything in the way, the sim slid the velocity along it
+		const FVector curveLocation = outState.m_AirDashStart + DeftJumpKinematics::CalculateAirDashOffset(m_JumpTuning, outState.m_AirDashDirection, outState.m_AirDashElapsed);
+		const bool bBlocked = FVector::DistSquared(location, curveLocation) > FMath::Square(DeftMovementAsync::AirDashBlockedTolerance);
+		if (!bBlocked && outState.m_AirDashElapsed < m_JumpTuning.m_AirDashTime)
+			return;
+
+		if (!bBlocked)
+			aOutput.Velocity = DeftJumpKinematics::CalculateAirDashVelocity(m_JumpTuning, outState.m_AirDashDirection, outState.m_AirDashElapsed);
+		EndAirDash(outState);
+	}
+
+	if (aOutput.Velocity.Z < 0.f && !outState.m_bJumpApexReached)
+		ReachApex(outState);
+
+	if (outState.m_InternalMoveMode == IMOVE_AirDash)
+		aOutput.Velocity = DeftJumpKinematics::CalculateDashExitVelocity(aOutput.Velocity, m_MaxSpeed, m_AirDashExitDeceleration, aDeltaSeconds);
+
+	if (outState.m_InternalMoveMode == IMOVE_LedgeUp)
+	{
+		const FVector forwardVelocity = rotation.GetForwardVector() * m_LedgeUpForwardMinBoost * aDeltaSeconds;
+		aOutput.Velocity.X += forwardVelocity.X;
+		aOutput.Velocity.Y += forwardVelocity.Y;
+	}
+
+	// PhysFalling ledge up, the ledge queries run here on the physics thread. Without jump held the sync path would
+	// hang from the ledge, there's no LedgeHang mode here so there's nothing to find
+	if (outState.m_bIsLedgingUp || aOutput.Velocity.Z >= 0.f || !m_bJumpButtonDown || !aInput.World)
+		return;
+
+	FDeftLedgeProbe probe = m_LedgeProbe;
+	probe.m_Origin = location;
+	probe.m_Forward = rotation.GetForwardVector();
+	probe.m_Up = rotation.GetUpVector();
+	FVector ledgeEdge, hopUpLocation;
+	if (!FindLedge(*aInput.World, probe, rotation, *m_SimState, ledgeEdge, hopUpLocation))
+		return;
+
+	const FVector targetLocation = ledgeEdge + FVector(0.f, 0.f, probe.m_CapsuleHalfHeight + m_LedgeUpAdditionalHeightOffset);
+	const float distanceToLedgeUpHeight = targetLocation.Z - location.Z;
+
+	ResetJump(outState);
+	outState.m_LedgeEdge = ledgeEdge;
+	outState.m_HopUpLocation = hopUpLocation;
+	outState.m_GravityScale = DeftJumpKinematics::CalculateGravityScale(m_TimeToReachLedgeUpHeight, distanceToLedgeUpHeight, m_JumpTuning.m_DefaultGravityZ);
+	outState.m_bIsLedgingUp = true;
+	outState.m_InternalMoveMode = IMOVE_LedgeUp;
+	outState.m_Events |= DAME_LedgeUp;
+	aOutput.Velocity = FVector(0.f, 0.f, DeftJumpKinematics::CalculateInitialVelocityZ(m_TimeToReachLedgeUpHeight, distanceToLedgeUpHeight));
+}
+
+void FDeftCharacterAsyncInput::ApplyMoveInput(const FCharacterMovementComponentAsyncInput& aInput, FCharacterMovementComponentAsyncOutput& aOutput, FDeftAsyncMoveState& outState) const
+{
+	if (m_bJumpButtonDown != outState.m_bWasJumpButtonDown)
+	{
+		outState.m_bWasJumpButtonDown = m_bJumpButtonDown;
+		if (m_bJumpButtonDown)
+		{
+			// HandleJumpPressed + DoJump, the base CheckJumpInput already decided whether the character can jump
+			outState.m_JumpKeyHoldTime = 0.f;
+			outState.m_bIncrementJumpInputHoldTime = true;
+			if (outState.m_JumpInputCounter < m_JumpInputMax && !outState.m_bIsLedgingUp && !outState.m_bAirDashing)
+			{
+				const FDeftJumpLaunch jumpLaunch = DeftJumpKinematics::CalculateJumpLaunch(m_JumpTuning, ++outState.m_JumpInputCounter);
+				aOutput.Velocity.Z = jumpLaunch.m_VelocityZ;
+				aInput.SetMovementMode(MOVE_Falling, aOutput);
+				outState.m_GravityScale = jumpLaunch.m_GravityScale;
+				outState.m_bWasFalling = true;
+				outState.m_bInPlatformJump = true;
+				outState.m_bJumpApexReached = false;
+				outState.m_Events |= DAME_Jumped;
+			}
+		}
+		else if (outState.m_bIncrementJumpInputHoldTime)
+		{
+			// HandleJumpReleased, quantized the same way as the synchronous/networked path
+			outState.m_bIncrementJumpInputHoldTime = false;
+			const uint8 quantizedHoldTime = DeftJumpKinematics::QuantizeHoldTime(outState.m_JumpKeyHoldTime, m_JumpTuning.m_JumpKeyMaxHoldTime);
+			const float holdTime = DeftJumpKinematics::DequantizeHoldTime(quantizedHoldTime, m_JumpTuning.m_JumpKeyMaxHoldTime);
+			outState.m_GravityScale = DeftJumpKinematics::CalculateHoldTimeGravityScale(holdTime, m_JumpTuning.m_JumpKeyMaxHoldTime, m_GravityScales);
+		}
+	}
+
+	// PerformAirDash, the sim stays in MOVE_Falling and StepAirDash steers it along the curve
+	if (m_bWantsToAirDash && aOutput.MovementMode == MOVE_Falling && !outState.m_bHasAirDashed && m_JumpTuning.m_AirDashTime > 0.f)
+	{
+		ResetJump(outState);
+		outState.m_GravityScale = 0.f;
+		outState.m_bHasAirDashed = true;
+		outState.m_bAirDashing = true;
+		outState.m_AirDashElapsed = 0.f;
+		outState.m_AirDashStart = aInput.UpdatedComponentInput->GetPosition();
+		outState.m_AirDashDirection = aInput.UpdatedComponentInput->GetRotation().GetForwardVector().GetSafeNormal2D();
+		outState.m_InternalMoveMode = IMOVE_AirDash;
+		outState.m_Events |= DAME_AirDash;
+	}
+}
+
+void FDeftCharacterAsyncInput::StepAirDash(float aDeltaSeconds, const FCharacterMovementComponentAsyncInput& aInput, FCharacterMovementComponentAsyncOutput& aOutput, FDeftAsyncMoveState& outState) const
+{
+	if (aDeltaSeconds < UE_SMALL_NUMBER)
+		return;
+
+	// aim for the curve relative to where the dash started so nothing drifts, and take out the gravity the sim is about
+	// to integrate (the zero gravity scale only reaches it with the next input)
+	outState.m_AirDashElapsed = FMath::Min(outState.m_AirDashElapsed + aDeltaSeconds, m_JumpTuning.m_AirDashTime);
+	const FVector curveLocation = outState.m_AirDashStart + DeftJumpKinematics::CalculateAirDashOffset(m_JumpTuning, outState.m_AirDashDirection, outState.m_AirDashElapsed);
+	aOutput.Velocity = (curveLocation - aInput.UpdatedComponentInput->GetPosition()) / aDeltaSeconds;
+	aOutput.Velocity.Z -= 0.5f * m_GravityZ * aDeltaSeconds;
+}
+
+void FDeftCharacterAsyncInput::EndAirDash(FDeftAsyncMoveState& outState) const
+{
+	// m_InternalMoveMode stays IMOVE_AirDash so the dash speed bleeds off until landing, like UDeftMovementComponent::EndAirDash
+	outState.m_bAirDashing = false;
+	ReachApex(outState);
+}
+
+void FDeftCharacterAsyncInput::ReachApex(FDeftAsyncMoveState& outState) const
+{
+	if (outState.m_bJumpApexReached)
+		return;
+
+	outState.m_bJumpApexReached = true;
+	outState.m_bIncrementJumpInputHoldTime = false;
+	outState.m_JumpKeyHoldTime = 0.f;
+	outState.m_GravityScale = m_GravityScales.m_PostJump;
+	outState.m_Events |= DAME_ApexReached;
+}
+
+void FDeftCharacterAsyncInput::ResetJump(FDeftAsyncMoveState& outState) const
+{
+	outState.m_InternalMoveMode = IMOVE_None;
+	outState.m_bAirDashing = false;
+	outState.m_bIsLedgingUp = false;
+	outState.m_bInPlatformJump = false;
+	outState.m_bJumpApexReached = false;
+	outState.m_GravityScale = m_DefaultGravityScale;
+	outState.m_LedgeEdge = FVector::ZeroVector;
+	outState.m_HopUpLocation = FVector::ZeroVector;
+}
+
+bool FDeftCharacterAsyncInput::FindLedge(const UWorld& aWorld, const FDeftLedgeProbe& aProbe, const FQuat& aRotation, const FDeftAsyncSimState& aSimState, FVector& outLedgeEdge, FVector& outHopUpLocation) const
+{
+	DEFT_MOVEMENT_SCOPE(FindLedge);
+
+	FHitResult wallHit;
+	FVector rayStart, rayEnd;
+	aProbe.GetWallRay(rayStart, rayEnd);
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	if (!aWorld.LineTraceSingleByProfile(wallHit, rayStart, rayEnd, m_CollisionProfile, aSimState.m_QueryParams))
+		return false;
+
+	// open space above the wall means there's a ledge
+	aProbe.GetSpaceRay(rayStart, rayEnd);
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	if (aWorld.LineTraceTestByProfile(rayStart, rayEnd, m_CollisionProfile, aSimState.m_QueryParams))
+		return false;
+
+	FHitResult surfaceHit;
+	aProbe.GetSurfaceRay(rayStart, rayEnd);
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	if (!aWorld.LineTraceSingleByProfile(surfaceHit, rayStart, rayEnd, m_CollisionProfile, aSimState.m_QueryParams))
+		return false;
+
+	outLedgeEdge = FDeftLedgeProbe::GetLedgeEdge(aProbe.m_Origin, surfaceHit.Location, surfaceHit.Normal, wallHit.Location);
+	DeftMovementStats::AddCount(EDeftMovementCounter::LedgeCandidates);
+
+	// same clearance test as UDeftMovementComponent::CheckSpaceForCapsule
+	aProbe.GetClearanceSweep(surfaceHit.Location, rayStart, rayEnd);
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	const FCollisionShape capsule = FCollisionShape::MakeCapsule(m_CapsuleRadius, aProbe.m_CapsuleHalfHeight);
+	const bool bBlocked = m_bClearanceOverlap
+		? aWorld.OverlapBlockingTestByProfile(rayStart, aRotation, m_CollisionProfile, capsule, aSimState.m_QueryParams)
+		: aWorld.SweepTestByProfile(rayStart, rayEnd, aRotation, m_CollisionProfile, capsule, aSimState.m_QueryParams);
+	if (bBlocked)
+		return false;
+
+	outHopUpLocation = outLedgeEdge + aProbe.m_Forward * m_CapsuleRadius / 2.f;
+	return true;
+}
@@ -2,24 +2,55 @@
 
 
 #include "DeftMovementComponent.h"
+#include "Engine/OverlapResult.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "PhysicsEngine/PhysicsSettings.h"
+#include "GameFramework/PhysicsVolume.h"
 #include "Character/PlayerCharacter.h"
 #include "CollisionQueryParams.h"
+#include "Misc/App.h"
 #include "Kismet/GameplayStatics.h"
 #include "DeftLocks.h"
-#include "GameFramework/ForceFeedbackEffect.h"
+#include "DeftLedgeProbe.h"
+#include "DeftLedgeIndexSubsystem.h"
+#include "DeftLedgeLaunchSolver.h"
+#include "DeftJumpKinematics.h"
+#include "DeftDebugOverlay.h"
+#include "DeftMovementStats.h"
+#include "DeftMovementTrace.h"
+#include "DeftMovementAsync.h"
+#include "DeftAnimInstance.h"
+#include "DeftMovementSubsystem.h"
+#include "Mass/DeftMassFragments.h"
 
 // DEBUG VISUALIZATION
 static TAutoConsoleVariable<bool> CVarDebugLocomotion(TEXT("d.DebugMovement"), false, TEXT("shows debug info for movement"));
 static TAutoConsoleVariable<bool> CVarDebugJump(TEXT("d.DebugJump"), false, TEXT("shows debug info for jumping"));
+static TAutoConsoleVariable<bool> CVarDebugLedge(TEXT("d.DebugLedge"), false, TEXT("draws the wall rays and ledge floor axes of every ledge check, only while the debug overlay is shown"));
+static TAutoConsoleVariable<bool> CVarDebugLedgeIndex(TEXT("d.DebugLedgeIndex"), false, TEXT("draws the loaded ledge index segments"));
 
 // FEATURE TOGGLES
 static TAutoConsoleVariable<bool> CVarUseUEJump(TEXT("d.UseUEJump"), false, TEXT("if enabled use the default UE5 jump physics"));
 static TAutoConsoleVariable<bool> CVarEnablePostJumpGravity(TEXT("d.EnablePostJumpGravity"), true, TEXT("if enabled use a different post jump gravity"));
 static TAutoConsoleVariable<bool> CVarTestVariableJump(TEXT("d.TestVariableJump"), false, TEXT("spamspam"));
 static TAutoConsoleVariable<bool> CVarDeftLocksUnlockAll(TEXT("d.DeftLocks.UnlockAll"), false, TEXT("reset all locks"));
+static TAutoConsoleVariable<bool> CVarLedgeAsync(TEXT("d.Ledge.Async"), false, TEXT("if enabled ledge detection is issued through async traces at the end of the frame and consumed by the next move, otherwise the blocking traces are used"));
+static TAutoConsoleVariable<int32> CVarLedgeAsyncMaxLatency(TEXT("d.Ledge.AsyncMaxLatency"), 3, TEXT("latency/accuracy trade off for async ledge detection: max age (in frames) of a result before it's discarded as stale"));
+static TAutoConsoleVariable<float> CVarLedgeAsyncMaxDrift(TEXT("d.Ledge.AsyncMaxDrift"), 30.f, TEXT("max distance (cm) the character may have moved since an async ledge query was issued for its result to still be used"));
+static TAutoConsoleVariable<bool> CVarLedgeUseIndex(TEXT("d.Ledge.UseIndex"), true, TEXT("if enabled static ledges are looked up in the baked ledge index wherever one is loaded, only movable geometry is traced"));
+static TAutoConsoleVariable<bool> CVarLedgeCoherence(TEXT("d.Ledge.Coherence"), true, TEXT("if enabled traced ledge detection reuses the previous result while the character hasn't moved far and the geometry it hit hasn't moved"));
+static TAutoConsoleVariable<float> CVarLedgeCoherenceDistance(TEXT("d.Ledge.CoherenceDistance"), 5.f, TEXT("max distance (cm) the character may move before a cached ledge result is traced again"));
+static TAutoConsoleVariable<int32> CVarLedgeCoherenceMaxAge(TEXT("d.Ledge.CoherenceMaxAge"), 4, TEXT("max age (in frames) of a cached ledge result, bounds how long something new appearing in empty space can go unnoticed"));
+static TAutoConsoleVariable<bool> CVarLedgeClearanceOverlap(TEXT("d.Ledge.ClearanceOverlap"), true, TEXT("if enabled the capsule clearance check on a ledge is a blocking overlap test, otherwise the original tiny upward sweep"));
+static TAutoConsoleVariable<bool> CVarLedgeHang(TEXT("d.Ledge.Hang"), true, TEXT("if enabled falling onto a ledge without holding jump grabs it (CustomMovement::LedgeHang) instead of falling past"));
+static TAutoConsoleVariable<bool> CVarLedgeSwept(TEXT("d.Ledge.Swept"), true, TEXT("if enabled ledge detection probes the whole path the character fell along since the last move (up to LedgeSweepMaxProbes probes), otherwise only where it ended up"));
+static TAutoConsoleVariable<bool> CVarHighSpeedSubsteps(TEXT("d.HighSpeedSubsteps"), true, TEXT("if enabled the air dash and the speed left over from it are substepped so no step moves further than a fraction of the capsule radius"));
+static TAutoConsoleVariable<float> CVarLODBlendTime(TEXT("d.LOD.BlendTime"), 0.5f, TEXT("seconds a character takes to blend its tick interval to a new significance bucket's"));
+static TAutoConsoleVariable<float> CVarFixedStepHz(TEXT("d.FixedStep.Hz"), 0.f, TEXT("standalone only: if > 0 Deft movement is simulated at this fixed rate independent of the frame rate and the mesh is interpolated between steps"));
+static TAutoConsoleVariable<int32> CVarFixedStepMaxSteps(TEXT("d.FixedStep.MaxSteps"), 4, TEXT("max fixed steps simulated in one frame, any time beyond that is dropped so a hitch can't spiral"));
 
 DEFINE_LOG_CATEGORY(LogDeftMovement);
 DEFINE_LOG_CATEGORY(LogDeftLedge);
@@ -27,8 +58,45 @@ DEFINE_LOG_CATEGORY(LogDeftLedgeLaunchTrajectory);
 DEFINE_LOG_CATEGORY(LogDeftLedgeLaunchPath);
 DEFINE_LOG_CATEGORY(LogDeftAirDash);
 
+namespace DeftLedgeHang
+{
+	// a ledge found past a segment end only continues the one being hung from if it's at about the same height
+	static constexpr float MaxStepHeight = 10.f;
+	// and the wall doesn't turn more than ~45 degrees
+	static constexpr float MinWallNormalDot = 0.7f;
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs CmdLedgeCountQueries(
+	TEXT("d.Ledge.CountQueries"),
+	TEXT("repeats ledge detection from where the local player is standing and logs scene queries and time per FindLedge for the original sweep clearance, the overlap clearance and the coherence cache. args: [iterations=1000]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& aArgs, UWorld* aWorld)
+	{
+		const APlayerController* playerController = aWorld ? aWorld->GetFirstPlayerController() : nullptr;
+		const ACharacter* character = playerController ? Cast<ACharacter>(playerController->GetPawn()) : nullptr;
+		UDeftMovementComponent* movementComponent = character ? Cast<UDeftMovementComponent>(character->GetCharacterMovement()) : nullptr;
+		if (!movementComponent)
+		{
+			UE_LOG(LogDeftLedge, Warning, TEXT("d.Ledge.CountQueries: the local player isn't a Deft character"));
+			return;
+		}
+
+		const int32 iterations = aArgs.Num() > 0 ? FMath::Max(1, FCString::Atoi(*aArgs[0])) : 1000;
+		const auto logMeasurement = [iterations](const TCHAR* aLabel, const UDeftMovementComponent::LedgeQueryMeasurement& aMeasurement)
+		{
+			UE_LOG(LogDeftLedge, Display, TEXT("%-20s %.2f queries/FindLedge, %.2f us/FindLedge over %d, ledge found %d"), aLabel, aMeasurement.m_QueriesPerFindLedge, aMeasurement.m_MicrosecondsPerFindLedge, iterations, (int32)aMeasurement.m_bLedgeFound);
+		};
+
+		// stand facing a wall/ledge to exercise every stage, open space only ever costs the wall ray
+		logMeasurement(TEXT("traced, sweep"), movementComponent->MeasureLedgeQueries(iterations, true, false));
+		logMeasurement(TEXT("traced, overlap"), movementComponent->MeasureLedgeQueries(iterations, true, true));
+		logMeasurement(TEXT("coherence cache"), movementComponent->MeasureLedgeQueries(iterations, false, CVarLedgeClearanceOverlap.GetValueOnGameThread()));
+	}));
+#endif
+
 UDeftMovementComponent::UDeftMovementComponent()
 {
+	SetNetworkMoveDataContainer(m_DeftNetworkMoveDataContainer);
 }
 
 
@@ -46,31 +114,95 @@ void UDeftMovementComponent::BeginPlay()
 
 	m_DefaultGravityScaleCache = GravityScale;
 
-	m_MaxPreJumpGravityScale = CalculateJumpGravityScale(TimeToJumpMaxHeight, JumpMaxHeight);
-	// We need to scale time by the same factor as height since
-	// if it takes 1s to reach 4m, then it would take 0.5s to reach 2m
-	// so if the max height is 4m in 1s, and the min height is 2m we shouldn't use gravity that takes us to 2m over 1s, it should take us 0.5s instead
-	float timeScale = JumpMaxHeight / JumpMinHeight;
-	m_MinPreJumpGravityScale = CalculateJumpGravityScale(TimeToJumpMaxHeight / timeScale, JumpMinHeight);
-	m_PostJumpGravityScale = CalculateJumpGravityScale(PostTimeToJumpMaxHeight, JumpMaxHeight);
+	const FDeftJumpGravityScales gravityScales = DeftJumpKinematics::CalculateGravityScales(GetJumpTuning());
+	m_MaxPreJumpGravityScale = gravityScales.m_MaxPreJump;
+	m_MinPreJumpGravityScale = gravityScales.m_MinPreJump;
+	m_PostJumpGravityScale = gravityScales.m_PostJump;
 
 	m_CollisionQueryParams.AddIgnoredActor(GetOwner());
+	m_MovableCollisionQueryParams = m_CollisionQueryParams;
+	m_MovableCollisionQueryParams.MobilityType = EQueryMobilityType::Dynamic;
 	const UCapsuleComponent* capsuleComponent = Cast<ACharacter>(GetOwner())->GetCapsuleComponent();
 	m_CapsuleCollisionShapeCache = FCollisionShape::MakeCapsule(capsuleComponent->GetScaledCapsuleRadius(), capsuleComponent->GetScaledCapsuleHalfHeight());
 
 	m_SphereCollisionShape = FCollisionShape::MakeSphere(10.f);
+
+	m_LedgeTraceDelegate.BindUObject(this, &UDeftMovementComponent::OnLedgeTraceCompleted);
+	m_LedgeOverlapDelegate.BindUObject(this, &UDeftMovementComponent::OnLedgeOverlapCompleted);
+
+	m_NetworkStats.m_StartTime = GetWorld()->GetTimeSeconds();
+
+	m_LODSettings = FDeftMovementLODSettings::Get(m_MovementLOD);
+	if (UDeftSignificanceManager* significanceManager = USignificanceManager::Get<UDeftSignificanceManager>(GetWorld()))
+		significanceManager->RegisterMovement(this);
+}
+
+void UDeftMovementComponent::EndPlay(const EEndPlayReason::Type aEndPlayReason)
+{
+	if (UDeftSignificanceManager* significanceManager = USignificanceManager::Get<UDeftSignificanceManager>(GetWorld()))
+		significanceManager->UnregisterMovement(this);
+
+	Super::EndPlay(aEndPlayReason);
+}
+
+void UDeftMovementComponent::SetMovementLOD(EDeftMovementLOD aLOD)
+{
+	if (aLOD == m_MovementLOD)
+		return;
+
+	m_MovementLOD = aLOD;
+	const float currentTickInterval = m_LODSettings.m_TickInterval;
+	m_LODSettings = FDeftMovementLODSettings::Get(aLOD);
+
+	// the tick interval blends in TickComponent, everything else switches right away
+	const float blendTime = CVarLODBlendTime.GetValueOnGameThread();
+	m_TickIntervalBlendRate = blendTime > 0.f ? FMath::Abs(m_LODSettings.m_TickInterval - currentTickInterval) / blendTime : 0.f;
+	m_LODSettings.m_TickInterval = blendTime > 0.f ? currentTickInterval : m_LODSettings.m_TickInterval;
+	SetComponentTickInterval(m_LODSettings.m_TickInterval);
 }
 
 void UDeftMovementComponent::TickComponent(float aDeltaTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction)
 {
-	Super::TickComponent(aDeltaTime, aTickType, aThisTickFunction);
+	const uint64 tickStartCycles = FPlatformTime::Cycles64();
+	const float fixedStepHz = CVarFixedStepHz.GetValueOnGameThread();
+	if (fixedStepHz > 0.f && ShouldUseFixedStep())
+		TickFixedStep(aDeltaTime, 1.f / fixedStepHz, aTickType, aThisTickFunction);
+	else
+	{
+		if (m_bFixedStepInterpolating)
+			StopFixedStepInterpolation();
+		Super::TickComponent(aDeltaTime, aTickType, aThisTickFunction);
+	}
+	DeftMovementStats::AddMovementTickCycles(FPlatformTime::Cycles64() - tickStartCycles);
+
+	const float targetTickInterval = FDeftMovementLODSettings::Get(m_MovementLOD).m_TickInterval;
+	if (m_LODSettings.m_TickInterval != targetTickInterval)
+	{
+		m_LODSettings.m_TickInterval = FMath::FInterpConstantTo(m_LODSettings.m_TickInterval, targetTickInterval, aDeltaTime, m_TickIntervalBlendRate);
+		SetComponentTickInterval(m_LODSettings.m_TickInterval);
+	}
+
+	TRACE_DEFT_MOVEMENT_STATE(*this);
 
 #if DEBUG_VIEW
-	DrawDebug();
+	if (DeftDebugOverlay::IsEnabled())
+		DrawDebug();
+
+	if (CVarDebugLedgeIndex.GetValueOnGameThread())
+	{
+		if (const UDeftLedgeIndexSubsystem* ledgeIndex = UWorld::GetSubsystem<UDeftLedgeIndexSubsystem>(GetWorld()))
+		{
+			for (const ADeftLedgeIndexActor* index : ledgeIndex->GetIndices())
+			{
+				if (index)
+					index->DrawIndex();
+			}
+		}
+	}
 
 	if (CVarDeftLocksUnlockAll.GetValueOnGameThread())
 	{
-		DeftLocks::UnlockAll();
+		m_DeftLocks.UnlockAll();
 		IConsoleManager& consoleManager = IConsoleManager::Get();
 		if (IConsoleVariable* cvar = consoleManager.FindConsoleVariable(TEXT("d.DeftLocks.UnlockAll")))
 		{
@@ -86,6 +218,70 @@ void UDeftMovementComponent::TickComponent(float aDeltaTime, enum ELevelTick aTi
 #endif
 }
 
+bool UDeftMovementComponent::ShouldUseFixedStep() const
+{
+	// networked moves are already timestamped and replayed by the prediction code, the input replay runs its own fixed step
+	return GetNetMode() == NM_Standalone && !FApp::UseFixedTimeStep() && CharacterOwner && CharacterOwner->GetMesh();
+}
+
+void UDeftMovementComponent::TickFixedStep(float aDeltaTime, float aStepTime, ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction)
+{
+	// Every step is a whole CMC tick, so per step: input consumption, PerformMovement, OnMovementUpdated and with it the
+	// ledge sweep and UpdateInternalMoveMode. With d.Movement.Batch the character is only queued by the first step of a
+	// frame, the subsystem then sweeps the whole frame's path and runs the post move update once with the summed step time.
+	// Once per frame, after the steps: the mesh interpolation below and everything after it in TickComponent (LOD blend,
+	// trace, debug draw)
+	m_FixedStepAccumulator += aDeltaTime;
+	const int32 steps = FMath::Min(FMath::FloorToInt(m_FixedStepAccumulator / aStepTime), CVarFixedStepMaxSteps.GetValueOnGameThread());
+	if (steps > 0)
+	{
+		// the pawn's input is consumed by the first step, the rest of this frame's steps see the same input
+		const FVector inputVector = PawnOwner ? PawnOwner->GetPendingMovementInputVector() : FVector::ZeroVector;
+		for (int32 step = 0; step < steps; ++step)
+		{
+			if (step > 0 && PawnOwner)
+				PawnOwner->AddMovementInput(inputVector);
+
+			m_FixedStepPreviousLocation = UpdatedComponent->GetComponentLocation();
+			m_FixedStepPreviousRotation = UpdatedComponent->GetComponentQuat();
+			Super::TickComponent(aStepTime, aTickType, aThisTickFunction);
+		}
+		m_FixedStepAccumulator = FMath::Min(m_FixedStepAccumulator - steps * aStepTime, aStepTime);
+	}
+
+	// render between the last two simulated states, one step behind the simulation
+	const FVector currentLocation = UpdatedComponent->GetComponentLocation();
+	const FQuat currentRotation = UpdatedComponent->GetComponentQuat();
+	const float alpha = FMath::Clamp(m_FixedStepAccumulator / aStepTime, 0.f, 1.f);
+	FVector renderLocation = FMath::Lerp(m_FixedStepPreviousLocation, currentLocation, alpha);
+	FQuat renderRotation = FQuat::Slerp(m_FixedStepPreviousRotation, currentRotation, alpha);
+
+	// teleports and ledge snaps shouldn't be smeared across a step
+	const float maxStepDistance = FMath::Max(GetMaxSpeed(), Velocity.Size()) * aStepTime * 2.f;
+	if (FVector::DistSquared(m_FixedStepPreviousLocation, currentLocation) > FMath::Square(maxStepDistance))
+	{
+		renderLocation = currentLocation;
+		renderRotation = currentRotation;
+	}
+
+	// the mesh is placed where it would be under a capsule at the render transform, the camera's spring arm hangs off
+	// the mesh so it follows the interpolated position too
+	USkeletalMeshComponent* mesh = CharacterOwner->GetMesh();
+	const FVector meshLocation = renderLocation + renderRotation.RotateVector(CharacterOwner->GetBaseTranslationOffset());
+	const FQuat meshRotation = renderRotation * CharacterOwner->GetBaseRotationOffset();
+	mesh->SetRelativeLocationAndRotation(currentRotation.UnrotateVector(meshLocation - currentLocation), currentRotation.Inverse() * meshRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	m_bFixedStepInterpolating = true;
+}
+
+void UDeftMovementComponent::StopFixedStepInterpolation()
+{
+	m_bFixedStepInterpolating = false;
+	m_FixedStepAccumulator = 0.f;
+	if (CharacterOwner && CharacterOwner->GetMesh())
+		CharacterOwner->GetMesh()->SetRelativeLocationAndRotation(CharacterOwner->GetBaseTranslationOffset(), CharacterOwner->GetBaseRotationOffset());
+}
+
+
 bool UDeftMovementComponent::DoJump(bool bReplayingMoves, float DeltaTime)
 {
 	if (CVarUseUEJump.GetValueOnGameThread())
@@ -101,22 +297,14 @@ bool UDeftMovementComponent::DoJump(bool bReplayingMoves, float DeltaTime)
 		if (!bConstrainToPlane || !FMath::IsNearlyEqual(FMath::Abs(GetGravitySpaceZ(PlaneConstraintNormal)), 1.f))
 		{
 			// TODO: remove this when we keep track of jump counting elsewhere
+			// replays increment this again, FSavedMove_Deft restores it before every replayed move
 			++m_JumpInputCounter;
 
-			float jumpTime = TimeToJumpMaxHeight;
-			float jumpHeight = JumpMaxHeight;
 			// double jumps are slightly less powerful
-			if (m_JumpInputCounter > 1)
-			{
-				jumpTime *= 0.75f;
-				jumpHeight *= 0.75f;
-			}
-			
-			FVector initialVelocity = CalculateJumpInitialVelocity(jumpTime, jumpHeight);
-			float gravityScale = CalculateJumpGravityScale(jumpTime, jumpHeight);//m_MaxPreJumpGravityScale;
+			const FDeftJumpLaunch jumpLaunch = DeftJumpKinematics::CalculateJumpLaunch(GetJumpTuning(), m_JumpInputCounter);
 
-			Velocity.Z = initialVelocity.Z;
-			GravityScale = gravityScale;
+			Velocity.Z = jumpLaunch.m_VelocityZ;
+			GravityScale = jumpLaunch.m_GravityScale;
 
 			// allows the physx engine to take over and apply gravity over time and automatic collision checks
 			SetMovementMode(MOVE_Falling);
@@ -125,12 +313,16 @@ bool UDeftMovementComponent::DoJump(bool bReplayingMoves, float DeltaTime)
 
 			m_PlatformJumpInitialPosition = CharacterOwner->GetActorLocation();
 			m_PlatformJumpApex = 0.f;
+			BroadcastMovementEvent(EDeftMovementEvent::JumpStarted);
 
 #if DEBUG_VIEW
-			m_PlatformJumpDebug.m_GravityValues.Empty();
-			m_PlatformJumpDebug.m_GravityValues.Add(m_DefaultGravityZCache * GravityScale);
-			m_PlatformJumpDebug.m_GravityValues.Add(m_DefaultGravityZCache * m_PostJumpGravityScale);
-			m_PlatformJumpDebug.m_InitialVelocity = initialVelocity.Z;
+			if (!bReplayingMoves)
+			{
+				m_PlatformJumpDebug.m_GravityValues.Empty();
+				m_PlatformJumpDebug.m_GravityValues.Add(m_DefaultGravityZCache * GravityScale);
+				m_PlatformJumpDebug.m_GravityValues.Add(m_DefaultGravityZCache * m_PostJumpGravityScale);
+				m_PlatformJumpDebug.m_InitialVelocity = jumpLaunch.m_VelocityZ;
+			}
 #endif
 			return true;
 		}
@@ -153,248 +345,1234 @@ void UDeftMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovemen
 			case MOVE_Falling:
 				ResetJump();
 				break;
+			case MOVE_Custom:
+				if (PreviousCustomMode == CustomMovement::LedgeHang)
+					BroadcastMovementEvent(EDeftMovementEvent::LedgeReleased);
+				else if (PreviousCustomMode == CustomMovement::AirDash)
+					BroadcastMovementEvent(EDeftMovementEvent::AirDashEnded);
+				break;
 		}
 		switch (MovementMode)
 		{
 			case MOVE_Walking:
 				m_bHasAirDashed = false;
 				m_JumpInputCounter = 0;
+				// every move that locks input ends by the time we land
+				m_DeftLocks.CheckForLeaks(TEXT("landed"));
+				if (PreviousMovementMode == MOVE_Falling)
+					BroadcastMovementEvent(EDeftMovementEvent::Landed);
 				break;
+			case MOVE_Custom:
+				if (CustomMovementMode == CustomMovement::LedgeHang)
+				{
+					// grabbing a ledge gives back the jumps and the dash like landing does
+					Velocity = FVector::ZeroVector;
+					m_bHasAirDashed = false;
+					m_JumpInputCounter = 0;
+				}
+				break;
+		}
+	}
+}
+
+
+void UDeftMovementComponent::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+{
+	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	// the rest of the post move work happens once per frame for every character together (d.Movement.Batch)
+	if (UDeftMovementSubsystem::ShouldBatch(*this))
+	{
+		if (!m_bBatchPostMovePending)
+		{
+			m_BatchPostMoveOldLocation = OldLocation;
+			m_BatchPostMoveDeltaTime = 0.f;
+			m_bBatchPostMovePending = true;
+			GetWorld()->GetSubsystem<UDeftMovementSubsystem>()->QueuePostMove(this);
+		}
+		m_BatchPostMoveDeltaTime += DeltaSeconds;
+		return;
+	}
+
+	if (ShouldSweepForLedge())
+		SweepForLedge(OldLocation, DeltaSeconds);
+
+	// nothing internal runs while hanging or dashing, both place the character themselves
+	if (!IsLedgeHanging() && !IsAirDashing())
+		UpdateInternalMoveMode(DeltaSeconds);
+}
+
+bool UDeftMovementComponent::ShouldSweepForLedge() const
+{
+	// Only perform a ledge up if we're not already ledging up
+	if (!IsFalling() || m_bIsLedgingUp || Velocity.Z >= 0)
+		return false;
+
+	// remote clients flag the moves they ledged up on, the server doesn't need to search for ledges on any other move
+	const bool bIsRemoteClientMove = CharacterOwner->GetLocalRole() == ROLE_Authority && CharacterOwner->GetRemoteRole() == ROLE_AutonomousProxy;
+	// far away characters don't look for ledges at all (see UDeftSignificanceManager)
+	return (!bIsRemoteClientMove && m_LODSettings.m_bFindLedge) || m_bClientLedgeUpRequested;
+}
+
+void UDeftMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	m_bIsJumpButtonDown = (Flags & FSavedMove_Deft::FLAG_JumpHeld) != 0;
+	m_bWantsToAirDash = (Flags & FSavedMove_Deft::FLAG_AirDash) != 0;
+	m_bClientLedgeUpRequested = (Flags & FSavedMove_Deft::FLAG_LedgeUp) != 0;
+
+	// use the client's hold time so releasing jump gives the same gravity scale on both sides
+	if (const FDeftCharacterNetworkMoveData* moveData = static_cast<const FDeftCharacterNetworkMoveData*>(GetCurrentNetworkMoveData()))
+		m_JumpKeyHoldTime = DeftJumpKinematics::DequantizeHoldTime(moveData->m_QuantizedJumpHoldTime, JumpKeyMaxHoldTime);
+}
+
+FNetworkPredictionData_Client* UDeftMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UDeftMovementComponent* mutableThis = const_cast<UDeftMovementComponent*>(this);
+		mutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Deft(*this);
+	}
+	return ClientPredictionData;
+}
+
+void UDeftMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection)
+{
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode, ServerGravityDirection);
+
+	++m_NetworkStats.m_Corrections;
+	UE_VLOG(this, LogDeftMovement, Log, TEXT("correction at %.3f: location error %.2f, velocity error %.2f"), TimeStamp, FVector::Dist(NewLocation, UpdatedComponent->GetComponentLocation()), FVector::Dist(NewVelocity, Velocity));
+}
+
+void UDeftMovementComponent::ServerMovePacked_ServerReceive(const FCharacterServerMovePackedBits& PackedBits)
+{
+	++m_NetworkStats.m_ServerMoves;
+	m_NetworkStats.m_ServerMoveBits += PackedBits.DataBits.Num();
+	Super::ServerMovePacked_ServerReceive(PackedBits);
+}
+
+void UDeftMovementComponent::ClientMoveResponsePacked_ClientReceive(const FCharacterMoveResponsePackedBits& PackedBits)
+{
+	m_NetworkStats.m_MoveResponseBits += PackedBits.DataBits.Num();
+	Super::ClientMoveResponsePacked_ClientReceive(PackedBits);
+}
+
+void UDeftMovementComponent::FillAsyncInput(const FVector& InputVector, FCharacterMovementComponentAsyncInput& AsyncInput)
+{
+	Super::FillAsyncInput(InputVector, AsyncInput);
+
+	if (!m_DeftAsyncSimState.IsValid())
+	{
+		m_DeftAsyncSimState = MakeShared<FDeftAsyncSimState, ESPMode::ThreadSafe>();
+		m_DeftAsyncSimState->m_QueryParams = m_CollisionQueryParams;
+		m_DeftAsyncSimState->m_Sim.m_GravityScale = GravityScale;
+
+		// the physics thread has no custom modes to hang in, see DeftMovementAsync.h
+		if (CVarLedgeHang.GetValueOnGameThread())
+			UE_LOG(LogDeftLedge, Warning, TEXT("%s: p.AsyncCharacterMovement doesn't support d.Ledge.Hang, falling onto a ledge without holding jump falls past it"), *GetNameSafe(CharacterOwner));
+	}
+
+	// the callback pools its inputs, each one only needs swapping for the Deft type once
+	if (!m_DeftAsyncInputs.Contains(AsyncInput.CharacterInput.Get()))
+	{
+		TUniquePtr<FDeftCharacterAsyncInput> deftInput = MakeUnique<FDeftCharacterAsyncInput>();
+		static_cast<FCharacterAsyncInput&>(*deftInput) = *AsyncInput.CharacterInput;
+		AsyncInput.CharacterInput = MoveTemp(deftInput);
+		m_DeftAsyncInputs.Add(AsyncInput.CharacterInput.Get());
+	}
+
+	FDeftCharacterAsyncInput& deftInput = static_cast<FDeftCharacterAsyncInput&>(*AsyncInput.CharacterInput);
+	deftInput.m_JumpTuning = GetJumpTuning();
+	deftInput.m_GravityScales = { m_MaxPreJumpGravityScale, m_MinPreJumpGravityScale, m_PostJumpGravityScale };
+	FillLedgeProbeTuning(deftInput.m_LedgeProbe);
+	const UCapsuleComponent* capsuleComponent = CharacterOwner->GetCapsuleComponent();
+	deftInput.m_LedgeProbe.m_CapsuleHalfHeight = capsuleComponent->GetScaledCapsuleHalfHeight();
+	deftInput.m_CapsuleRadius = capsuleComponent->GetScaledCapsuleRadius();
+	deftInput.m_CollisionProfile = capsuleComponent->GetCollisionProfileName();
+	deftInput.m_DefaultGravityScale = m_DefaultGravityScaleCache;
+	deftInput.m_bClearanceOverlap = CVarLedgeClearanceOverlap.GetValueOnGameThread();
+	deftInput.m_GravityZ = GetGravityZ();
+	deftInput.m_MaxSpeed = GetMaxSpeed();
+	deftInput.m_AirDashExitDeceleration = AirDashExitDeceleration;
+	deftInput.m_LedgeUpAdditionalHeightOffset = LedgeUpAdditionalHeightOffset;
+	deftInput.m_TimeToReachLedgeUpHeight = TimeToReachLedgeUpHeight;
+	deftInput.m_LedgeUpForwardMinBoost = LedgeUpForwardMinBoost;
+	deftInput.m_JumpInputMax = m_JumpInputMax;
+	deftInput.m_bJumpButtonDown = m_bIsJumpButtonDown;
+	deftInput.m_bWantsToAirDash = m_bWantsToAirDash;
+	deftInput.m_SimState = m_DeftAsyncSimState;
+
+	// the request now belongs to the physics thread
+	m_bWantsToAirDash = false;
+}
+
+void UDeftMovementComponent::ApplyAsyncOutput(FCharacterMovementComponentAsyncOutput& Output)
+{
+	Super::ApplyAsyncOutput(Output);
+
+	if (!m_DeftAsyncSimState.IsValid())
+		return;
+
+	const FDeftAsyncMoveState state = m_DeftAsyncSimState->Consume();
+	const bool bWasLedgingUp = m_bIsLedgingUp;
+
+	// mirror the physics thread's state so gravity, debug views and the trace see the async move
+	GravityScale = state.m_GravityScale;
+	m_JumpKeyHoldTime = state.m_JumpKeyHoldTime;
+	m_JumpInputCounter = state.m_JumpInputCounter;
+	m_bIncrementJumpInputHoldTime = state.m_bIncrementJumpInputHoldTime;
+	m_bInPlatformJump = state.m_bInPlatformJump;
+	m_bJumpApexReached = state.m_bJumpApexReached;
+	m_bHasAirDashed = state.m_bHasAirDashed;
+	m_bIsLedgingUp = state.m_bIsLedgingUp;
+	m_InternalMoveMode = state.m_InternalMoveMode;
+	m_ledgeEdgeCache = state.m_LedgeEdge;
+	m_ledgeHopUpLocationCache = state.m_HopUpLocation;
+
+	// locks and feedback are game thread only, apply them in the order the physics thread raised them
+	if (state.m_Events & (DAME_Jumped | DAME_Landed))
+	{
+		m_LedgeUpLock.Release();
+		m_AirDashLock.Release();
+		if (bWasLedgingUp)
+			BroadcastMovementEvent(EDeftMovementEvent::LedgeUpEnded);
+	}
+	if (state.m_Events & DAME_Jumped)
+		BroadcastMovementEvent(EDeftMovementEvent::JumpStarted);
+	if (state.m_Events & DAME_AirDash)
+	{
+		m_LedgeUpLock.Release();
+		m_AirDashLock = m_DeftLocks.Acquire(EDeftLock::AllMoveInput, TEXT("AirDash"));
+		BroadcastMovementEvent(EDeftMovementEvent::AirDashStarted);
+	}
+	if (state.m_Events & DAME_LedgeUp)
+	{
+		m_AirDashLock.Release();
+		m_LedgeUpLock = m_DeftLocks.Acquire(EDeftLock::AllMoveInput, TEXT("LedgeUp"));
+		BroadcastMovementEvent(EDeftMovementEvent::LedgeFound);
+		BroadcastMovementEvent(EDeftMovementEvent::LedgeUpStarted);
+	}
+	if (state.m_Events & DAME_ApexReached)
+	{
+		if (m_InternalMoveMode == EInternalMoveMode::IMOVE_LedgeUp)
+			m_LedgeUpLock.Release(EDeftLock::MoveInputForwardBack);
+		if (m_InternalMoveMode == EInternalMoveMode::IMOVE_AirDash)
+			m_AirDashLock.Release();
+		BroadcastMovementEvent(EDeftMovementEvent::ApexReached);
+	}
+	if (state.m_Events & DAME_Landed)
+	{
+		m_DeftLocks.CheckForLeaks(TEXT("landed"));
+		BroadcastMovementEvent(EDeftMovementEvent::Landed);
+	}
+}
+
+bool UDeftMovementComponent::CanAttemptJump() const
+{
+	// TODO: other types of aerial moves should reset the jump ability like a mid air kick or dash you should be able to perform a jump after perhaps
+ 
+	// Allows coyote time for a short distance after true falling occurs 
+	if (m_FallDistanceJumpThreshold > 0)
+	{
+		float distanceFallen = FMath::Abs(m_FallOrigin.Z - CharacterOwner->GetActorLocation().Z);
+		return	Super::CanAttemptJump() &&
+			(!IsAttemptingDoubleJump() || distanceFallen <= m_FallDistanceJumpThreshold);
+	}
+
+	return	Super::CanAttemptJump();
+}
+
+void UDeftMovementComponent::OnJumpPressed()
+{
+	m_bIsJumpButtonDown = true;
+}
+
+void UDeftMovementComponent::OnJumpReleased()
+{
+	m_bIsJumpButtonDown = false;
+}
+
+void UDeftMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	m_bLedgeUpThisMove = false;
+
+	if (m_bIsJumpButtonDown != m_bWasJumpButtonDown)
+	{
+		m_bWasJumpButtonDown = m_bIsJumpButtonDown;
+		if (m_bIsJumpButtonDown)
+		{
+			HandleJumpPressed();
+			if (IsLedgeHanging())
+				ClimbFromLedgeHang();
 		}
+		else
+			HandleJumpReleased();
+	}
+
+	if (m_bWantsToAirDash)
+	{
+		m_bWantsToAirDash = false;
+		PerformAirDash();
+	}
+}
+
+void UDeftMovementComponent::HandleJumpPressed()
+{
+	m_JumpKeyHoldTime = 0.f;
+	m_bIncrementJumpInputHoldTime = true;
+}
+
+void UDeftMovementComponent::HandleJumpReleased()
+{
+	// apply a new gravity scale based on time held
+	if (m_bIncrementJumpInputHoldTime)
+	{
+		// Only switch to gravity if we need to
+		m_bIncrementJumpInputHoldTime = false;
+
+		// the server only knows the quantized hold time, use the same value here so both land on the same gravity
+		const uint8 quantizedHoldTime = DeftJumpKinematics::QuantizeHoldTime(m_JumpKeyHoldTime, JumpKeyMaxHoldTime);
+		const float holdTime = DeftJumpKinematics::DequantizeHoldTime(quantizedHoldTime, JumpKeyMaxHoldTime);
+
+		// ex: max time is 2s, min time is 1s, we hold for 0.2s, we _should_ get 0.2/2s = 0.1 == 10% of the jump
+		const FDeftJumpGravityScales gravityScales = { m_MaxPreJumpGravityScale, m_MinPreJumpGravityScale, m_PostJumpGravityScale };
+		GravityScale = DeftJumpKinematics::CalculateHoldTimeGravityScale(holdTime, JumpKeyMaxHoldTime, gravityScales);
 	}
 }
 
 
-void UDeftMovementComponent::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+void UDeftMovementComponent::OnAirDash()
+{
+	m_bWantsToAirDash = true;
+}
+
+void UDeftMovementComponent::PerformAirDash()
+{
+	if (IsFalling() && !m_bHasAirDashed && AirDashTime > 0.f)
+	{
+		// leaving MOVE_Falling resets the jump, so the dash state has to be set up after the switch
+		SetMovementMode(MOVE_Custom, CustomMovement::AirDash);
+
+		m_bHasAirDashed = true;
+		m_InternalMoveMode = IMOVE_AirDash;
+		m_AirDashElapsed = 0.f;
+		m_AirDashDirection = CharacterOwner->GetActorForwardVector().GetSafeNormal2D();
+		Velocity = DeftJumpKinematics::CalculateAirDashVelocity(GetJumpTuning(), m_AirDashDirection, 0.f);
+
+		m_AirDashLock = m_DeftLocks.Acquire(EDeftLock::AllMoveInput, TEXT("AirDash"));
+
+		// TODO: its about time we managed our own jump counter so I can reset after dashes and limit only one jump after a dash
+
+		UE_VLOG(this, LogDeftAirDash, Log, TEXT("dash speed: %.2f"), AirDashDistance / AirDashTime);
+		UE_VLOG(this, LogDeftAirDash, Log, TEXT("dash direction: %s"), *m_AirDashDirection.ToString());
+		UE_VLOG(this, LogDeftAirDash, Log, TEXT("initial dash velocity: %s"), *Velocity.ToString());
+		BroadcastMovementEvent(EDeftMovementEvent::AirDashStarted);
+	}
+}
+
+void UDeftMovementComponent::PhysAirDash(float aDeltaTime, int32 aIterations)
+{
+	DEFT_MOVEMENT_SCOPE(PhysAirDash);
+
+	if (aDeltaTime < MIN_TICK_TIME)
+		return;
+
+	// where the curve says we should be is exact at any frame rate, there's no gravity or air control to integrate.
+	// a long frame is still split up so the sweeps follow the curve closely enough not to cut through thin geometry
+	const FDeftJumpTuning tuning = GetJumpTuning();
+	const float dashTime = FMath::Min(aDeltaTime, AirDashTime - m_AirDashElapsed);
+	const FVector frameDelta = DeftJumpKinematics::CalculateAirDashOffset(tuning, m_AirDashDirection, m_AirDashElapsed + dashTime) - DeftJumpKinematics::CalculateAirDashOffset(tuning, m_AirDashDirection, m_AirDashElapsed);
+	const int32 substeps = GetHighSpeedSubsteps(frameDelta.Size());
+	const float substepTime = dashTime / substeps;
+
+	float timeUsed = 0.f;
+	for (int32 substep = 0; substep < substeps; ++substep)
+	{
+		const float previousElapsed = m_AirDashElapsed;
+		m_AirDashElapsed = FMath::Min(m_AirDashElapsed + substepTime, AirDashTime);
+		const float stepTime = m_AirDashElapsed - previousElapsed;
+		const FVector moveDelta = DeftJumpKinematics::CalculateAirDashOffset(tuning, m_AirDashDirection, m_AirDashElapsed) - DeftJumpKinematics::CalculateAirDashOffset(tuning, m_AirDashDirection, previousElapsed);
+		Velocity = DeftJumpKinematics::CalculateAirDashVelocity(tuning, m_AirDashDirection, m_AirDashElapsed);
+
+		FHitResult hit(1.f);
+		SafeMoveUpdatedComponent(moveDelta, UpdatedComponent->GetComponentQuat(), true, hit);
+		if (hit.IsValidBlockingHit())
+		{
+			// anything in the way ends the dash, falling carries on from the impact without the velocity into the surface
+			HandleImpact(hit, stepTime, moveDelta);
+			Velocity = FVector::VectorPlaneProject(Velocity, hit.Normal);
+			EndAirDash();
+			StartNewPhysics(aDeltaTime - timeUsed - stepTime * hit.Time, aIterations);
+			return;
+		}
+		timeUsed += stepTime;
+	}
+
+	UE_VLOG_LOCATION(this, LogDeftAirDash, Log, UpdatedComponent->GetComponentLocation(), 2.5f, FColor::Cyan, TEXT("%d substeps"), substeps);
+
+	if (m_AirDashElapsed >= AirDashTime)
+	{
+		EndAirDash();
+		StartNewPhysics(aDeltaTime - timeUsed, aIterations);
+	}
+}
+
+void UDeftMovementComponent::EndAirDash()
+{
+	// the top of the dash curve is its apex, falling takes over with post jump gravity and the input unlocked.
+	// m_InternalMoveMode stays IMOVE_AirDash so UpdateInternalMoveMode bleeds the dash speed off until landing
+	SetMovementMode(MOVE_Falling);
+	OnJumpApexReached();
+	UE_VLOG(this, LogDeftAirDash, Log, TEXT("dash ended after %.3f s, velocity %s"), m_AirDashElapsed, *Velocity.ToString());
+}
+
+float UDeftMovementComponent::GetHighSpeedMaxStepDistance() const
+{
+	return CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() * HighSpeedSubstepRadiusFraction;
+}
+
+int32 UDeftMovementComponent::GetHighSpeedSubsteps(float aMoveDistance) const
+{
+	const float maxStepDistance = GetHighSpeedMaxStepDistance();
+	if (!CVarHighSpeedSubsteps.GetValueOnGameThread() || maxStepDistance <= UE_KINDA_SMALL_NUMBER)
+		return 1;
+	return FMath::Clamp(FMath::CeilToInt(aMoveDistance / maxStepDistance), 1, FMath::Max(HighSpeedMaxSubsteps, 1));
+}
+
+float UDeftMovementComponent::GetSimulationTimeStep(float aRemainingTime, int32 aIterations) const
+{
+	const float timeStep = Super::GetSimulationTimeStep(aRemainingTime, aIterations);
+
+	// only the speed left over from a dash gets finer steps, ordinary falling keeps the engine's step and its cost.
+	// PhysFalling still stops at MaxSimulationIterations, the last iteration takes whatever time is left
+	if (m_InternalMoveMode != EInternalMoveMode::IMOVE_AirDash || !IsFalling() || !CVarHighSpeedSubsteps.GetValueOnGameThread() || aIterations >= FMath::Min(HighSpeedMaxSubsteps, MaxSimulationIterations - 1))
+		return timeStep;
+
+	const float maxStepDistance = GetHighSpeedMaxStepDistance();
+	const float speed = Velocity.Size();
+	if (speed * timeStep <= maxStepDistance || maxStepDistance <= UE_KINDA_SMALL_NUMBER)
+		return timeStep;
+	return FMath::Max(maxStepDistance / speed, MIN_TICK_TIME);
+}
+
+void UDeftMovementComponent::PhysFalling(float aDeltaTime, int32 aIterations)
+{
+	DEFT_MOVEMENT_SCOPE(PhysFalling);
+
+	Super::PhysFalling(aDeltaTime, aIterations);
+
+	m_LedgeHangRegrabTime = FMath::Max(m_LedgeHangRegrabTime - aDeltaTime, 0.f);
+
+	// store the last fall origin
+	if (MovementMode == MOVE_Falling && Velocity.Z < 0 && !m_bIsFallOriginSet)
+	{
+		m_bIsFallOriginSet = true;
+		m_FallOrigin = CharacterOwner->GetActorLocation();
+	}
+
+	// ledges are looked for once per move in OnMovementUpdated (SweepForLedge), not once per falling iteration
+}
+
+void UDeftMovementComponent::SweepForLedge(const FVector& aOldLocation, float aDeltaTime)
+{
+	DEFT_MOVEMENT_SCOPE(SweepForLedge);
+
+	// if velocity is negative (or we're post apex) and there is a ledge grab, grab it
+	//		currently holding a ledge and jump or (maybe) forward is pressed hop up
+	// if velocity is positive
+	//		holding jump key: hop up
+	const FVector actorLocation = CharacterOwner->GetActorLocation();
+	const FVector fwd = CharacterOwner->GetActorForwardVector();
+
+	// the probe only sees ledges between its origin and LedgeHeightOrigin above it, so a move covering more than that
+	// is probed at several points along the way, oldest first so the first ledge passed is the one grabbed.
+	// past LedgeSweepMaxProbes the probes spread out and each one is widened by the gap so the whole move stays covered.
+	// async queries can only have one in flight, so the one probe at the end is widened to cover the whole move
+	const bool bAsync = CVarLedgeAsync.GetValueOnGameThread() && !bClientUpdating;
+	const float moveDistance = FVector::Dist(aOldLocation, actorLocation);
+	int32 probes = 1;
+	float probeGap = 0.f;
+	if (CVarLedgeSwept.GetValueOnGameThread() && LedgeHeightOrigin > UE_KINDA_SMALL_NUMBER)
+	{
+		const int32 maxProbes = bAsync ? 1 : FMath::Max(LedgeSweepMaxProbes, 1);
+		const float probeSpacing = FMath::Max(LedgeHeightOrigin, moveDistance / maxProbes);
+		probes = FMath::Clamp(FMath::CeilToInt(moveDistance / probeSpacing), 1, maxProbes);
+		probeGap = probeSpacing - LedgeHeightOrigin;
+	}
+
+	// reach a frame's worth of forward travel further so a fast approach grabs the ledge before running into its wall
+	const float forwardSpeed = FMath::Max(Velocity | fwd, 0.f);
+	const float extraReach = FMath::Min(forwardSpeed * aDeltaTime, WallReach * LedgeProbeMaxReachScale - WallReach) + probeGap;
+
+	bool bFoundLedge = false;
+	for (int32 probe = 1; probe <= probes && !bFoundLedge; ++probe)
+	{
+		LedgeSweepProbe sweepProbe;
+		sweepProbe.m_bActive = true;
+		sweepProbe.m_Origin = FMath::Lerp(aOldLocation, actorLocation, (float)probe / probes);
+		sweepProbe.m_ExtraReach = FMath::Max(extraReach, 0.f);
+		sweepProbe.m_ExtraHeight = probeGap;
+		TGuardValue<LedgeSweepProbe> sweepProbeGuard(m_LedgeSweepProbe, sweepProbe);
+		bFoundLedge = FindLedge();
+	}
+
+	if (bFoundLedge && !m_bLedgeInReach)
+		BroadcastMovementEvent(EDeftMovementEvent::LedgeFound);
+	if (!bClientUpdating)
+		m_bLedgeInReach = bFoundLedge;
+
+	if (bFoundLedge && Velocity.Z < 0)
+	{
+		if (m_bIsJumpButtonDown)
+			StartLedgeUp();
+		else if (CVarLedgeHang.GetValueOnGameThread() && m_LedgeHangRegrabTime <= 0.f)
+			EnterLedgeHang();
+	}
+
+	UE_VLOG_SEGMENT(this, LogDeftLedge, Log, aOldLocation, actorLocation, FColor::Orange, TEXT("Ledge Sweep (%d probes)"), probes);
+	UE_VLOG_SEGMENT(this, LogDeftLedge, Log, actorLocation, actorLocation + fwd * 1000.f, FColor::Magenta, TEXT("Actor Forward"));
+
+	// TODO: implement wall run up which will also trigger an automatic hop up at the top of ledges
+}
+
+void UDeftMovementComponent::StartLedgeUp()
+{
+	// ledge up
+	//	- height = however high we need to make sure the capsule is above the ledge surface
+	//	- time = the constant time we want it to take
+	// 1. lock all move input
+	// 2. calculate the jump velocity and gravity needed to achieve height in time
+	// 3. jump
+	// 4. on jump apex achieved unlock forward and backwards input and ADD some small constant forward velocity
+
+	// 2. calculate min height needed for capsule to be above surface
+	const UCapsuleComponent* capsuleComponent = CharacterOwner->GetCapsuleComponent();
+	const float capsuleHalfHeight = capsuleComponent->GetScaledCapsuleHalfHeight();
+	const FVector targetLocation = m_ledgeEdgeCache + FVector(0.f, 0.f, capsuleHalfHeight + LedgeUpAdditionalHeightOffset);
+	const float distanceToLedgeUpHeight = targetLocation.Z - CharacterOwner->GetActorLocation().Z;
+
+	UE_VLOG_SPHERE(this, LogDeftLedgeLaunchTrajectory, Log, targetLocation, 5.f, FColor::Green, TEXT("ledgeUpHeight"));
+	UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("char to target distance: %.2f"), distanceToLedgeUpHeight);
+
+	// 3. calculate jump velocity and gravity needed to reach ledge height in time
+	const FVector ledgeUpVelocity = CalculateJumpInitialVelocity(TimeToReachLedgeUpHeight, distanceToLedgeUpHeight);
+	const float ledgeUpGravityScale = CalculateJumpGravityScale(TimeToReachLedgeUpHeight, distanceToLedgeUpHeight);
+
+	// 4. Clear out any previous state or velocity
+	ResetJump();
+	Velocity = FVector::ZeroVector;
+
+	// Lock all move input here rather than in step 1, the reset releases whatever the previous move held
+	m_LedgeUpLock = m_DeftLocks.Acquire(EDeftLock::AllMoveInput, TEXT("LedgeUp"));
+
+	// 5. Jump
+	// this should still respect the number of jumps we've done, so if we double jumped to get to the ledge we won't be able to perform another after
+	// but if we only jumped once into a ledge up we should be able to jump again after
+	Velocity.Z = ledgeUpVelocity.Z;	// Velocity XY will be slowly updated over time rather than suddenly
+	GravityScale = ledgeUpGravityScale;
+	m_bIsLedgingUp = true;
+	m_bLedgeUpThisMove = true;
+	SetInternalMoveMode(EInternalMoveMode::IMOVE_LedgeUp);
+	BroadcastMovementEvent(EDeftMovementEvent::LedgeUpStarted);
+}
+
+void UDeftMovementComponent::PhysCustom(float aDeltaTime, int32 aIterations)
+{
+	// the Deft modes move the character themselves, only modes we don't know about go to Super (and the blueprint event)
+	switch (CustomMovementMode)
+	{
+		case CustomMovement::LedgeHang:
+			PhysLedgeHang(aDeltaTime, aIterations);
+			return;
+		case CustomMovement::AirDash:
+			PhysAirDash(aDeltaTime, aIterations);
+			return;
+		default:
+			Super::PhysCustom(aDeltaTime, aIterations);
+			return;
+	}
+}
+
+void UDeftMovementComponent::PhysicsRotation(float aDeltaTime)
+{
+	// hanging always faces the wall, orienting to the shimmy would turn the character sideways
+	if (IsLedgeHanging())
+		return;
+
+	Super::PhysicsRotation(aDeltaTime);
+}
+
+void UDeftMovementComponent::EnterLedgeHang()
+{
+	// leaving MOVE_Falling resets the jump which clears the ledge caches, keep the segment first
+	m_LedgeHangSegment = m_ledgeSegmentCache;
+	m_bLedgeUpThisMove = true;
+	SetMovementMode(MOVE_Custom, CustomMovement::LedgeHang);
+	BroadcastMovementEvent(EDeftMovementEvent::LedgeGrabbed);
+
+	UE_VLOG_SEGMENT(this, LogDeftLedge, Log, m_LedgeHangSegment.m_Start, m_LedgeHangSegment.m_End, FColor::Orange, TEXT("Ledge Hang %s"), m_LedgeHangSegment.m_bBaked ? TEXT("baked") : TEXT("traced"));
+}
+
+void UDeftMovementComponent::PhysLedgeHang(float aDeltaTime, int32 aIterations)
+{
+	DEFT_MOVEMENT_SCOPE(PhysLedgeHang);
+
+	if (aDeltaTime < MIN_TICK_TIME)
+		return;
+
+	const FVector inputDirection = Acceleration.GetSafeNormal2D();
+	if ((inputDirection | m_LedgeHangSegment.m_WallNormal) > LedgeHangDropInputThreshold)
+	{
+		DropFromLedgeHang();
+		StartNewPhysics(aDeltaTime, aIterations);
+		return;
+	}
+
+	// the hang state is only the segment, where along it we are comes from the location so corrections and replays just work
+	const FVector segmentStart = m_LedgeHangSegment.m_Start;
+	const FVector segmentVector = m_LedgeHangSegment.m_End - segmentStart;
+	const float segmentLength = segmentVector.Size();
+	const FVector edgeDirection = segmentLength > UE_KINDA_SMALL_NUMBER ? segmentVector / segmentLength : FVector::CrossProduct(FVector::UpVector, m_LedgeHangSegment.m_WallNormal);
+	const FVector hangOffset = GetLedgeHangLocation(FVector::ZeroVector, m_LedgeHangSegment.m_WallNormal);
+	const float currentDistance = FMath::Clamp((UpdatedComponent->GetComponentLocation() - hangOffset - segmentStart) | edgeDirection, 0.f, segmentLength);
+
+	// Acceleration is the move input scaled by the max acceleration
+	const float shimmyInput = FMath::Clamp((Acceleration | edgeDirection) / FMath::Max(GetMaxAcceleration(), UE_KINDA_SMALL_NUMBER), -1.f, 1.f);
+	const float targetDistance = currentDistance + shimmyInput * LedgeHangShimmySpeed * aDeltaTime;
+	FVector ledgeEdge = segmentStart + edgeDirection * FMath::Clamp(targetDistance, 0.f, segmentLength);
+
+	// the only place a hanging character queries the scene: the end of the segment it knows about
+	if (targetDistance > segmentLength || targetDistance < 0.f)
+	{
+		const bool bPastEnd = targetDistance > segmentLength;
+		const FVector targetEdge = segmentStart + edgeDirection * targetDistance;
+		if (ExtendLedgeHangSegment(bPastEnd ? m_LedgeHangSegment.m_End : segmentStart, bPastEnd ? edgeDirection : -edgeDirection))
+			ledgeEdge = FMath::ClosestPointOnSegment(targetEdge, m_LedgeHangSegment.m_Start, m_LedgeHangSegment.m_End);
+	}
+
+	const FVector hangLocation = GetLedgeHangLocation(ledgeEdge, m_LedgeHangSegment.m_WallNormal);
+	const FQuat hangRotation = FRotationMatrix::MakeFromX(-m_LedgeHangSegment.m_WallNormal).ToQuat();
+	const FVector moveDelta = hangLocation - UpdatedComponent->GetComponentLocation();
+
+	// swept: the segment says there's a ledge to hang from, not that nothing is standing in the way along it
+	FHitResult hit;
+	SafeMoveUpdatedComponent(moveDelta, hangRotation, true, hit);
+	if (hit.IsValidBlockingHit())
+	{
+		// stay where the sweep stopped, the next frame's shimmy tries again from here
+		Velocity = FVector::ZeroVector;
+		UE_VLOG_LOCATION(this, LogDeftLedge, Log, hit.ImpactPoint, 5.f, FColor::Red, TEXT("Shimmy blocked by %s"), *GetNameSafe(hit.GetActor()));
+	}
+	else
+	{
+		Velocity = edgeDirection * shimmyInput * LedgeHangShimmySpeed;
+	}
+
+	UE_VLOG_SEGMENT(this, LogDeftLedge, Log, m_LedgeHangSegment.m_Start, m_LedgeHangSegment.m_End, FColor::Orange, TEXT("Hang Segment"));
+	UE_VLOG_LOCATION(this, LogDeftLedge, Log, ledgeEdge, 5.f, FColor::Orange, TEXT("Hang Edge"));
+}
+
+bool UDeftMovementComponent::ExtendLedgeHangSegment(const FVector& aSegmentEnd, const FVector& aDirection)
+{
+	const LedgeSegment& current = m_LedgeHangSegment;
+
+	// a virtual character hanging just past the end, placed so the edge sits halfway up its space ray
+	FDeftLedgeProbe probe = MakeLedgeProbe();
+	const FVector probeEdge = aSegmentEnd + aDirection * FMath::Max(LedgeHangTracedSegmentExtent, 1.f);
+	probe.m_Origin = probeEdge + current.m_WallNormal * CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() - FVector::UpVector * LedgeHeightOrigin * 0.5f;
+	probe.m_Forward = -current.m_WallNormal;
+	probe.m_Up = FVector::UpVector;
+
+	LedgeSegment next;
+	bool bFound = false;
+	FDeftLedgeIndexHit indexHit;
+	const UDeftLedgeIndexSubsystem* ledgeIndex = CVarLedgeUseIndex.GetValueOnGameThread() ? UWorld::GetSubsystem<UDeftLedgeIndexSubsystem>(GetWorld()) : nullptr;
+	if (ledgeIndex && ledgeIndex->FindLedge(probe, indexHit))
+	{
+		next.m_Start = indexHit.m_SegmentStart;
+		next.m_End = indexHit.m_SegmentEnd;
+		next.m_WallNormal = FVector(indexHit.m_WallNormal.X, indexHit.m_WallNormal.Y, 0.f).GetSafeNormal();
+		next.m_SurfaceNormal = indexHit.m_SurfaceNormal;
+		next.m_bBaked = true;
+		bFound = true;
+	}
+	else
+	{
+		LedgeQueryContext context = MakeLedgeQueryContext(m_CollisionQueryParams);
+		context.m_Probe = probe;
+		FHitResult wallHit, surfaceHit;
+		FVector ledgeEdge;
+		if (TraceLedgeEdge(context, wallHit, surfaceHit, ledgeEdge))
+		{
+			next = MakeTracedLedgeSegment(ledgeEdge, wallHit.Normal, surfaceHit.Normal);
+			bFound = true;
+		}
+	}
+
+	// has to be the same ledge carrying on, not a different one above or below or round a sharp corner
+	const bool bContinues = bFound
+		&& FMath::Abs(FMath::ClosestPointOnSegment(probeEdge, next.m_Start, next.m_End).Z - aSegmentEnd.Z) <= DeftLedgeHang::MaxStepHeight
+		&& (next.m_WallNormal | current.m_WallNormal) >= DeftLedgeHang::MinWallNormalDot;
+	if (!bContinues)
+	{
+		UE_VLOG_LOCATION(this, LogDeftLedge, Log, probeEdge, 5.f, FColor::Red, TEXT("Ledge Hang End"));
+		return false;
+	}
+
+	m_LedgeHangSegment = next;
+	return true;
+}
+
+FVector UDeftMovementComponent::GetLedgeHangLocation(const FVector& aLedgeEdge, const FVector& aWallNormal) const
+{
+	// hands on the edge: capsule against the wall, hanging below the edge
+	const float capsuleRadius = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	return aLedgeEdge + aWallNormal * capsuleRadius - FVector::UpVector * LedgeHangHeightOffset;
+}
+
+void UDeftMovementComponent::ClimbFromLedgeHang()
+{
+	const FVector hangOffset = GetLedgeHangLocation(FVector::ZeroVector, m_LedgeHangSegment.m_WallNormal);
+	const FVector ledgeEdge = FMath::ClosestPointOnSegment(UpdatedComponent->GetComponentLocation() - hangOffset, m_LedgeHangSegment.m_Start, m_LedgeHangSegment.m_End);
+
+	// the segment only says there's a ledge, whether the capsule fits on top is checked once when climbing
+	const FVector forward = -m_LedgeHangSegment.m_WallNormal;
+	const float capsuleRadius = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	if (!CheckSpaceForCapsule(MakeLedgeQueryContext(m_CollisionQueryParams), ledgeEdge + forward * capsuleRadius))
+		return;
+
+	m_ledgeEdgeCache = ledgeEdge;
+	GetHopUpLocation(ledgeEdge, m_ledgeHopUpLocationCache);
+	SetMovementMode(MOVE_Falling);
+	StartLedgeUp();
+}
+
+void UDeftMovementComponent::DropFromLedgeHang()
+{
+	m_LedgeHangRegrabTime = LedgeHangRegrabDelay;
+	SetMovementMode(MOVE_Falling);
+}
+
+UDeftMovementComponent::LedgeSegment UDeftMovementComponent::MakeTracedLedgeSegment(const FVector& aLedgeEdge, const FVector& aWallNormal, const FVector& aSurfaceNormal) const
+{
+	LedgeSegment segment;
+	segment.m_WallNormal = FVector(aWallNormal.X, aWallNormal.Y, 0.f).GetSafeNormal();
+	if (segment.m_WallNormal.IsZero())
+		segment.m_WallNormal = -CharacterOwner->GetActorForwardVector().GetSafeNormal2D();
+	segment.m_SurfaceNormal = aSurfaceNormal;
+
+	// a single trace only finds a point on the edge, trust it to carry on along the wall for a little way either side
+	const FVector edgeDirection = FVector::CrossProduct(FVector::UpVector, segment.m_WallNormal);
+	segment.m_Start = aLedgeEdge - edgeDirection * LedgeHangTracedSegmentExtent;
+	segment.m_End = aLedgeEdge + edgeDirection * LedgeHangTracedSegmentExtent;
+	segment.m_bBaked = false;
+	return segment;
+}
+
+void UDeftMovementComponent::UpdateInternalMoveMode(float aDeltaTime)
+{
+	DEFT_MOVEMENT_SCOPE(UpdateInternalMoveMode);
+
+	// low LODs only keep the transitions that change the trajectory, the ledge up boost is left to the velocity it already has
+	if (!m_LODSettings.m_bSimulateInternalMoveMode)
+	{
+		if (m_bIncrementJumpInputHoldTime)
+			m_JumpKeyHoldTime += aDeltaTime;
+		if (Velocity.Z < 0.f && !m_bJumpApexReached)
+			OnJumpApexReached();
+		return;
+	}
+
+	if (m_bInPlatformJump)
+	{
+		if (!m_bJumpApexReached)// TODO: might be unnecessary
+		{
+			// Keep track of the highest point the jump reaches
+			float distanceJumped = FMath::Abs(CharacterOwner->GetActorLocation().Z - m_PlatformJumpInitialPosition.Z);
+			m_PlatformJumpApex = FMath::Max(m_PlatformJumpApex, distanceJumped);
+		}
+
+		// Keep track of how long the jump input has been held
+		if (m_bIncrementJumpInputHoldTime)
+		{
+			m_JumpKeyHoldTime += aDeltaTime;
+		}
+	}
+
+	// indicates we've started falling because our velocity has switched directions or gone from pos to 0
+	if (Velocity.Z < 0.f && !m_bJumpApexReached)
+	{
+		OnJumpApexReached();
+	}
+
+	if (m_InternalMoveMode == EInternalMoveMode::IMOVE_AirDash && IsFalling())
+	{
+		// after the dash the extra speed bleeds off at a fixed rate instead of leaving it to air friction
+		Velocity = DeftJumpKinematics::CalculateDashExitVelocity(Velocity, GetMaxSpeed(), AirDashExitDeceleration, aDeltaTime);
+	}
+
+	if (m_InternalMoveMode == EInternalMoveMode::IMOVE_LedgeUp)
+	{
+		// apply forward velocity over time
+		// apply minimum forward velocity so even without input player still lands on ledge
+		FVector forwardVelocity = CharacterOwner->GetActorForwardVector() * LedgeUpForwardMinBoost /*TODO: this is really the speed*/ * aDeltaTime;
+		Velocity.X += forwardVelocity.X;
+		Velocity.Y += forwardVelocity.Y;
+	}
+}
+
+
+bool UDeftMovementComponent::FindLedge()
+{
+	DEFT_MOVEMENT_SCOPE(FindLedge);
+
+	// static geometry inside a loaded ledge index doesn't need to be traced at all
+	if (CVarLedgeUseIndex.GetValueOnGameThread())
+	{
+		const UDeftLedgeIndexSubsystem* ledgeIndex = UWorld::GetSubsystem<UDeftLedgeIndexSubsystem>(GetWorld());
+		if (ledgeIndex && ledgeIndex->IsCovered(MakeLedgeProbe().m_Origin))
+		{
+			CancelLedgeAsyncQuery();
+			return FindLedgeIndexed(*ledgeIndex);
+		}
+	}
+
+	// replays need an answer for the replayed position, not one from a query issued frames ago
+	if (CVarLedgeAsync.GetValueOnGameThread() && GetWorld() && !bClientUpdating)
+		return FindLedgeAsync();
+
+	// anything still in flight is now meaningless
+	CancelLedgeAsyncQuery();
+	return FindLedgeSync(m_CollisionQueryParams);
+}
+
+
+bool UDeftMovementComponent::FindLedgeSync(const FCollisionQueryParams& aQueryParams)
+{
+	LedgeCoherenceCache& cache = m_LedgeCache;
+	const LedgeQueryContext context = MakeLedgeQueryContext(aQueryParams);
+	const FDeftLedgeProbe& probe = context.m_Probe;
+	if (CVarLedgeCoherence.GetValueOnGameThread() && IsLedgeCacheValid(probe, aQueryParams))
+	{
+		++cache.m_Hits;
+		DeftMovementStats::AddCount(EDeftMovementCounter::LedgeCacheHits);
+		if (cache.m_bEdgeFound)
+		{
+			m_ledgeEdgeCache = cache.m_LedgeEdge;
+			m_ledgeSegmentCache = MakeTracedLedgeSegment(cache.m_LedgeEdge, cache.m_Wall.m_Normal, cache.m_Surface.m_Normal);
+		}
+		if (cache.m_bClearance)
+			m_ledgeHopUpLocationCache = cache.m_HopUpLocation;
+		return cache.m_bEdgeFound && cache.m_bClearance;
+	}
+
+	++cache.m_Misses;
+	DeftMovementStats::AddCount(EDeftMovementCounter::LedgeCacheMisses);
+	cache.m_bValid = false;
+	cache.m_Frame = GFrameCounter;
+	cache.m_QueryParams = &aQueryParams;
+	cache.m_Origin = probe.m_Origin;
+	cache.m_Forward = probe.m_Forward;
+	cache.m_WallReach = probe.m_WallReach;
+	cache.m_LedgeHeightForwardReach = probe.m_LedgeHeightForwardReach;
+	cache.m_LedgeHeightOrigin = probe.m_LedgeHeightOrigin;
+	cache.m_Wall = LedgeCacheHit();
+	cache.m_Surface = LedgeCacheHit();
+	cache.m_bEdgeFound = false;
+	cache.m_bClearance = false;
+
+	const bool bFoundLedge = TraceLedge(context);
+	// replayed moves trace from positions in the past, don't let them answer for the present
+	cache.m_bValid = !bClientUpdating;
+	return bFoundLedge;
+}
+
+bool UDeftMovementComponent::IsLedgeCacheValid(const FDeftLedgeProbe& aProbe, const FCollisionQueryParams& aQueryParams) const
+{
+	const LedgeCoherenceCache& cache = m_LedgeCache;
+	if (!cache.m_bValid || cache.m_QueryParams != &aQueryParams || bClientUpdating)
+		return false;
+	if (GFrameCounter - cache.m_Frame > (uint64)FMath::Max(CVarLedgeCoherenceMaxAge.GetValueOnGameThread(), 0))
+		return false;
+	if (FVector::DistSquared(aProbe.m_Origin, cache.m_Origin) > FMath::Square(CVarLedgeCoherenceDistance.GetValueOnGameThread()))
+		return false;
+	if ((aProbe.m_Forward | cache.m_Forward) < 0.999f)
+		return false;
+	if (!FMath::IsNearlyEqual(aProbe.m_WallReach, cache.m_WallReach) || !FMath::IsNearlyEqual(aProbe.m_LedgeHeightForwardReach, cache.m_LedgeHeightForwardReach) || !FMath::IsNearlyEqual(aProbe.m_LedgeHeightOrigin, cache.m_LedgeHeightOrigin))
+		return false;
+	return cache.m_Wall.IsUnmoved() && cache.m_Surface.IsUnmoved();
+}
+
+void UDeftMovementComponent::LedgeCacheHit::Set(const FHitResult& aHit)
+{
+	m_bHit = aHit.bBlockingHit;
+	m_Component = aHit.GetComponent();
+	m_ComponentTransform = aHit.GetComponent() ? aHit.GetComponent()->GetComponentTransform() : FTransform::Identity;
+	m_Location = aHit.Location;
+	m_Normal = aHit.Normal;
+}
+
+bool UDeftMovementComponent::LedgeCacheHit::IsUnmoved() const
+{
+	if (!m_bHit)
+		return true;
+	const UPrimitiveComponent* component = m_Component.Get();
+	return component && component->GetComponentTransform().Equals(m_ComponentTransform, UE_KINDA_SMALL_NUMBER);
+}
+
+bool UDeftMovementComponent::TraceLedge(const LedgeQueryContext& aContext)
+{
+	LedgeCoherenceCache& cache = m_LedgeCache;
+
+	FHitResult wallHit, surfaceHit;
+	FVector ledgeEdgeLocation;
+	const bool bEdgeFound = TraceLedgeEdge(aContext, wallHit, surfaceHit, ledgeEdgeLocation);
+	cache.m_Wall.Set(wallHit);
+	cache.m_Surface.Set(surfaceHit);
+	if (!bEdgeFound)
+		return false;
+
+	// Regardless if there's space I want to know where the edge is
+	m_ledgeEdgeCache = ledgeEdgeLocation;
+	m_ledgeSegmentCache = MakeTracedLedgeSegment(ledgeEdgeLocation, wallHit.Normal, surfaceHit.Normal);
+	cache.m_LedgeEdge = ledgeEdgeLocation;
+	cache.m_bEdgeFound = true;
+	DeftMovementStats::AddCount(EDeftMovementCounter::LedgeCandidates);
+
+	if (!CheckSpaceForCapsule(aContext, surfaceHit.Location))
+		return false;
+
+	FVector hopUpLocation;
+	GetHopUpLocation(ledgeEdgeLocation, hopUpLocation);
+	m_ledgeHopUpLocationCache = hopUpLocation;
+	cache.m_HopUpLocation = hopUpLocation;
+	cache.m_bClearance = true;
+
+	return true;
+}
+
+bool UDeftMovementComponent::TraceLedgeEdge(const LedgeQueryContext& aContext, FHitResult& outWallHit, FHitResult& outSurfaceHit, FVector& outLedgeEdge)
 {
-	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+	// cheapest rejection first: no wall, then something above the wall, then nothing to stand on
+	FVector wallLocation;
+	if (!CheckForWall(aContext, wallLocation, &outWallHit))
+		return false;
 
-	UpdateInternalMoveMode(DeltaSeconds);
-}
+	FVector heightDistance;
+	if (!CheckForLedge(aContext, wallLocation, heightDistance))
+		return false;
 
-bool UDeftMovementComponent::CanAttemptJump() const
-{
-	// TODO: other types of aerial moves should reset the jump ability like a mid air kick or dash you should be able to perform a jump after perhaps
- 
-	// Allows coyote time for a short distance after true falling occurs 
-	if (m_FallDistanceJumpThreshold > 0)
-	{
-		float distanceFallen = FMath::Abs(m_FallOrigin.Z - CharacterOwner->GetActorLocation().Z);
-		return	Super::CanAttemptJump() &&
-			(!IsAttemptingDoubleJump() || distanceFallen <= m_FallDistanceJumpThreshold);
-	}
+	FVector ledgeSurfaceLocation, ledgeSurfaceNormal;
+	if (!CheckLedgeSurface(aContext, heightDistance, ledgeSurfaceLocation, ledgeSurfaceNormal, &outSurfaceHit))
+		return false;
 
-	return	Super::CanAttemptJump();
+	GetLedgeEdge(aContext.m_Probe.m_Origin, ledgeSurfaceLocation, ledgeSurfaceNormal, wallLocation, outLedgeEdge);
+	return true;
 }
 
-void UDeftMovementComponent::OnJumpPressed()
-{
-	m_JumpKeyHoldTime = 0.f;
-	m_bIncrementJumpInputHoldTime = true;
-	m_bIsJumpButtonDown = true;
-}
 
-void UDeftMovementComponent::OnJumpReleased()
+#if !UE_BUILD_SHIPPING
+UDeftMovementComponent::LedgeQueryMeasurement UDeftMovementComponent::MeasureLedgeQueries(int32 aIterations, bool bTraced, bool bClearanceOverlap)
 {
-	// apply a new gravity scale based on time held
-	if (m_bIncrementJumpInputHoldTime)
+	LedgeQueryMeasurement measurement;
+	if (!CharacterOwner || aIterations <= 0)
+		return measurement;
+
+	LedgeQueryContext context = MakeLedgeQueryContext(m_CollisionQueryParams);
+	context.m_bClearanceOverlap = bClearanceOverlap;
+	m_LedgeCache.m_bValid = false;
+
+	// scene queries are counted per frame and this all runs inside one
+	const uint32 queriesBefore = DeftMovementStats::GetCount(EDeftMovementCounter::SceneQueries, GFrameCounter);
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	for (int32 i = 0; i < aIterations; ++i)
 	{
-		// Only switch to gravity if we need to
-		m_bIncrementJumpInputHoldTime = false;
+		measurement.m_bLedgeFound = bTraced ? TraceLedge(context) : FindLedgeSync(m_CollisionQueryParams);
+	}
+	const double elapsedMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles);
+	const uint32 queries = DeftMovementStats::GetCount(EDeftMovementCounter::SceneQueries, GFrameCounter) - queriesBefore;
 
-		// ex: max time is 2s, we hold for 1s, we get 1/2s = 0.5 == 50% of the max jump
-		// ex: max time is 2s, min time is 1s, we hold for 0.2s, we _should_ get 0.2/2s = 0.1 == 10% of the jump
-		float val = FMath::Clamp(m_JumpKeyHoldTime / JumpKeyMaxHoldTime, 0.f, 1.f);
+	// the cache was filled from the measurement's own traces, let gameplay start from a clean slate
+	m_LedgeCache.m_bValid = false;
 
-		// val == 1 that means we held it max time and shouldn't change gravity at all.
-		// val == 0 means we want the min height (more gravity applied)
-		float gravityScaledByInput = (val * (m_MaxPreJumpGravityScale - m_MinPreJumpGravityScale)) + m_MinPreJumpGravityScale;
- 		GravityScale = gravityScaledByInput;
-	}
-	
-	m_bIsJumpButtonDown = false;
+	measurement.m_QueriesPerFindLedge = (float)queries / aIterations;
+	measurement.m_MicrosecondsPerFindLedge = elapsedMs * 1000.0 / aIterations;
+	return measurement;
 }
+#endif
 
 
-void UDeftMovementComponent::OnAirDash()
+bool UDeftMovementComponent::FindLedgeIndexed(const UDeftLedgeIndexSubsystem& aLedgeIndex)
 {
-	if (IsFalling() && !m_bHasAirDashed)
+	FDeftLedgeIndexHit indexHit;
+	if (!aLedgeIndex.FindLedge(MakeLedgeProbe(), indexHit))
 	{
-		ResetJump();
+		// nothing static here, but the ledge could be something movable
+		return FindLedgeSync(m_MovableCollisionQueryParams);
+	}
 
-		m_bHasAirDashed = true;
-		m_InternalMoveMode = IMOVE_AirDash;
+	// the bake only knows about static geometry, a movable wall closer than the baked one is what we'd actually grab
+	const LedgeQueryContext movableContext = MakeLedgeQueryContext(m_MovableCollisionQueryParams);
+	FVector movableWallLocation;
+	FHitResult movableWallHit;
+	if (CheckForWall(movableContext, movableWallLocation, &movableWallHit) && movableWallHit.Distance < indexHit.m_Distance)
+	{
+		UE_VLOG_LOCATION(this, LogDeftLedge, Log, indexHit.m_LedgeEdge, 5.f, FColor::Red, TEXT("Indexed Ledge Edge blocked by %s"), *GetNameSafe(movableWallHit.GetActor()));
+		return FindLedgeSync(m_MovableCollisionQueryParams);
+	}
 
-		const float dashSpeed = AirDashDistance / AirDashTime;
-		const FVector forwardVelocity = CharacterOwner->GetActorForwardVector() * dashSpeed;
+	UE_VLOG_LOCATION(this, LogDeftLedge, Log, indexHit.m_LedgeEdge, 5.f, FColor::Blue, TEXT("Indexed Ledge Edge"));
+	m_ledgeEdgeCache = indexHit.m_LedgeEdge;
+	m_ledgeSegmentCache.m_Start = indexHit.m_SegmentStart;
+	m_ledgeSegmentCache.m_End = indexHit.m_SegmentEnd;
+	m_ledgeSegmentCache.m_WallNormal = FVector(indexHit.m_WallNormal.X, indexHit.m_WallNormal.Y, 0.f).GetSafeNormal();
+	m_ledgeSegmentCache.m_SurfaceNormal = indexHit.m_SurfaceNormal;
+	m_ledgeSegmentCache.m_bBaked = true;
+	DeftMovementStats::AddCount(EDeftMovementCounter::LedgeCandidates);
+
+	// something movable could still be sitting on the ledge
+	if (!indexHit.m_bCapsuleFits || !CheckSpaceForCapsule(movableContext, indexHit.m_SurfaceLocation))
+		return false;
 
-		const FVector verticalVelocity = CalculateJumpInitialVelocity(AirDashTime, AirDashVerticalHeight);
-		const float dashGravityScale = CalculateJumpGravityScale(AirDashTime, AirDashVerticalHeight);
+	FVector hopUpLocation;
+	GetHopUpLocation(indexHit.m_LedgeEdge, hopUpLocation);
+	m_ledgeHopUpLocationCache = hopUpLocation;
+	return true;
+}
 
-		GravityScale = dashGravityScale;
-		const FVector finalDashVelocity = FVector(forwardVelocity.X, forwardVelocity.Y, verticalVelocity.Z);
-		
-		DeftLocks::IncrementMoveInputForwardBackLockRef();
-		DeftLocks::IncrementMoveInputRightLeftockRef();
 
-		Velocity = finalDashVelocity;
-		
-		// TODO: its about time we managed our own jump counter so I can reset after dashes and limit only one jump after a dash
-		// TODO: either after, or near the end of airdash we need to drastically increase the air friction so it slows back down to normal max speed
+FDeftLedgeProbe UDeftMovementComponent::MakeLedgeProbe() const
+{
+	FDeftLedgeProbe probe;
+	FillLedgeProbeTuning(probe);
+	probe.m_Origin = m_LedgeSweepProbe.m_bActive ? m_LedgeSweepProbe.m_Origin : CharacterOwner->GetActorLocation();
+	probe.m_WallReach += m_LedgeSweepProbe.m_ExtraReach;
+	probe.m_LedgeHeightForwardReach += m_LedgeSweepProbe.m_ExtraReach;
+	probe.m_LedgeHeightOrigin += m_LedgeSweepProbe.m_ExtraHeight;
+	probe.m_Forward = CharacterOwner->GetActorForwardVector();
+	probe.m_Up = CharacterOwner->GetActorUpVector();
+	probe.m_CapsuleHalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	return probe;
+}
 
-		UE_VLOG(this, LogDeftAirDash, Log, TEXT("dash speed: %.2f"), dashSpeed);
-		UE_VLOG(this, LogDeftAirDash, Log, TEXT("forwardVelocity: %s"), *forwardVelocity.ToString());
-		UE_VLOG(this, LogDeftAirDash, Log, TEXT("verticalVelocity: %.2f"), verticalVelocity.Z);
-		UE_VLOG(this, LogDeftAirDash, Log, TEXT("dashGravityScale: %.2f"), dashGravityScale);
-		UE_VLOG(this, LogDeftAirDash, Log, TEXT("finalDashVelocity: %s"), *finalDashVelocity.ToString());
-	}
+
+UDeftMovementComponent::LedgeQueryContext UDeftMovementComponent::MakeLedgeQueryContext(const FCollisionQueryParams& aQueryParams) const
+{
+	LedgeQueryContext context;
+	context.m_Probe = MakeLedgeProbe();
+	context.m_Rotation = CharacterOwner->GetActorQuat();
+	context.m_CollisionProfile = CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName();
+	context.m_QueryParams = &aQueryParams;
+	context.m_bClearanceOverlap = CVarLedgeClearanceOverlap.GetValueOnGameThread();
+	return context;
 }
 
-void UDeftMovementComponent::PhysFalling(float aDeltaTime, int32 aIterations)
+
+void UDeftMovementComponent::FillLedgeProbeTuning(FDeftLedgeProbe& outProbe) const
 {
-	Super::PhysFalling(aDeltaTime, aIterations);
+	outProbe.m_WallReach = WallReach;
+	outProbe.m_LedgeHeightOrigin = LedgeHeightOrigin;
+	outProbe.m_LedgeHeightForwardReach = LedgeHeightForwardReach;
+}
 
-	// store the last fall origin
-	if (MovementMode == MOVE_Falling && Velocity.Z < 0 && !m_bIsFallOriginSet)
-	{
-		m_bIsFallOriginSet = true;
-		m_FallOrigin = CharacterOwner->GetActorLocation();
-	}
 
-	// Only perform a ledge up if we're not already ledging up
-	if (!m_bIsLedgingUp && Velocity.Z < 0)
-	{
-		// if velocity is negative (or we're post apex) and there is a ledge grab, grab it
-		//		currently holding a ledge and jump or (maybe) forward is pressed hop up
-		// if velocity is positive
-		//		holding jump key: hop up
-		const FVector actorLocation = CharacterOwner->GetActorLocation();
-		const FVector fwd = CharacterOwner->GetActorForwardVector();
+bool UDeftMovementComponent::FindLedgeAsync()
+{
+	LedgeAsyncQuery& query = m_LedgeAsyncQuery;
+	bool bLedgeFound = false;
 
-		if (FindLedge() && m_bIsJumpButtonDown && Velocity.Z < 0)
+	if (query.m_Stage == ELedgeAsyncStage::Complete)
+	{
+		// only trust the result if it's recent enough and we haven't moved too far from where it was issued
+		const uint64 age = GFrameCounter - query.m_StartFrame;
+		const float drift = FVector::Dist(query.m_Origin, CharacterOwner->GetActorLocation());
+		const bool bFresh = age <= (uint64)FMath::Max(CVarLedgeAsyncMaxLatency.GetValueOnGameThread(), 1) && drift <= CVarLedgeAsyncMaxDrift.GetValueOnGameThread();
+		if (bFresh && query.m_bEdgeFound)
 		{
-			// ledge up
-			//	- height = however high we need to make sure the capsule is above the ledge surface
-			//	- time = the constant time we want it to take
-			// 1. lock all move input
-			// 2. calculate the jump velocity and gravity needed to achieve height in time
-			// 3. jump
-			// 4. on jump apex achieved unlock forward and backwards input and ADD some small constant forward velocity
-
-			// 1. Lock all move input
-			DeftLocks::IncrementMoveInputForwardBackLockRef();
-			DeftLocks::IncrementMoveInputRightLeftockRef();
-
-			// 2. calculate min height needed for capsule to be above surface
-			const UCapsuleComponent* capsuleComponent = CharacterOwner->GetCapsuleComponent();
-			const float capsuleHalfHeight = capsuleComponent->GetScaledCapsuleHalfHeight();
-			const FVector targetLocation = m_ledgeEdgeCache + FVector(0.f, 0.f, capsuleHalfHeight + LedgeUpAdditionalHeightOffset);
-			const float distanceToLedgeUpHeight = targetLocation.Z - CharacterOwner->GetActorLocation().Z;
-
-			UE_VLOG_SPHERE(this, LogDeftLedgeLaunchTrajectory, Log, targetLocation, 5.f, FColor::Green, TEXT("ledgeUpHeight"));
-			UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("char to target distance: %.2f"), distanceToLedgeUpHeight);
-
-			// 3. calculate jump velocity and gravity needed to reach ledge height in time
-			const FVector ledgeUpVelocity = CalculateJumpInitialVelocity(TimeToReachLedgeUpHeight, distanceToLedgeUpHeight);
-			const float ledgeUpGravityScale = CalculateJumpGravityScale(TimeToReachLedgeUpHeight, distanceToLedgeUpHeight);
-
-			// 4. Clear out any previous state or velocity
-			ResetJump();
-			Velocity = FVector::ZeroVector;
-
-			// 5. Jump
-			// this should still respect the number of jumps we've done, so if we double jumped to get to the ledge we won't be able to perform another after
-			// but if we only jumped once into a ledge up we should be able to jump again after
-			Velocity.Z = ledgeUpVelocity.Z;	// Velocity XY will be slowly updated over time rather than suddenly
-			GravityScale = ledgeUpGravityScale;
-			m_bIsLedgingUp = true;
-			SetInternalMoveMode(EInternalMoveMode::IMOVE_LedgeUp);
-
-			if (LedgeUpFeedback)
+			m_ledgeEdgeCache = query.m_LedgeEdge;
+			m_ledgeSegmentCache = MakeTracedLedgeSegment(query.m_LedgeEdge, query.m_WallNormal, query.m_SurfaceNormal);
+			DeftMovementStats::AddCount(EDeftMovementCounter::LedgeCandidates);
+			if (query.m_bLedgeFound)
 			{
-				if (APlayerController* playerController = Cast<APlayerController>(CharacterOwner->Controller))
-				{
-					FForceFeedbackParameters feedbackParams;
-					playerController->ClientPlayForceFeedback(LedgeUpFeedback, feedbackParams);
-				}
+				m_ledgeHopUpLocationCache = query.m_HopUpLocation;
+				bLedgeFound = true;
 			}
-
-			//PerformLedgeUp();
 		}
 
-		UE_VLOG_SEGMENT(this, LogDeftLedge, Log, actorLocation, actorLocation + fwd * 1000.f, FColor::Magenta, TEXT("Actor Forward"));
+		UE_VLOG(this, LogDeftLedge, Log, TEXT("async ledge query %u consumed: age %llu frames, drift %.2f, fresh %d, found %d"), query.m_QueryId, age, drift, (int32)bFresh, (int32)query.m_bLedgeFound);
+		query.m_Stage = ELedgeAsyncStage::Idle;
+	}
+	else if (query.m_Stage != ELedgeAsyncStage::Idle && (GFrameCounter - query.m_StartFrame) > (uint64)FMath::Max(CVarLedgeAsyncMaxLatency.GetValueOnGameThread(), 1))
+	{
+		// the result would be stale by the time it arrives, start over from where we are now
+		CancelLedgeAsyncQuery();
+	}
 
-		// TODO: implement wall run up which will also trigger an automatic hop up at the top of ledges
+	// only one query is ever in flight
+	if (query.m_Stage == ELedgeAsyncStage::Idle)
+	{
+		StartLedgeAsyncQuery();
 	}
+
+	return bLedgeFound;
 }
 
-void UDeftMovementComponent::UpdateInternalMoveMode(float aDeltaTime)
+
+void UDeftMovementComponent::StartLedgeAsyncQuery()
 {
-	if (m_bInPlatformJump)
-	{
-		if (!m_bJumpApexReached)// TODO: might be unnecessary
-		{
-			// Keep track of the highest point the jump reaches
-			float distanceJumped = FMath::Abs(CharacterOwner->GetActorLocation().Z - m_PlatformJumpInitialPosition.Z);
-			m_PlatformJumpApex = FMath::Max(m_PlatformJumpApex, distanceJumped);
-		}
+	UWorld* world = GetWorld();
+	LedgeAsyncQuery& query = m_LedgeAsyncQuery;
+
+	const uint32 queryId = (query.m_QueryId + 1) & (MAX_uint32 >> 2);
+	query = LedgeAsyncQuery();
+	query.m_QueryId = queryId;
+	query.m_Stage = ELedgeAsyncStage::Probe;
+	query.m_StartFrame = GFrameCounter;
+	query.m_Origin = CharacterOwner->GetActorLocation();
+	query.m_Up = CharacterOwner->GetActorUpVector();
+	query.m_Rotation = CharacterOwner->GetActorRotation().Quaternion();
+
+	const FName profileName = CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName();
+
+	// same rays as CheckForWall, CheckForLedge and CheckLedgeSurface
+	const FDeftLedgeProbe probe = MakeLedgeProbe();
+	FVector wallRayStart, wallRayEnd, heightRayStart, heightRayEnd, floorRayStart, floorRayEnd;
+	probe.GetWallRay(wallRayStart, wallRayEnd);
+	probe.GetSpaceRay(heightRayStart, heightRayEnd);
+	probe.GetSurfaceRay(floorRayStart, floorRayEnd);
+	query.m_WallLocation = wallRayEnd;
+
+	query.m_PendingTraces = 3;
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries, 3);
+	world->AsyncLineTraceByProfile(EAsyncTraceType::Single, wallRayStart, wallRayEnd, profileName, m_CollisionQueryParams, &m_LedgeTraceDelegate, (queryId << 2) | LAT_Wall);
+	world->AsyncLineTraceByProfile(EAsyncTraceType::Single, heightRayStart, heightRayEnd, profileName, m_CollisionQueryParams, &m_LedgeTraceDelegate, (queryId << 2) | LAT_Space);
+	world->AsyncLineTraceByProfile(EAsyncTraceType::Single, floorRayStart, floorRayEnd, profileName, m_CollisionQueryParams, &m_LedgeTraceDelegate, (queryId << 2) | LAT_Surface);
+}
 
-		// Keep track of how long the jump input has been held
-		if (m_bIncrementJumpInputHoldTime)
-		{
-			m_JumpKeyHoldTime += aDeltaTime;
-		}
-	}
 
-	// indicates we've started falling because our velocity has switched directions or gone from pos to 0
-	if (Velocity.Z < 0.f)
-	{
-		OnJumpApexReached();
-	}
+void UDeftMovementComponent::StartLedgeClearanceQuery()
+{
+	LedgeAsyncQuery& query = m_LedgeAsyncQuery;
+	query.m_Stage = ELedgeAsyncStage::Clearance;
+	query.m_PendingTraces = 1;
+
+	// same test as CheckSpaceForCapsule, using the up vector from when the query was issued
+	FDeftLedgeProbe probe = MakeLedgeProbe();
+	probe.m_Up = query.m_Up;
+	FVector sweepStart, sweepEnd;
+	probe.GetClearanceSweep(query.m_SurfaceLocation, sweepStart, sweepEnd);
+
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	const FName profileName = CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName();
+	const uint32 userData = (query.m_QueryId << 2) | LAT_Clearance;
+	if (CVarLedgeClearanceOverlap.GetValueOnGameThread())
+		GetWorld()->AsyncOverlapByProfile(sweepStart, query.m_Rotation, profileName, m_CapsuleCollisionShapeCache, m_CollisionQueryParams, &m_LedgeOverlapDelegate, userData);
+	else
+		GetWorld()->AsyncSweepByProfile(EAsyncTraceType::Single, sweepStart, sweepEnd, query.m_Rotation, profileName, m_CapsuleCollisionShapeCache, m_CollisionQueryParams, &m_LedgeTraceDelegate, userData);
+}
 
-	if (m_InternalMoveMode == EInternalMoveMode::IMOVE_LedgeUp)
+
+void UDeftMovementComponent::CancelLedgeAsyncQuery()
+{
+	if (m_LedgeAsyncQuery.m_Stage == ELedgeAsyncStage::Idle)
+		return;
+
+	// bumping the id makes any results still in flight get ignored when they come back
+	m_LedgeAsyncQuery.m_QueryId = (m_LedgeAsyncQuery.m_QueryId + 1) & (MAX_uint32 >> 2);
+	m_LedgeAsyncQuery.m_Stage = ELedgeAsyncStage::Idle;
+}
+
+
+void UDeftMovementComponent::OnLedgeTraceCompleted(const FTraceHandle& aTraceHandle, FTraceDatum& aTraceDatum)
+{
+	LedgeAsyncQuery& query = m_LedgeAsyncQuery;
+	if ((aTraceDatum.UserData >> 2) != query.m_QueryId || query.m_PendingTraces == 0 || !CharacterOwner)
+		return;
+
+	const FHitResult* hit = (aTraceDatum.OutHits.Num() > 0 && aTraceDatum.OutHits[0].bBlockingHit) ? &aTraceDatum.OutHits[0] : nullptr;
+	switch (aTraceDatum.UserData & 0x3)
 	{
-		// apply forward velocity over time
-		// apply minimum forward velocity so even without input player still lands on ledge
-		FVector forwardVelocity = CharacterOwner->GetActorForwardVector() * LedgeUpForwardMinBoost /*TODO: this is really the speed*/ * aDeltaTime;
-		Velocity.X += forwardVelocity.X;
-		Velocity.Y += forwardVelocity.Y;
+		case LAT_Wall:
+			query.m_bWallHit = hit != nullptr;
+			if (hit)
+			{
+				query.m_WallLocation = hit->Location;
+				query.m_WallNormal = hit->Normal;
+			}
+			break;
+		case LAT_Space:
+			query.m_bSpaceHit = hit != nullptr;
+			break;
+		case LAT_Surface:
+			query.m_bSurfaceHit = hit != nullptr;
+			if (hit)
+			{
+				query.m_SurfaceLocation = hit->Location;
+				query.m_SurfaceNormal = hit->Normal;
+			}
+			break;
+		case LAT_Clearance:
+			query.m_bLedgeFound = hit == nullptr;
+			if (hit)
+				UE_VLOG_LOCATION(this, LogDeftLedge, Log, hit->Location, 5.f, FColor::Red, TEXT("Async Space Check Collision"));
+			break;
 	}
+
+	OnLedgeAsyncQueryReturned();
 }
 
 
-bool UDeftMovementComponent::FindLedge()
+void UDeftMovementComponent::OnLedgeOverlapCompleted(const FTraceHandle& aTraceHandle, FOverlapDatum& aOverlapDatum)
 {
-	FVector wallLocation;
-	if (!CheckForWall(wallLocation))
-		return false;
+	LedgeAsyncQuery& query = m_LedgeAsyncQuery;
+	if ((aOverlapDatum.UserData >> 2) != query.m_QueryId || query.m_PendingTraces == 0 || !CharacterOwner)
+		return;
 
-	FVector heightDistance;
-	if (!CheckForLedge(wallLocation, heightDistance))
-		return false;
+	// the overlap reports touches too, only a blocking one means the capsule doesn't fit
+	query.m_bLedgeFound = !aOverlapDatum.OutOverlaps.ContainsByPredicate([](const FOverlapResult& aOverlap) { return aOverlap.bBlockingHit; });
+	if (!query.m_bLedgeFound)
+		UE_VLOG_LOCATION(this, LogDeftLedge, Log, aOverlapDatum.Pos, 5.f, FColor::Red, TEXT("Async Space Check Collision"));
 
-	FVector ledgeSurfaceLocation, ledgeSurfaceNormal;
-	if (!CheckLedgeSurface(heightDistance, ledgeSurfaceLocation, ledgeSurfaceNormal))
-		return false;
+	OnLedgeAsyncQueryReturned();
+}
 
-	// Regardless if there's space I want to know where the edge is
-	FVector ledgeEdgeLocation;
-	GetLedgeEdge(ledgeSurfaceLocation, ledgeSurfaceNormal, wallLocation, ledgeEdgeLocation);
-	m_ledgeEdgeCache = ledgeEdgeLocation;
 
-	if (!CheckSpaceForCapsule(ledgeSurfaceLocation))
-		return false;
+void UDeftMovementComponent::OnLedgeAsyncQueryReturned()
+{
+	LedgeAsyncQuery& query = m_LedgeAsyncQuery;
+	if (--query.m_PendingTraces > 0)
+		return;
 
-	FVector hopUpLocation;
-	GetHopUpLocation(ledgeEdgeLocation, hopUpLocation);
-	m_ledgeHopUpLocationCache = hopUpLocation;
+	if (query.m_Stage == ELedgeAsyncStage::Probe)
+	{
+		// same early outs as the sync path: wall in front, open space above it, and a surface to stand on
+		query.m_bEdgeFound = query.m_bWallHit && !query.m_bSpaceHit && query.m_bSurfaceHit;
+		if (!query.m_bEdgeFound)
+		{
+			query.m_Stage = ELedgeAsyncStage::Complete;
+			return;
+		}
 
-	return true;
+		GetLedgeEdge(query.m_Origin, query.m_SurfaceLocation, query.m_SurfaceNormal, query.m_WallLocation, query.m_LedgeEdge);
+		StartLedgeClearanceQuery();
+	}
+	else if (query.m_Stage == ELedgeAsyncStage::Clearance)
+	{
+		if (query.m_bLedgeFound)
+			GetHopUpLocation(query.m_LedgeEdge, query.m_HopUpLocation);
+
+		query.m_Stage = ELedgeAsyncStage::Complete;
+	}
 }
 
 
 void UDeftMovementComponent::PerformLedgeUp()
 {
+	DEFT_MOVEMENT_SCOPE(PerformLedgeUp);
+
 	// TODO: maybe use a timer to set this to false
 	m_bIsLedgingUp = true;
 	GravityScale *= 2.f;
@@ -446,147 +1624,82 @@ void UDeftMovementComponent::PerformLedgeUp()
 	UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("gravity: %.2f"), gravity);
 
 	// Multiple angles will result in a valid solution, but choosing the shortest flight time makes sure we don't overshoot the target
-	struct FBestResult 
-	{
-		float shortestTime = FLT_MAX;
-		FVector bestLaunchVelocity = FVector::ZeroVector;
-		float bestAngle = 0.f;
-	} bestResult;
-
-	// numerical analysis: loop through angles to find a valid trajectory that clear the min height
-	for (float testAngle = 10.f; testAngle <= 80.f; testAngle += 5.f)
+	const FDeftLedgeLaunchSolution launch = DeftLedgeLaunch::SolveMinFlightTime(horizontalDistance, verticalDistance, gravity);
+	if (!launch.m_bValid)
 	{
-		// angle to rads
-		const float theta = FMath::DegreesToRadians(testAngle);
-
-		UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("\n\ttheta (deg): %.2f"), testAngle);
-
-		// Calculate initial velocity
-		// V0^2 = (g * d^2) / ( 2 * cos^2(theta) * (d * tan(theta) - (Yf - Y0)) )
-		const float numerator = gravity * horizontalDistance * horizontalDistance;
-		const float denom = 2 * FMath::Cos(theta) * FMath::Cos(theta) * ( horizontalDistance * FMath::Tan(theta) - verticalDistance);
-
-		if (FMath::IsNearlyEqual(denom, 0.f))
-		{
-			UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Error, TEXT("divide by zero detected when calculating velocity for angle %.2f"), testAngle);
-			continue;
-		}
-		const float velocitySquared = numerator / denom;
-
-		UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("numerator: %.2f"), numerator);
-		UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("denom: %.2f"), denom);
-		UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("velocitySquared: %.2f"), velocitySquared);
-
-		if (velocitySquared > 0.f)
-		{
-			// TODO: sqrt is slow, dont' do this
-			const float initialVelocity = FMath::Sqrt(velocitySquared);
-			UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("initialVelocity: %.2f"), initialVelocity);
-
-			// calculate maximum height of the projectile for this theta and velocity
-			const float maxHeight = (initialVelocity * initialVelocity * FMath::Sin(theta) * FMath::Sin(theta) ) / (2 * gravity);
-			UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("maxHeight: %.2f"), maxHeight);
-
-			// ensure the projectile clears the ledge
-			if (maxHeight >= verticalDistance)
-			{
-				// calculate velocity launch vector towards target from current position given initial velocity and theta
-				const FVector forwardVelocity = directionToTarget * (initialVelocity * FMath::Cos(theta));
-				UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("horizontal Velocity: %s"), *forwardVelocity.ToString());
-
-				const float upwardVelocity = initialVelocity * FMath::Sin(theta);
-				UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("upwardVelocity: %.2f"), upwardVelocity);
-				
-				const FVector launchVelocity = forwardVelocity + FVector(0.f, 0.f, upwardVelocity);
-				UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("launchVelocity: %s"), *launchVelocity.ToString());
-
-				// calculate time of flight
-				// t = ( V0 * sin(theta) + sqrt(V0 * sin^2(theta) + 2g(Yf - Y0)) ) / g
-				const float v0SinTheta = initialVelocity * FMath::Sin(theta);
-				const float flightTime = (v0SinTheta + FMath::Sqrt( (v0SinTheta * v0SinTheta) + (2 * gravity * verticalDistance) )) / gravity;
-				UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("flightTime: %.2f"), flightTime);
-
-				bool bNewBestFound = false;
-				if (flightTime < bestResult.shortestTime)									// prefer shorter flight times
-					bNewBestFound = true;
-				else if (FMath::IsNearlyEqual(flightTime, bestResult.shortestTime, 0.01f))	// same flight time, prefer larger angle to stay closer to target position
-				{
-					if (testAngle > bestResult.bestAngle)
-						bNewBestFound = true;
-				}
+		UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("no launch angle between %.0f and %.0f degrees reaches the hop up location"), DeftLedgeLaunch::MinAngle, DeftLedgeLaunch::MaxAngle);
+		return;
+	}
 
-				if (bNewBestFound)
-				{
-					bestResult.bestLaunchVelocity = launchVelocity;
-					bestResult.bestAngle = testAngle;
-					bestResult.shortestTime = flightTime;
-					UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("Found velocity [%.2f] at [%.2f] degrees with a shorter flighttime [%.2f]"), initialVelocity, bestResult.bestAngle, flightTime);
-				}
+	// launch along the ground towards the target, the vertical speed is solved separately
+	const FVector horizontalDirection = FVector(directionToTarget.X, directionToTarget.Y, 0.f).GetSafeNormal();
+	const FVector launchVelocity = horizontalDirection * launch.m_HorizontalSpeed + FVector(0.f, 0.f, launch.m_VerticalSpeed);
+	UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("launch: %.2f deg, speed %.2f, flight time %.2f"), launch.m_Angle, launch.m_Speed, launch.m_FlightTime);
 
-				// Still vizlog all of them
-				DebugLedgeLaunch(startLocation, launchVelocity, flightTime, UGameplayStatics::GetWorldDeltaSeconds(GetWorld()), FColor::Yellow);
-			}
-			else
-			{
-				UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("maxHeight (%.2f) < verticalDistance (%.2f), next angle"), maxHeight, verticalDistance);
-			}
-		}
-		else
-		{
-			UE_VLOG(this, LogDeftLedgeLaunchTrajectory, Log, TEXT("velocitySquared was <= 0.f, next angle"));
-		}
-	}
-	
-	// launch vector found to hop up the ledge!
-	if (!bestResult.bestLaunchVelocity.IsZero())
-	{
-		// make sure any previous velocity doesn't carry over
-		Velocity = FVector::ZeroVector;
-		// launches the player 
-		Launch(bestResult.bestLaunchVelocity);
-		DebugLedgeLaunch(startLocation, bestResult.bestLaunchVelocity, bestResult.shortestTime, UGameplayStatics::GetWorldDeltaSeconds(GetWorld()), FColor::Green);
-	}
+	// make sure any previous velocity doesn't carry over
+	Velocity = FVector::ZeroVector;
+	// launches the player 
+	Launch(launchVelocity);
+#if DEBUG_VIEW
+	if (m_LODSettings.m_bLedgeUpDebug)
+		DebugLedgeLaunch(startLocation, launchVelocity, launch.m_FlightTime, UGameplayStatics::GetWorldDeltaSeconds(GetWorld()), FColor::Green);
+#endif
 }
 
-bool UDeftMovementComponent::CheckForWall(FVector& outWallLocation)
+bool UDeftMovementComponent::CheckForWall(const LedgeQueryContext& aContext, FVector& outWallLocation, FHitResult* outHit)
 {
-	// inside actor capsule at half height
-	const FVector wallRayStart = CharacterOwner->GetActorLocation();
-	// extending in forward direction outwards
-	const FVector wallRayEnd = wallRayStart + CharacterOwner->GetActorForwardVector() * WallReach;
+	DEFT_MOVEMENT_SCOPE(CheckForWall);
+
+	// inside actor capsule at half height extending in forward direction outwards
+	FVector wallRayStart, wallRayEnd;
+	aContext.m_Probe.GetWallRay(wallRayStart, wallRayEnd);
 
 	// default to max reach in case we don't hit anything
 	outWallLocation = wallRayEnd;
 
 
 	FHitResult wallHit;
-	const bool bHitWall = GetWorld()->LineTraceSingleByProfile(wallHit, wallRayStart, wallRayEnd, CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName(), m_CollisionQueryParams);
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	const bool bHitWall = GetWorld()->LineTraceSingleByProfile(wallHit, wallRayStart, wallRayEnd, aContext.m_CollisionProfile, *aContext.m_QueryParams);
 	if (bHitWall)
 	{
 		// if we hit something that means there is a wall in front of us
 		outWallLocation = wallHit.Location;
-		DrawDebugLine(GetWorld(), wallRayStart,  wallRayEnd, FColor::Green);
-		DrawDebugSphere(GetWorld(), wallHit.Location, 5.f, 12, FColor::Blue);
+		if (outHit)
+			*outHit = wallHit;
+#if DEBUG_VIEW
+		if (DeftDebugOverlay::IsEnabled() && CVarDebugLedge.GetValueOnGameThread())
+		{
+			DrawDebugLine(GetWorld(), wallRayStart,  wallRayEnd, FColor::Green);
+			DrawDebugSphere(GetWorld(), wallHit.Location, 5.f, 12, FColor::Blue);
+		}
+#endif
 		UE_VLOG_SEGMENT(this, LogDeftLedge, Log, wallRayStart, wallRayEnd, FColor::Green, TEXT("Wall Reach"));
 		UE_VLOG_LOCATION(this, LogDeftLedge, Log, outWallLocation, 5.f, FColor::Green, TEXT("Wall hit location"));
 		return true;
 	}
 
-	DrawDebugLine(GetWorld(), wallRayStart, wallRayEnd, FColor::Red);
+#if DEBUG_VIEW
+	if (DeftDebugOverlay::IsEnabled() && CVarDebugLedge.GetValueOnGameThread())
+		DrawDebugLine(GetWorld(), wallRayStart, wallRayEnd, FColor::Red);
+#endif
 	UE_VLOG_SEGMENT(this, LogDeftLedge, Log, wallRayStart, wallRayEnd, FColor::Red, TEXT("Wall Reach"));
 	return false;
 }
 
-bool UDeftMovementComponent::CheckForLedge(const FVector& aWallLocation, FVector& outHeightDistance)
+bool UDeftMovementComponent::CheckForLedge(const LedgeQueryContext& aContext, const FVector& aWallLocation, FVector& outHeightDistance)
 {
-	const FVector heightRayStart = CharacterOwner->GetActorLocation() + (CharacterOwner->GetActorUpVector() * LedgeHeightOrigin);
-	const FVector heightRayEnd = heightRayStart + CharacterOwner->GetActorForwardVector() * LedgeHeightForwardReach;
+	DEFT_MOVEMENT_SCOPE(CheckForLedge);
+
+	FVector heightRayStart, heightRayEnd;
+	aContext.m_Probe.GetSpaceRay(heightRayStart, heightRayEnd);
 
 	// we want this to be the max distance to make sure there is a ledge beneath that's at least wide enough for the character to stand
 	outHeightDistance = heightRayEnd;
 
-	FHitResult wallHit;
-	const bool bHitAnything = GetWorld()->LineTraceSingleByProfile(wallHit, heightRayStart, heightRayEnd, CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName(), m_CollisionQueryParams);
+	// only whether anything is there matters, so the trace can stop at the first blocking hit instead of finding the closest
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	const bool bHitAnything = GetWorld()->LineTraceTestByProfile(heightRayStart, heightRayEnd, aContext.m_CollisionProfile, *aContext.m_QueryParams);
 	if (!bHitAnything)
 	{
 		// no hit means open space above the player which indicates a ledge
@@ -596,26 +1709,30 @@ bool UDeftMovementComponent::CheckForLedge(const FVector& aWallLocation, FVector
 
 	// if we hit something there is no open space above the player so there is no ledge
 	UE_VLOG_SEGMENT(this, LogDeftLedge, Log, heightRayStart, heightRayEnd, FColor::Red, TEXT("Space Reach"));
-	UE_VLOG_LOCATION(this, LogDeftLedge, Log, wallHit.Location, 5.f, FColor::Red, TEXT("Space hit location"));
 	return false;
 }
 
-bool UDeftMovementComponent::CheckLedgeSurface(const FVector& aFloorCheckHeightOrigin, FVector& outFloorLocation, FVector& outFloorNormal)
+bool UDeftMovementComponent::CheckLedgeSurface(const LedgeQueryContext& aContext, const FVector& aFloorCheckHeightOrigin, FVector& outFloorLocation, FVector& outFloorNormal, FHitResult* outHit)
 {
+	DEFT_MOVEMENT_SCOPE(CheckLedgeSurface);
+
 	const FVector floorRayStart = aFloorCheckHeightOrigin;
-	const FVector floorRayEnd = floorRayStart - CharacterOwner->GetActorUpVector() * LedgeHeightOrigin * 2; // check for a floor twice as far just to see if we hit something
+	const FVector floorRayEnd = floorRayStart - aContext.m_Probe.m_Up * LedgeHeightOrigin * 2; // check for a floor twice as far just to see if we hit something
 
 	// default to max reach distance in case we don't hit anything
 	outFloorLocation = floorRayEnd;
 	outFloorNormal = FVector::ZeroVector;
 
 	FHitResult floorHit;
-	const bool bHitFloor = GetWorld()->LineTraceSingleByProfile(floorHit, floorRayStart, floorRayEnd, CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName(), m_CollisionQueryParams);
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	const bool bHitFloor = GetWorld()->LineTraceSingleByProfile(floorHit, floorRayStart, floorRayEnd, aContext.m_CollisionProfile, *aContext.m_QueryParams);
 	if (bHitFloor)
 	{
 		// hitting the floor means there is a ledge at least wide enough for us to stand on
 		outFloorLocation = floorHit.Location;
 		outFloorNormal = floorHit.Normal;
+		if (outHit)
+			*outHit = floorHit;
 		UE_VLOG_SEGMENT(this, LogDeftLedge, Log, floorRayStart, floorRayEnd, FColor::Green, TEXT("Floor Reach"));
 		UE_VLOG_LOCATION(this, LogDeftLedge, Log, outFloorLocation, 5.f, FColor::Green, TEXT("Floor hit location"));
 		return true;
@@ -628,22 +1745,36 @@ bool UDeftMovementComponent::CheckLedgeSurface(const FVector& aFloorCheckHeightO
 }
 
 
-bool UDeftMovementComponent::CheckSpaceForCapsule(const FVector& aFloorLocation)
+bool UDeftMovementComponent::CheckSpaceForCapsule(const LedgeQueryContext& aContext, const FVector& aFloorLocation)
 {
-	const UCapsuleComponent* capsuleComponent = CharacterOwner->GetCapsuleComponent();
-	const float capsuleHalfHeight = capsuleComponent->GetScaledCapsuleHalfHeight();
+	DEFT_MOVEMENT_SCOPE(CheckSpaceForCapsule);
 
-	// shape sweep needs to physically sweep _some_ distance, it can't be exactly the same.
-	const FVector capsuleBase = aFloorLocation + CharacterOwner->GetActorUpVector().GetSafeNormal() * 1.5f;				// start sweep: floor location raised by a tiny amount so we don't collide with the floor
-	const FVector capsuleBaseSlightlyHigher = capsuleBase + CharacterOwner->GetActorUpVector().GetSafeNormal() * 1.5f;	// end sweep: slightly above the start location again just because UE requires it to be different
+	// capsule base raised a tiny amount above the floor so we don't collide with it, swept a tiny amount up because UE requires the ends to differ
+	FVector sweepStart, sweepEnd;
+	aContext.m_Probe.GetClearanceSweep(aFloorLocation, sweepStart, sweepEnd);
 
 	// Vizlog specifies the BASE location of the capsule
 	//UE_VLOG_CAPSULE(this, LogDeftLedge, Log, capsuleBase, capsuleComponent->GetScaledCapsuleHalfHeight(), capsuleComponent->GetScaledCapsuleRadius(), CharacterOwner->GetActorRotation().Quaternion(), FColor::White, TEXT("Space Sweep Start"));
 	//UE_VLOG_CAPSULE(this, LogDeftLedge, Log, capsuleBaseSlightlyHigher, capsuleComponent->GetScaledCapsuleHalfHeight(), capsuleComponent->GetScaledCapsuleRadius(), CharacterOwner->GetActorRotation().Quaternion(), FColor::Yellow, TEXT("Space Sweep End"));
 
+	DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries);
+	if (aContext.m_bClearanceOverlap)
+	{
+		// the sweep only ever moves 1.5 cm so all it really answers is whether the capsule starts out overlapping something,
+		// an overlap test answers that directly without sweeping or building a hit result
+		if (!GetWorld()->OverlapBlockingTestByProfile(sweepStart, aContext.m_Rotation, aContext.m_CollisionProfile, m_CapsuleCollisionShapeCache, *aContext.m_QueryParams))
+		{
+			UE_VLOG(this, LogDeftLedge, Log, TEXT("CheckSpaceForCapsule: Player will fit"));
+			return true;
+		}
+
+		UE_VLOG(this, LogDeftLedge, Log, TEXT("CheckSpaceForCapsule: Capsule overlaps something"));
+		UE_VLOG_LOCATION(this, LogDeftLedge, Log, sweepStart, 5.f, FColor::Red, TEXT("Space Check Collision"));
+		return false;
+	}
+
 	FHitResult hitAnything;
-	// sweep puts the CENTER of the capsule at the start and end locations so we have to raise them by half height to have the BASE be at the start and end height
-	const bool bHitAnything = GetWorld()->SweepSingleByProfile(hitAnything, capsuleBase + capsuleHalfHeight, capsuleBaseSlightlyHigher + capsuleHalfHeight, CharacterOwner->GetActorRotation().Quaternion(), CharacterOwner->GetCapsuleComponent()->GetCollisionProfileName(), m_CapsuleCollisionShapeCache, m_CollisionQueryParams);
+	const bool bHitAnything = GetWorld()->SweepSingleByProfile(hitAnything, sweepStart, sweepEnd, aContext.m_Rotation, aContext.m_CollisionProfile, m_CapsuleCollisionShapeCache, *aContext.m_QueryParams);
 	if (!bHitAnything)
 	{
 		// not hitting anything means there's enough space for the character's capsule with a little wiggle room
@@ -659,24 +1790,24 @@ bool UDeftMovementComponent::CheckSpaceForCapsule(const FVector& aFloorLocation)
 }
 
 
-void UDeftMovementComponent::GetLedgeEdge(const FVector& aFloorLocation, const FVector& aFloorNormal, FVector& aWallLocation, FVector& outLedgeEdge)
+void UDeftMovementComponent::GetLedgeEdge(const FVector& aViewerLocation, const FVector& aFloorLocation, const FVector& aFloorNormal, FVector& aWallLocation, FVector& outLedgeEdge)
 {
-	// starting from the floor location
-	// find a vector perpendicular to the floor's normal which should give us the surface
-	const FVector dirFloorToPlayer = CharacterOwner->GetActorLocation() - aFloorLocation;
+	outLedgeEdge = FDeftLedgeProbe::GetLedgeEdge(aViewerLocation, aFloorLocation, aFloorNormal, aWallLocation);
+
+	// floor axis only needed for visualization
 	const FVector floorUp = aFloorNormal;
-	const FVector floorRight = floorUp.Cross(dirFloorToPlayer);
+	const FVector floorRight = floorUp.Cross(aViewerLocation - aFloorLocation);
 	const FVector floorForward = floorRight.Cross(floorUp);
 
-	const FVector dirToWall = aWallLocation - aFloorLocation;
-	const FVector projWallDirOntoFloorSurface = (dirToWall.Dot(floorForward) / floorForward.Dot(floorForward)) * floorForward;
-	const float distToEdge = projWallDirOntoFloorSurface.Length();
-	outLedgeEdge = aFloorLocation + floorForward.GetSafeNormal() * distToEdge;
-
 	// draw floor axis
-	DrawDebugLine(GetWorld(), aFloorLocation, aFloorLocation + floorUp * 100.f, FColor::Cyan);
-	DrawDebugLine(GetWorld(), aFloorLocation, aFloorLocation + floorRight * 100.f, FColor::Green);
-	DrawDebugLine(GetWorld(), aFloorLocation, aFloorLocation + floorForward * 100.f, FColor::Red);
+#if DEBUG_VIEW
+	if (DeftDebugOverlay::IsEnabled() && CVarDebugLedge.GetValueOnGameThread())
+	{
+		DrawDebugLine(GetWorld(), aFloorLocation, aFloorLocation + floorUp * 100.f, FColor::Cyan);
+		DrawDebugLine(GetWorld(), aFloorLocation, aFloorLocation + floorRight * 100.f, FColor::Green);
+		DrawDebugLine(GetWorld(), aFloorLocation, aFloorLocation + floorForward * 100.f, FColor::Red);
+	}
+#endif
 
 	//UE_VLOG_SEGMENT(this, LogDeftLedge, Log, aFloorLocation, aFloorLocation + projWallDirOntoFloorSurface, FColor::Cyan, TEXT("Proj Wall Dir Onto Floor"));
 	//UE_VLOG_SEGMENT(this, LogDeftLedge, Log, aFloorLocation, aFloorLocation + dirToWall.GetSafeNormal() * dirToWall.Length(), FColor::Cyan, TEXT("Floor To Wall Location"));
@@ -704,38 +1835,77 @@ void UDeftMovementComponent::GetHopUpLocation(const FVector& aLedgeEdge, FVector
 
 void UDeftMovementComponent::OnJumpApexReached()
 {
-	UE_LOG(LogTemp, Warning, TEXT("apex reached"));
+	// only once per jump, the locks below would be released again otherwise
+	if (m_bJumpApexReached)
+		return;
+
 	m_bJumpApexReached = true;
 	m_bIncrementJumpInputHoldTime = false;
 	m_JumpKeyHoldTime = 0.f;
 	GravityScale = m_PostJumpGravityScale;
 
-	if (m_InternalMoveMode == EInternalMoveMode::IMOVE_LedgeUp && DeftLocks::IsMoveInputForwardBackLocked())
+	if (m_InternalMoveMode == EInternalMoveMode::IMOVE_LedgeUp)
 	{
-		DeftLocks::DecrementMoveInputForwardBackLockRef();
+		m_LedgeUpLock.Release(EDeftLock::MoveInputForwardBack);
 	}
 
 	if (m_InternalMoveMode == EInternalMoveMode::IMOVE_AirDash)
 	{
-		DeftLocks::DecrementMoveInputForwardBackLockRef();
-		DeftLocks::DecrementMoveInputRightLeftLockRef();
+		m_AirDashLock.Release();
 	}
 
 #if DEBUG_VIEW
 	m_PlatformJumpDebug.m_GravityValues.Add(m_DefaultGravityZCache * GravityScale);
 #endif
+
+	BroadcastMovementEvent(EDeftMovementEvent::ApexReached);
 }
 
 
 FVector UDeftMovementComponent::CalculateJumpInitialVelocity(float aTime, float aHeight)
 {
 	// TODO: return more than just Z
-	return FVector(0.f, 0.f, (2 * aHeight) / aTime);
+	return FVector(0.f, 0.f, DeftJumpKinematics::CalculateInitialVelocityZ(aTime, aHeight));
 }
 
 float UDeftMovementComponent::CalculateJumpGravityScale(float aTime, float aHeight)
 {
-	return ((-2 * aHeight) / (aTime * aTime)) / m_DefaultGravityZCache;
+	return DeftJumpKinematics::CalculateGravityScale(aTime, aHeight, m_DefaultGravityZCache);
+}
+
+FDeftJumpTuning UDeftMovementComponent::GetJumpTuning() const
+{
+	FDeftJumpTuning tuning;
+	tuning.m_JumpMaxHeight = JumpMaxHeight;
+	tuning.m_TimeToJumpMaxHeight = TimeToJumpMaxHeight;
+	tuning.m_JumpMinHeight = JumpMinHeight;
+	tuning.m_PostTimeToJumpMaxHeight = PostTimeToJumpMaxHeight;
+	tuning.m_JumpKeyMaxHoldTime = JumpKeyMaxHoldTime;
+	tuning.m_AirDashDistance = AirDashDistance;
+	tuning.m_AirDashTime = AirDashTime;
+	tuning.m_AirDashVerticalHeight = AirDashVerticalHeight;
+	tuning.m_DefaultGravityZ = m_DefaultGravityZCache;
+	return tuning;
+}
+
+void UDeftMovementComponent::FillMassJumpTuning(FDeftMassJumpTuningFragment& outTuning) const
+{
+	outTuning.JumpMaxHeight = JumpMaxHeight;
+	outTuning.TimeToJumpMaxHeight = TimeToJumpMaxHeight;
+	outTuning.JumpMinHeight = JumpMinHeight;
+	outTuning.PostTimeToJumpMaxHeight = PostTimeToJumpMaxHeight;
+	outTuning.JumpKeyMaxHoldTime = JumpKeyMaxHoldTime;
+	outTuning.AirDashDistance = AirDashDistance;
+	outTuning.AirDashTime = AirDashTime;
+	outTuning.AirDashVerticalHeight = AirDashVerticalHeight;
+	outTuning.AirDashExitDeceleration = AirDashExitDeceleration;
+	outTuning.DefaultGravityZ = UPhysicsSettings::Get()->DefaultGravityZ;
+	outTuning.DefaultGravityScale = GravityScale;
+	outTuning.MaxSpeed = MaxWalkSpeed;
+	outTuning.TerminalVelocity = GetDefault<APhysicsVolume>()->TerminalVelocity;
+	outTuning.MaxStepHeight = MaxStepHeight;
+	outTuning.WalkableFloorZ = GetWalkableFloorZ();
+	outTuning.JumpInputMax = m_JumpInputMax;
 }
 
 
@@ -744,11 +1914,9 @@ void UDeftMovementComponent::ResetJump()
 	m_InternalMoveMode = EInternalMoveMode::IMOVE_None;
 
 	// reset ledge up v2
+	m_LedgeUpLock.Release();
 	if (m_bIsLedgingUp)
-	{
-		DeftLocks::DecrementMoveInputRightLeftLockRef();
-		DeftLocks::DecrementMoveInputForwardBackLockRef();
-	}
+		BroadcastMovementEvent(EDeftMovementEvent::LedgeUpEnded);
 	m_bIsLedgingUp = false; // TODO: might want its own reset
 
 	// reset jump
@@ -756,6 +1924,9 @@ void UDeftMovementComponent::ResetJump()
 	m_bJumpApexReached = false;
 	GravityScale = m_DefaultGravityScaleCache;
 
+	// reset air dash
+	m_AirDashLock.Release();
+
 	// reset falling
 	m_bIsFallOriginSet = false;
 	m_FallOrigin = FVector::ZeroVector;
@@ -763,24 +1934,107 @@ void UDeftMovementComponent::ResetJump()
 	// reset ledge up
 	m_ledgeHopUpLocationCache = FVector::ZeroVector;
 	m_ledgeEdgeCache = FVector::ZeroVector;
+	m_ledgeSegmentCache = LedgeSegment();
+	m_LedgeCache.m_bValid = false;
+	m_bLedgeInReach = false;
+	CancelLedgeAsyncQuery();
+}
+
+void UDeftMovementComponent::RestoreMoveLocks()
+{
+	// StartLedgeUp locks all move input, the apex gives forward/back back
+	if (m_InternalMoveMode != EInternalMoveMode::IMOVE_LedgeUp)
+		m_LedgeUpLock.Release();
+	else if (!m_LedgeUpLock.IsHeld(EDeftLock::MoveInputRightLeft) || (!m_bJumpApexReached && !m_LedgeUpLock.IsHeld(EDeftLock::MoveInputForwardBack)))
+		m_LedgeUpLock = m_DeftLocks.Acquire(m_bJumpApexReached ? EDeftLock::MoveInputRightLeft : EDeftLock::AllMoveInput, TEXT("LedgeUp"));
+	else if (m_bJumpApexReached)
+		m_LedgeUpLock.Release(EDeftLock::MoveInputForwardBack);
+
+	// PerformAirDash locks all move input until the apex
+	if (m_InternalMoveMode != EInternalMoveMode::IMOVE_AirDash || m_bJumpApexReached)
+		m_AirDashLock.Release();
+	else if (!m_AirDashLock.IsHeld(EDeftLock::AllMoveInput))
+		m_AirDashLock = m_DeftLocks.Acquire(EDeftLock::AllMoveInput, TEXT("AirDash"));
+}
+
+void UDeftMovementComponent::FillAnimState(FDeftAnimMovementState& outState) const
+{
+	outState.Velocity = Velocity;
+	outState.GroundSpeed = Velocity.Size2D();
+	outState.VerticalSpeed = Velocity.Z;
+	outState.JumpCount = m_JumpInputCounter;
+	outState.bIsJumpButtonDown = m_bIsJumpButtonDown;
+	outState.bJumpApexReached = m_bJumpApexReached;
+	outState.bHasAirDashed = m_bHasAirDashed;
+
+	if (IsLedgeHanging())
+	{
+		outState.MoveMode = EDeftAnimMoveMode::LedgeHang;
+		outState.LedgeEdge = FMath::ClosestPointOnSegment(UpdatedComponent->GetComponentLocation(), m_LedgeHangSegment.m_Start, m_LedgeHangSegment.m_End);
+		return;
+	}
+
+	outState.LedgeEdge = m_ledgeEdgeCache;
+	if (IsAirDashing())
+		outState.MoveMode = EDeftAnimMoveMode::AirDash;
+	else if (!IsFalling())
+		outState.MoveMode = EDeftAnimMoveMode::Grounded;
+	else if (m_bIsLedgingUp)
+		outState.MoveMode = EDeftAnimMoveMode::LedgeUp;
+	else if (m_bInPlatformJump && !m_bJumpApexReached)
+		outState.MoveMode = EDeftAnimMoveMode::Jumping;
+	else
+		outState.MoveMode = EDeftAnimMoveMode::Falling;
+}
+
+void UDeftMovementComponent::BroadcastMovementEvent(EDeftMovementEvent aEvent)
+{
+	// replays re-simulate moves that already raised their events
+	if (bClientUpdating)
+		return;
+
+	UE_VLOG(this, LogDeftMovement, Log, TEXT("movement event %d"), (int32)aEvent);
+	m_OnMovementEvent.Broadcast(this, aEvent);
 }
 
 #if DEBUG_VIEW
 void UDeftMovementComponent::DrawDebug()
 {
-	GEngine->ClearOnScreenDebugMessages();
+	DrawLockDebug();
+	DrawLedgeCacheDebug();
+
+	DeftDebugOverlay::AddHeader(TEXT("-Toggles-"), FColor::White);
+	DeftDebugOverlay::AddBool(TEXT("d.DebugMovement"), CVarDebugLocomotion.GetValueOnGameThread(), CVarDebugLocomotion.GetValueOnGameThread() ? FColor::Yellow : FColor::White);
+	DeftDebugOverlay::AddBool(TEXT("d.DebugJump"), CVarDebugJump.GetValueOnGameThread(), CVarDebugJump.GetValueOnGameThread() ? FColor::Yellow : FColor::White);
+	DeftDebugOverlay::AddBool(TEXT("d.DebugLedge"), CVarDebugLedge.GetValueOnGameThread(), CVarDebugLedge.GetValueOnGameThread() ? FColor::Yellow : FColor::White);
+	DeftDebugOverlay::AddBool(TEXT("d.UseUEJump"), CVarUseUEJump.GetValueOnGameThread(), CVarUseUEJump.GetValueOnGameThread() ? FColor::Yellow : FColor::White);
+	DeftDebugOverlay::AddBool(TEXT("d.EnablePostJumpGravity"), CVarEnablePostJumpGravity.GetValueOnGameThread(), CVarEnablePostJumpGravity.GetValueOnGameThread() ? FColor::Yellow : FColor::White);
 
-	if (CVarDebugLocomotion.GetValueOnGameThread())
-		DebugMovement();
 	if (CVarDebugJump.GetValueOnGameThread())
 		DebugPlatformJump();
+	if (CVarDebugLocomotion.GetValueOnGameThread())
+		DebugMovement();
+}
 
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, CVarDebugLocomotion.GetValueOnGameThread() ? FColor::Yellow : FColor::White, FString::Printf(TEXT("d.DebugMovement: %d"), (int32)CVarDebugLocomotion.GetValueOnGameThread()));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01, CVarDebugJump.GetValueOnGameThread() ? FColor::Yellow : FColor::White, FString::Printf(TEXT("d.DebugJump: %d"), (int32)CVarDebugJump.GetValueOnGameThread()));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01, CVarUseUEJump.GetValueOnGameThread() ? FColor::Yellow : FColor::White, FString::Printf(TEXT("d.UseUEJump: %d"), (int32)CVarUseUEJump.GetValueOnGameThread()));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01, CVarEnablePostJumpGravity.GetValueOnGameThread() ? FColor::Yellow : FColor::White, FString::Printf(TEXT("d.EnablePostJumpGravity: %d"), (int32)CVarEnablePostJumpGravity.GetValueOnGameThread()));
+void UDeftMovementComponent::DrawLockDebug()
+{
+	const DeftLocks::Stats lockStats = m_DeftLocks.GetStats();
+	DeftDebugOverlay::AddHeader(TEXT("-Locks-"), FColor::White);
+	DeftDebugOverlay::AddInt(TEXT("Move Input Forward/Back"), m_DeftLocks.GetLockCount(EDeftLock::MoveInputForwardBack), m_DeftLocks.IsMoveInputForwardBackLocked() ? FColor::Red : FColor::White);
+	DeftDebugOverlay::AddInt(TEXT("Move Input Right/Left"), m_DeftLocks.GetLockCount(EDeftLock::MoveInputRightLeft), m_DeftLocks.IsMoveInputRightLeftLocked() ? FColor::Red : FColor::White);
+	DeftDebugOverlay::AddInt(TEXT("acquired"), lockStats.m_Acquires);
+	DeftDebugOverlay::AddInt(TEXT("released"), lockStats.m_Releases);
+	DeftDebugOverlay::AddInt(TEXT("stale"), lockStats.m_StaleReleases);
+	DeftDebugOverlay::AddInt(TEXT("leaks"), lockStats.m_LeaksDetected, lockStats.m_LeaksDetected > 0 ? FColor::Orange : FColor::White);
+}
 
-	DeftLocks::DrawLockDebug();
+void UDeftMovementComponent::DrawLedgeCacheDebug()
+{
+	const uint32 lookups = m_LedgeCache.m_Hits + m_LedgeCache.m_Misses;
+	DeftDebugOverlay::AddHeader(TEXT("-Ledge Cache-"), FColor::White);
+	DeftDebugOverlay::AddInt(TEXT("hits"), m_LedgeCache.m_Hits);
+	DeftDebugOverlay::AddInt(TEXT("misses"), m_LedgeCache.m_Misses);
+	DeftDebugOverlay::AddFloat(TEXT("hit rate %"), lookups > 0 ? 100.f * m_LedgeCache.m_Hits / lookups : 0.f);
 }
 
 void UDeftMovementComponent::DebugMovement()
@@ -812,7 +2066,7 @@ void UDeftMovementComponent::DebugMovement()
 	DrawDebugSphere(GetWorld(), rightFoot + actorUp * -1 * (capsulHalfHeight - footRadius), footRadius, 12, FColor::Yellow);
 	DrawDebugSphere(GetWorld(), leftFoot + actorUp * -1 * (capsulHalfHeight - footRadius), footRadius, 12, FColor::Yellow);
 
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, FColor::White, FString::Printf(TEXT("\tVelocity %s"), *Velocity.ToString()));
+	DeftDebugOverlay::AddVector(TEXT("Velocity"), Velocity);
 
 	UE_VLOG_CAPSULE(this, LogDeftMovement, Log, CharacterOwner->GetActorLocation() - CharacterOwner->GetActorUpVector() * capsulHalfHeight, capsulHalfHeight, capsulComponent->GetScaledCapsuleRadius(), CharacterOwner->GetActorRotation().Quaternion(), FColor::White, TEXT(""));
 }
@@ -863,25 +2117,22 @@ void UDeftMovementComponent::DebugLedgeLaunch(const FVector& aStartLocation, con
 
 void UDeftMovementComponent::DebugPlatformJump()
 {
-	if (!GEngine)
-		return;
-
-
-	GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::White, FString::Printf(TEXT("\tJumpInputCounter: %d"), m_JumpInputCounter));
-	GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::White, FString::Printf(TEXT("\tJumpHoldTime: %.2f"), m_JumpKeyHoldTime));
-	GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::White, FString::Printf(TEXT("\tPost Jump Gravity Scale: %.2f"), m_PostJumpGravityScale));
-	GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::White, FString::Printf(TEXT("\tMin Gravity Scale: %.2f"), m_MinPreJumpGravityScale));
-	GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::White, FString::Printf(TEXT("\tMax Gravity Scale: %.2f"), m_MaxPreJumpGravityScale));
-	GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::White, FString::Printf(TEXT("\tGravity Scale: %.2f"), GravityScale));
-
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, FColor::White, FString::Printf(TEXT("\tJump Apex: %.2f"), m_PlatformJumpApex));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, FColor::White, FString::Printf(TEXT("\tJump Initial Pos: %s"), *m_PlatformJumpInitialPosition.ToString()));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, FColor::White, FString::Printf(TEXT("\tInitial Velocity: %.2f"), m_PlatformJumpDebug.m_InitialVelocity));
-
 	const bool bUsePostJumpGravity = CVarEnablePostJumpGravity.GetValueOnGameThread();
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, bUsePostJumpGravity ? FColor::Green : FColor::Red, FString::Printf(TEXT("Post Jump Gravity: %s"), bUsePostJumpGravity ? TEXT("Enabled") : TEXT("Disabled")));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, m_bInPlatformJump ? FColor::Green : FColor::White, FString::Printf(TEXT("Jump State %s\nFrom %s"), m_bInPlatformJump ? TEXT("In Jump") : TEXT("Not Jumping"), IsAttemptingDoubleJump() ? TEXT("Mid Air") : TEXT("Solid Ground")));
-	GEngine->AddOnScreenDebugMessage(-1, 0.01f, FColor::Cyan, TEXT("\n-Gravity Scaled Jump-"));
+	DeftDebugOverlay::AddHeader(TEXT("-Gravity Scaled Jump-"));
+	DeftDebugOverlay::AddText(TEXT("Jump State"), m_bInPlatformJump ? TEXT("In Jump") : TEXT("Not Jumping"), m_bInPlatformJump ? FColor::Green : FColor::White);
+	DeftDebugOverlay::AddText(TEXT("From"), IsAttemptingDoubleJump() ? TEXT("Mid Air") : TEXT("Solid Ground"), m_bInPlatformJump ? FColor::Green : FColor::White);
+	DeftDebugOverlay::AddText(TEXT("Post Jump Gravity"), bUsePostJumpGravity ? TEXT("Enabled") : TEXT("Disabled"), bUsePostJumpGravity ? FColor::Green : FColor::Red);
+
+	DeftDebugOverlay::AddFloat(TEXT("Initial Velocity"), m_PlatformJumpDebug.m_InitialVelocity);
+	DeftDebugOverlay::AddVector(TEXT("Jump Initial Pos"), m_PlatformJumpInitialPosition);
+	DeftDebugOverlay::AddFloat(TEXT("Jump Apex"), m_PlatformJumpApex);
+
+	DeftDebugOverlay::AddFloat(TEXT("Gravity Scale"), GravityScale);
+	DeftDebugOverlay::AddFloat(TEXT("Max Gravity Scale"), m_MaxPreJumpGravityScale);
+	DeftDebugOverlay::AddFloat(TEXT("Min Gravity Scale"), m_MinPreJumpGravityScale);
+	DeftDebugOverlay::AddFloat(TEXT("Post Jump Gravity Scale"), m_PostJumpGravityScale);
+	DeftDebugOverlay::AddFloat(TEXT("JumpHoldTime"), m_JumpKeyHoldTime);
+	DeftDebugOverlay::AddInt(TEXT("JumpInputCounter"), m_JumpInputCounter);
 	
 	DebugPhysFalling();
 }
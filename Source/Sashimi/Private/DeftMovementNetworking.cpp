@@ -0,0 +1,224 @@
+#include "DeftMovementNetworking.h"
+#include "DeftMovementComponent.h"
+#include "DeftJumpKinematics.h"
+#include "GameFramework/Character.h"
+#include "EngineUtils.h"
+
+void FSavedMove_Deft::Clear()
+{
+	Super::Clear();
+
+	m_bJumpHeld = false;
+	m_bWantsToAirDash = false;
+	m_bLedgeUp = false;
+	m_QuantizedJumpHoldTime = 0;
+
+	m_bWasJumpButtonDown = false;
+	m_bIncrementJumpInputHoldTime = false;
+	m_bInPlatformJump = false;
+	m_bJumpApexReached = false;
+	m_bHasAirDashed = false;
+	m_JumpInputCounter = 0;
+	m_AirDashElapsed = 0.f;
+	m_AirDashDirection = FVector::ZeroVector;
+	m_JumpKeyHoldTime = 0.f;
+	m_GravityScale = 0.f;
+	m_bIsLedgingUp = false;
+	m_InternalMoveMode = IMOVE_None;
+	m_LedgeHangStart = FVector::ZeroVector;
+	m_LedgeHangEnd = FVector::ZeroVector;
+	m_LedgeHangWallNormal = FVector::ZeroVector;
+	m_LedgeHangSurfaceNormal = FVector::UpVector;
+	m_bLedgeHangBaked = false;
+}
+
+uint8 FSavedMove_Deft::GetCompressedFlags() const
+{
+	uint8 flags = Super::GetCompressedFlags();
+	if (m_bJumpHeld)
+		flags |= FLAG_JumpHeld;
+	if (m_bWantsToAirDash)
+		flags |= FLAG_AirDash;
+	if (m_bLedgeUp)
+		flags |= FLAG_LedgeUp;
+	return flags;
+}
+
+bool FSavedMove_Deft::CanCombineWith(const FSavedMovePtr& aNewMove, ACharacter* aCharacter, float aMaxDelta) const
+{
+	const FSavedMove_Deft* newMove = static_cast<const FSavedMove_Deft*>(aNewMove.Get());
+
+	// Only inputs refuse here, CombineWith rolls the jump, dash and ledge state back to this move's start so moves holding
+	// the same input merge whatever that state does in between. Hold time is allowed to differ, the combined move sends the
+	// newest one and it only matters on the release move.
+	// Pressing or releasing jump takes effect at the start of the move, combined it would start a whole move early
+	if (m_bJumpHeld != newMove->m_bJumpHeld)
+		return false;
+	// same for the dash, and a pending move's request would be lost since the combined move sends the new move's flags
+	if (m_bWantsToAirDash || newMove->m_bWantsToAirDash)
+		return false;
+	// the server spaces its ledge probes over the length of the move, over a longer one it can find the ledge somewhere else
+	if (m_bLedgeUp || newMove->m_bLedgeUp)
+		return false;
+
+	return Super::CanCombineWith(aNewMove, aCharacter, aMaxDelta);
+}
+
+void FSavedMove_Deft::SetMoveFor(ACharacter* aCharacter, float aInDeltaTime, FVector const& aNewAccel, FNetworkPredictionData_Client_Character& aClientData)
+{
+	// captures the start state through SetInitialPosition
+	Super::SetMoveFor(aCharacter, aInDeltaTime, aNewAccel, aClientData);
+
+	const UDeftMovementComponent* movementComponent = Cast<UDeftMovementComponent>(aCharacter->GetCharacterMovement());
+	if (!movementComponent)
+		return;
+
+	m_bJumpHeld = movementComponent->m_bIsJumpButtonDown;
+	m_bWantsToAirDash = movementComponent->m_bWantsToAirDash;
+	m_QuantizedJumpHoldTime = DeftJumpKinematics::QuantizeHoldTime(movementComponent->m_JumpKeyHoldTime, movementComponent->JumpKeyMaxHoldTime);
+}
+
+void FSavedMove_Deft::SetInitialPosition(ACharacter* aCharacter)
+{
+	// also called again after CombineWith has rolled the component back, so a combined move starts where the old one did
+	Super::SetInitialPosition(aCharacter);
+
+	const UDeftMovementComponent* movementComponent = Cast<UDeftMovementComponent>(aCharacter->GetCharacterMovement());
+	if (!movementComponent)
+		return;
+
+	m_bWasJumpButtonDown = movementComponent->m_bWasJumpButtonDown;
+	m_bIncrementJumpInputHoldTime = movementComponent->m_bIncrementJumpInputHoldTime;
+	m_bInPlatformJump = movementComponent->m_bInPlatformJump;
+	m_bJumpApexReached = movementComponent->m_bJumpApexReached;
+	m_bHasAirDashed = movementComponent->m_bHasAirDashed;
+	m_JumpInputCounter = movementComponent->m_JumpInputCounter;
+	m_AirDashElapsed = movementComponent->m_AirDashElapsed;
+	m_AirDashDirection = movementComponent->m_AirDashDirection;
+	m_JumpKeyHoldTime = movementComponent->m_JumpKeyHoldTime;
+	m_GravityScale = movementComponent->GravityScale;
+	m_bIsLedgingUp = movementComponent->m_bIsLedgingUp;
+	m_InternalMoveMode = (uint8)movementComponent->m_InternalMoveMode;
+	m_LedgeHangStart = movementComponent->m_LedgeHangSegment.m_Start;
+	m_LedgeHangEnd = movementComponent->m_LedgeHangSegment.m_End;
+	m_LedgeHangWallNormal = movementComponent->m_LedgeHangSegment.m_WallNormal;
+	m_LedgeHangSurfaceNormal = movementComponent->m_LedgeHangSegment.m_SurfaceNormal;
+	m_bLedgeHangBaked = movementComponent->m_LedgeHangSegment.m_bBaked;
+}
+
+void FSavedMove_Deft::CombineWith(const FSavedMove_Character* aOldMove, ACharacter* aCharacter, APlayerController* aPlayerController, const FVector& aOldStartLocation)
+{
+	Super::CombineWith(aOldMove, aCharacter, aPlayerController, aOldStartLocation);
+
+	// Super only rolls back the character's own state, the combined move is performed again from the old move's start
+	if (UDeftMovementComponent* movementComponent = Cast<UDeftMovementComponent>(aCharacter->GetCharacterMovement()))
+		static_cast<const FSavedMove_Deft*>(aOldMove)->RestoreStartState(*movementComponent);
+}
+
+void FSavedMove_Deft::PostUpdate(ACharacter* aCharacter, EPostUpdateMode aPostUpdateMode)
+{
+	Super::PostUpdate(aCharacter, aPostUpdateMode);
+
+	// the ledge up is decided inside the move so it can only be recorded once the move has been performed
+	if (aPostUpdateMode == PostUpdate_Record)
+	{
+		if (const UDeftMovementComponent* movementComponent = Cast<UDeftMovementComponent>(aCharacter->GetCharacterMovement()))
+			m_bLedgeUp = movementComponent->m_bLedgeUpThisMove;
+	}
+}
+
+void FSavedMove_Deft::PrepMoveFor(ACharacter* aCharacter)
+{
+	Super::PrepMoveFor(aCharacter);
+
+	UDeftMovementComponent* movementComponent = Cast<UDeftMovementComponent>(aCharacter->GetCharacterMovement());
+	if (!movementComponent)
+		return;
+
+	movementComponent->m_bIsJumpButtonDown = m_bJumpHeld;
+	movementComponent->m_bWantsToAirDash = m_bWantsToAirDash;
+
+	// DoJump, the dash and the ledge up change this state every time they run, without restoring it a replay would count
+	// every jump twice or refuse to find a ledge it's already ledging up from
+	RestoreStartState(*movementComponent);
+}
+
+void FSavedMove_Deft::RestoreStartState(UDeftMovementComponent& outMovementComponent) const
+{
+	outMovementComponent.m_bWasJumpButtonDown = m_bWasJumpButtonDown;
+	outMovementComponent.m_bIncrementJumpInputHoldTime = m_bIncrementJumpInputHoldTime;
+	outMovementComponent.m_bInPlatformJump = m_bInPlatformJump;
+	outMovementComponent.m_bJumpApexReached = m_bJumpApexReached;
+	outMovementComponent.m_bHasAirDashed = m_bHasAirDashed;
+	outMovementComponent.m_JumpInputCounter = m_JumpInputCounter;
+	outMovementComponent.m_AirDashElapsed = m_AirDashElapsed;
+	outMovementComponent.m_AirDashDirection = m_AirDashDirection;
+	outMovementComponent.m_JumpKeyHoldTime = m_JumpKeyHoldTime;
+	outMovementComponent.GravityScale = m_GravityScale;
+	outMovementComponent.m_bIsLedgingUp = m_bIsLedgingUp;
+	outMovementComponent.m_InternalMoveMode = (EInternalMoveMode)m_InternalMoveMode;
+	outMovementComponent.m_LedgeHangSegment.m_Start = m_LedgeHangStart;
+	outMovementComponent.m_LedgeHangSegment.m_End = m_LedgeHangEnd;
+	outMovementComponent.m_LedgeHangSegment.m_WallNormal = m_LedgeHangWallNormal;
+	outMovementComponent.m_LedgeHangSegment.m_SurfaceNormal = m_LedgeHangSurfaceNormal;
+	outMovementComponent.m_LedgeHangSegment.m_bBaked = m_bLedgeHangBaked;
+	outMovementComponent.RestoreMoveLocks();
+}
+
+
+FSavedMovePtr FNetworkPredictionData_Client_Deft::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Deft());
+}
+
+
+void FDeftCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& aClientMove, ENetworkMoveType aMoveType)
+{
+	Super::ClientFillNetworkMoveData(aClientMove, aMoveType);
+
+	m_QuantizedJumpHoldTime = static_cast<const FSavedMove_Deft&>(aClientMove).m_QuantizedJumpHoldTime;
+}
+
+bool FDeftCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& aCharacterMovement, FArchive& aAr, UPackageMap* aPackageMap, ENetworkMoveType aMoveType)
+{
+	Super::Serialize(aCharacterMovement, aAr, aPackageMap, aMoveType);
+
+	// most moves aren't holding jump, those only cost a single bit
+	uint8 bHasHoldTime = m_QuantizedJumpHoldTime != 0;
+	aAr.SerializeBits(&bHasHoldTime, 1);
+	if (bHasHoldTime)
+		aAr << m_QuantizedJumpHoldTime;
+	else
+		m_QuantizedJumpHoldTime = 0;
+
+	return !aAr.IsError();
+}
+
+
+FDeftCharacterNetworkMoveDataContainer::FDeftCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &m_DeftMoveData[0];
+	PendingMoveData = &m_DeftMoveData[1];
+	OldMoveData = &m_DeftMoveData[2];
+}
+
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorld CmdNetStats(
+	TEXT("d.Net.Stats"),
+	TEXT("logs corrections and move bandwidth for every Deft character since it began play (run on the client for corrections, on the server for move bytes)"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* aWorld)
+	{
+		for (TActorIterator<ACharacter> it(aWorld); it; ++it)
+		{
+			const UDeftMovementComponent* movementComponent = Cast<UDeftMovementComponent>(it->GetCharacterMovement());
+			if (!movementComponent)
+				continue;
+
+			const UDeftMovementComponent::NetworkStats& stats = movementComponent->GetNetworkStats();
+			const double elapsed = FMath::Max(aWorld->GetTimeSeconds() - stats.m_StartTime, UE_KINDA_SMALL_NUMBER);
+			UE_LOG(LogDeftMovement, Display, TEXT("%s: %u corrections (%.2f/min), %u server moves %.1f B/s, move responses %.1f B/s"),
+				*it->GetName(), stats.m_Corrections, stats.m_Corrections * 60.0 / elapsed, stats.m_ServerMoves, stats.m_ServerMoveBits / 8.0 / elapsed, stats.m_MoveResponseBits / 8.0 / elapsed);
+		}
+	}));
+#endif
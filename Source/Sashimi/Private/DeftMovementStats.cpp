@@ -0,0 +1,106 @@
+#include "DeftMovementStats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include <atomic>
+
+DEFINE_STAT(STAT_DeftPhysFalling);
+DEFINE_STAT(STAT_DeftPhysLedgeHang);
+DEFINE_STAT(STAT_DeftPhysAirDash);
+DEFINE_STAT(STAT_DeftBatchPostMove);
+DEFINE_STAT(STAT_DeftMassJump);
+DEFINE_STAT(STAT_DeftUpdateInternalMoveMode);
+DEFINE_STAT(STAT_DeftSweepForLedge);
+DEFINE_STAT(STAT_DeftFindLedge);
+DEFINE_STAT(STAT_DeftCheckForWall);
+DEFINE_STAT(STAT_DeftCheckForLedge);
+DEFINE_STAT(STAT_DeftCheckLedgeSurface);
+DEFINE_STAT(STAT_DeftCheckSpaceForCapsule);
+DEFINE_STAT(STAT_DeftPerformLedgeUp);
+
+DEFINE_STAT(STAT_DeftSceneQueries);
+DEFINE_STAT(STAT_DeftLedgeCandidates);
+DEFINE_STAT(STAT_DeftLockTransitions);
+DEFINE_STAT(STAT_DeftLedgeCacheHits);
+DEFINE_STAT(STAT_DeftLedgeCacheMisses);
+
+UE_TRACE_CHANNEL_DEFINE(DeftMovementChannel);
+CSV_DEFINE_CATEGORY_MODULE(SASHIMI_API, DeftMovement, true);
+
+TRACE_DECLARE_INT_COUNTER(DeftSceneQueries, TEXT("DeftMovement/SceneQueries"));
+TRACE_DECLARE_INT_COUNTER(DeftLedgeCandidates, TEXT("DeftMovement/LedgeCandidates"));
+TRACE_DECLARE_INT_COUNTER(DeftLockTransitions, TEXT("DeftMovement/LockTransitions"));
+TRACE_DECLARE_INT_COUNTER(DeftLedgeCacheHits, TEXT("DeftMovement/LedgeCacheHits"));
+TRACE_DECLARE_INT_COUNTER(DeftLedgeCacheMisses, TEXT("DeftMovement/LedgeCacheMisses"));
+
+namespace DeftMovementStats
+{
+	// Insights counters aren't reset every frame like the stat counters so track the frame they belong to.
+	// A count racing the reset on the first add of a frame may land in either frame, that's fine for profiling
+	struct FrameCount
+	{
+		std::atomic<uint64> m_Frame{ 0 };
+		std::atomic<uint64> m_Count{ 0 };
+
+		uint64 Add(uint64 aAmount)
+		{
+			const uint64 frame = GFrameCounter;
+			if (m_Frame.exchange(frame, std::memory_order_relaxed) != frame)
+				m_Count.store(0, std::memory_order_relaxed);
+			return m_Count.fetch_add(aAmount, std::memory_order_relaxed) + aAmount;
+		}
+
+		uint64 Get(uint64 aFrame) const
+		{
+			return m_Frame.load(std::memory_order_relaxed) == aFrame ? m_Count.load(std::memory_order_relaxed) : 0;
+		}
+	};
+	static FrameCount s_FrameCounts[(int32)EDeftMovementCounter::COUNT];
+	static FrameCount s_MovementTickCycles;
+
+	void AddCount(EDeftMovementCounter aCounter, uint32 aAmount)
+	{
+		[[maybe_unused]] const uint32 frameCount = (uint32)s_FrameCounts[(int32)aCounter].Add(aAmount);
+		switch (aCounter)
+		{
+			case EDeftMovementCounter::SceneQueries:
+				INC_DWORD_STAT_BY(STAT_DeftSceneQueries, aAmount);
+				CSV_CUSTOM_STAT(DeftMovement, SceneQueries, (int32)aAmount, ECsvCustomStatOp::Accumulate);
+				TRACE_COUNTER_SET(DeftSceneQueries, frameCount);
+				break;
+			case EDeftMovementCounter::LedgeCandidates:
+				INC_DWORD_STAT_BY(STAT_DeftLedgeCandidates, aAmount);
+				CSV_CUSTOM_STAT(DeftMovement, LedgeCandidates, (int32)aAmount, ECsvCustomStatOp::Accumulate);
+				TRACE_COUNTER_SET(DeftLedgeCandidates, frameCount);
+				break;
+			case EDeftMovementCounter::LockTransitions:
+				INC_DWORD_STAT_BY(STAT_DeftLockTransitions, aAmount);
+				CSV_CUSTOM_STAT(DeftMovement, LockTransitions, (int32)aAmount, ECsvCustomStatOp::Accumulate);
+				TRACE_COUNTER_SET(DeftLockTransitions, frameCount);
+				break;
+			case EDeftMovementCounter::LedgeCacheHits:
+				INC_DWORD_STAT_BY(STAT_DeftLedgeCacheHits, aAmount);
+				CSV_CUSTOM_STAT(DeftMovement, LedgeCacheHits, (int32)aAmount, ECsvCustomStatOp::Accumulate);
+				TRACE_COUNTER_SET(DeftLedgeCacheHits, frameCount);
+				break;
+			case EDeftMovementCounter::LedgeCacheMisses:
+				INC_DWORD_STAT_BY(STAT_DeftLedgeCacheMisses, aAmount);
+				CSV_CUSTOM_STAT(DeftMovement, LedgeCacheMisses, (int32)aAmount, ECsvCustomStatOp::Accumulate);
+				TRACE_COUNTER_SET(DeftLedgeCacheMisses, frameCount);
+				break;
+		}
+	}
+
+	uint32 GetCount(EDeftMovementCounter aCounter, uint64 aFrame)
+	{
+		return (uint32)s_FrameCounts[(int32)aCounter].Get(aFrame);
+	}
+
+	void AddMovementTickCycles(uint64 aCycles)
+	{
+		s_MovementTickCycles.Add(aCycles);
+	}
+
+	double GetMovementTickMs(uint64 aFrame)
+	{
+		return FPlatformTime::ToMilliseconds64(s_MovementTickCycles.Get(aFrame));
+	}
+};
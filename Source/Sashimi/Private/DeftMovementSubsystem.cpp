@@ -0,0 +1,181 @@
+#include "DeftMovementSubsystem.h"
+#include "DeftMovementComponent.h"
+#include "DeftJumpKinematics.h"
+#include "DeftMovementStats.h"
+#include "GameFramework/Character.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<bool> CVarMovementBatch(TEXT("d.Movement.Batch"), false, TEXT("standalone only: if enabled the ledge queries and internal move mode of every Deft character run once per frame in one batch (UDeftMovementSubsystem) instead of at the end of each move"));
+static TAutoConsoleVariable<int32> CVarMovementBatchMinParallel(TEXT("d.Movement.BatchMinParallel"), 32, TEXT("batches smaller than this are simulated on the game thread, below it the ParallelFor overhead outweighs the work"));
+
+bool UDeftMovementSubsystem::ShouldBatch(const UDeftMovementComponent& aMovement)
+{
+	return CVarMovementBatch.GetValueOnGameThread() && aMovement.GetNetMode() == NM_Standalone && !aMovement.bClientUpdating && aMovement.GetWorld() && aMovement.GetWorld()->GetSubsystem<UDeftMovementSubsystem>();
+}
+
+void UDeftMovementSubsystem::QueuePostMove(UDeftMovementComponent* aMovement)
+{
+	m_Queued.Add(aMovement);
+}
+
+TStatId UDeftMovementSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDeftMovementSubsystem, STATGROUP_Tickables);
+}
+
+void UDeftMovementSubsystem::Tick(float aDeltaTime)
+{
+	if (m_Queued.Num() == 0)
+		return;
+
+	DEFT_MOVEMENT_SCOPE(BatchPostMove);
+
+	RunLedgeQueries();
+	Gather();
+	Simulate();
+	Apply();
+
+	for (const TWeakObjectPtr<UDeftMovementComponent>& queued : m_Queued)
+	{
+		if (UDeftMovementComponent* movement = queued.Get())
+			movement->m_bBatchPostMovePending = false;
+	}
+	m_Queued.Reset();
+}
+
+void UDeftMovementSubsystem::RunLedgeQueries()
+{
+	for (const TWeakObjectPtr<UDeftMovementComponent>& queued : m_Queued)
+	{
+		UDeftMovementComponent* movement = queued.Get();
+		if (movement && movement->CharacterOwner && movement->ShouldSweepForLedge())
+			movement->SweepForLedge(movement->m_BatchPostMoveOldLocation, movement->m_BatchPostMoveDeltaTime);
+	}
+}
+
+void UDeftMovementSubsystem::Gather()
+{
+	MovementBatch& batch = m_Batch;
+	batch.Reset(m_Queued.Num());
+
+	for (const TWeakObjectPtr<UDeftMovementComponent>& queued : m_Queued)
+	{
+		UDeftMovementComponent* movement = queued.Get();
+		// nothing internal runs while hanging or dashing, both place the character themselves
+		if (!movement || !movement->CharacterOwner || movement->IsLedgeHanging() || movement->IsAirDashing())
+			continue;
+
+		uint8 flags = BF_None;
+		if (movement->m_LODSettings.m_bSimulateInternalMoveMode)
+			flags |= BF_SimulateInternal;
+		if (movement->m_bInPlatformJump)
+			flags |= BF_InPlatformJump;
+		if (movement->m_bIncrementJumpInputHoldTime)
+			flags |= BF_IncrementHoldTime;
+		if (movement->m_bJumpApexReached)
+			flags |= BF_JumpApexReached;
+		if (movement->m_InternalMoveMode == EInternalMoveMode::IMOVE_AirDash && movement->IsFalling())
+			flags |= BF_AirDashExit;
+		const bool bLedgeUpBoost = (flags & BF_SimulateInternal) && movement->m_InternalMoveMode == EInternalMoveMode::IMOVE_LedgeUp;
+
+		const ACharacter* character = movement->CharacterOwner;
+		batch.m_Components.Add(movement);
+		const FVector forward = character->GetActorForwardVector();
+		batch.m_VelocityX.Add(movement->Velocity.X);
+		batch.m_VelocityY.Add(movement->Velocity.Y);
+		batch.m_VelocityZ.Add(movement->Velocity.Z);
+		batch.m_ForwardX.Add(forward.X);
+		batch.m_ForwardY.Add(forward.Y);
+		batch.m_DeltaTime.Add(movement->m_BatchPostMoveDeltaTime);
+		batch.m_HeightAboveJumpStart.Add(FMath::Abs(character->GetActorLocation().Z - movement->m_PlatformJumpInitialPosition.Z));
+		batch.m_MaxSpeed.Add(movement->GetMaxSpeed());
+		batch.m_ExitDeceleration.Add(movement->AirDashExitDeceleration);
+		batch.m_LedgeUpBoost.Add(bLedgeUpBoost ? movement->LedgeUpForwardMinBoost : 0.f);
+		batch.m_JumpKeyHoldTime.Add(movement->m_JumpKeyHoldTime);
+		batch.m_PlatformJumpApex.Add(movement->m_PlatformJumpApex);
+		batch.m_Flags.Add(flags);
+	}
+}
+
+void UDeftMovementSubsystem::Simulate()
+{
+	MovementBatch& batch = m_Batch;
+	const EParallelForFlags parallelFlags = batch.Num() < CVarMovementBatchMinParallel.GetValueOnGameThread() ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+	ParallelFor(batch.Num(), [&batch](int32 aIndex)
+	{
+		SimulateEntry(batch, aIndex);
+	}, parallelFlags);
+
+	// the boost is the same few multiply-adds for everyone, entries not ledging up have a zero boost
+	DeftJumpKinematicsBatch::ApplyForwardBoost(batch.m_VelocityX.GetData(), batch.m_VelocityY.GetData(), batch.m_ForwardX.GetData(), batch.m_ForwardY.GetData(), batch.m_LedgeUpBoost.GetData(), batch.m_DeltaTime.GetData(), batch.Num());
+}
+
+void UDeftMovementSubsystem::SimulateEntry(MovementBatch& aBatch, int32 aIndex)
+{
+	uint8& flags = aBatch.m_Flags[aIndex];
+	const float deltaTime = aBatch.m_DeltaTime[aIndex];
+	const float velocityZ = aBatch.m_VelocityZ[aIndex];
+
+	// low LODs only keep the transitions that change the trajectory
+	if (!(flags & BF_SimulateInternal))
+	{
+		if (flags & BF_IncrementHoldTime)
+			aBatch.m_JumpKeyHoldTime[aIndex] += deltaTime;
+		if (velocityZ < 0.f && !(flags & BF_JumpApexReached))
+			flags |= BF_ApexReachedNow;
+		return;
+	}
+
+	if (flags & BF_InPlatformJump)
+	{
+		if (!(flags & BF_JumpApexReached))
+			aBatch.m_PlatformJumpApex[aIndex] = FMath::Max(aBatch.m_PlatformJumpApex[aIndex], aBatch.m_HeightAboveJumpStart[aIndex]);
+		if (flags & BF_IncrementHoldTime)
+			aBatch.m_JumpKeyHoldTime[aIndex] += deltaTime;
+	}
+
+	if (velocityZ < 0.f && !(flags & BF_JumpApexReached))
+		flags |= BF_ApexReachedNow;
+
+	if (flags & BF_AirDashExit)
+	{
+		const FVector velocity = DeftJumpKinematics::CalculateDashExitVelocity(FVector(aBatch.m_VelocityX[aIndex], aBatch.m_VelocityY[aIndex], velocityZ), aBatch.m_MaxSpeed[aIndex], aBatch.m_ExitDeceleration[aIndex], deltaTime);
+		aBatch.m_VelocityX[aIndex] = velocity.X;
+		aBatch.m_VelocityY[aIndex] = velocity.Y;
+	}
+}
+
+void UDeftMovementSubsystem::Apply()
+{
+	const MovementBatch& batch = m_Batch;
+	for (int32 index = 0; index < batch.Num(); ++index)
+	{
+		UDeftMovementComponent* movement = batch.m_Components[index];
+		movement->Velocity = FVector(batch.m_VelocityX[index], batch.m_VelocityY[index], batch.m_VelocityZ[index]);
+		movement->m_JumpKeyHoldTime = batch.m_JumpKeyHoldTime[index];
+		movement->m_PlatformJumpApex = batch.m_PlatformJumpApex[index];
+
+		// locks, gravity and the movement event stay on the game thread
+		if (batch.m_Flags[index] & BF_ApexReachedNow)
+			movement->OnJumpApexReached();
+	}
+}
+
+void UDeftMovementSubsystem::MovementBatch::Reset(int32 aExpectedNum)
+{
+	m_Components.Reset(aExpectedNum);
+	m_VelocityX.Reset(aExpectedNum);
+	m_VelocityY.Reset(aExpectedNum);
+	m_VelocityZ.Reset(aExpectedNum);
+	m_ForwardX.Reset(aExpectedNum);
+	m_ForwardY.Reset(aExpectedNum);
+	m_DeltaTime.Reset(aExpectedNum);
+	m_HeightAboveJumpStart.Reset(aExpectedNum);
+	m_MaxSpeed.Reset(aExpectedNum);
+	m_ExitDeceleration.Reset(aExpectedNum);
+	m_LedgeUpBoost.Reset(aExpectedNum);
+	m_JumpKeyHoldTime.Reset(aExpectedNum);
+	m_PlatformJumpApex.Reset(aExpectedNum);
+	m_Flags.Reset(aExpectedNum);
+}
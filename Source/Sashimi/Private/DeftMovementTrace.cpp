@@ -0,0 +1,71 @@
+#include "DeftMovementTrace.h"
+
+#if DEFT_MOVEMENT_TRACE_ENABLED
+#include "DeftMovementComponent.h"
+#include "DeftMovementStats.h"
+#include "GameFramework/Character.h"
+#include "Trace/Trace.inl"
+
+UE_TRACE_EVENT_BEGIN(DeftMovement, MovementState)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(double, RecordingTime)
+	UE_TRACE_EVENT_FIELD(uint64, ComponentId)
+	UE_TRACE_EVENT_FIELD(float, GravityScale)
+	UE_TRACE_EVENT_FIELD(float, JumpApex)
+	UE_TRACE_EVENT_FIELD(float, JumpHoldTime)
+	UE_TRACE_EVENT_FIELD(float, LedgeEdgeX)
+	UE_TRACE_EVENT_FIELD(float, LedgeEdgeY)
+	UE_TRACE_EVENT_FIELD(float, LedgeEdgeZ)
+	UE_TRACE_EVENT_FIELD(float, HopUpX)
+	UE_TRACE_EVENT_FIELD(float, HopUpY)
+	UE_TRACE_EVENT_FIELD(float, HopUpZ)
+	UE_TRACE_EVENT_FIELD(uint8, InternalMoveMode)
+	UE_TRACE_EVENT_FIELD(uint8, MovementMode)
+	UE_TRACE_EVENT_FIELD(uint8, ForwardBackLocks)
+	UE_TRACE_EVENT_FIELD(uint8, RightLeftLocks)
+	UE_TRACE_EVENT_FIELD(uint8, Flags)
+UE_TRACE_EVENT_END()
+
+void FDeftMovementTrace::OutputMovementState(const UDeftMovementComponent& aMovementComponent)
+{
+	const bool bChannelEnabled = UE_TRACE_CHANNELEXPR_IS_ENABLED(DeftMovementChannel);
+	if (!bChannelEnabled)
+		return;
+
+	const UWorld* world = aMovementComponent.GetWorld();
+	if (!world || CANNOT_TRACE_OBJECT(&aMovementComponent))
+		return;
+
+	TRACE_OBJECT(&aMovementComponent);
+
+	uint8 flags = DMTF_None;
+	flags |= aMovementComponent.m_bInPlatformJump ? DMTF_InPlatformJump : 0;
+	flags |= aMovementComponent.m_bJumpApexReached ? DMTF_JumpApexReached : 0;
+	flags |= aMovementComponent.m_bIsJumpButtonDown ? DMTF_JumpButtonDown : 0;
+	flags |= aMovementComponent.m_bIsLedgingUp ? DMTF_LedgingUp : 0;
+	flags |= aMovementComponent.m_bHasAirDashed ? DMTF_HasAirDashed : 0;
+
+	const DeftLocks& locks = aMovementComponent.GetDeftLocks();
+	const FVector& ledgeEdge = aMovementComponent.m_ledgeEdgeCache;
+	const FVector& hopUp = aMovementComponent.m_ledgeHopUpLocationCache;
+
+	UE_TRACE_LOG(DeftMovement, MovementState, DeftMovementChannel)
+		<< MovementState.Cycle(FPlatformTime::Cycles64())
+		<< MovementState.RecordingTime(FObjectTrace::GetWorldElapsedTime(world))
+		<< MovementState.ComponentId(FObjectTrace::GetObjectId(&aMovementComponent))
+		<< MovementState.GravityScale(aMovementComponent.GravityScale)
+		<< MovementState.JumpApex(aMovementComponent.m_PlatformJumpApex)
+		<< MovementState.JumpHoldTime(aMovementComponent.m_JumpKeyHoldTime)
+		<< MovementState.LedgeEdgeX((float)ledgeEdge.X)
+		<< MovementState.LedgeEdgeY((float)ledgeEdge.Y)
+		<< MovementState.LedgeEdgeZ((float)ledgeEdge.Z)
+		<< MovementState.HopUpX((float)hopUp.X)
+		<< MovementState.HopUpY((float)hopUp.Y)
+		<< MovementState.HopUpZ((float)hopUp.Z)
+		<< MovementState.InternalMoveMode((uint8)aMovementComponent.m_InternalMoveMode)
+		<< MovementState.MovementMode((uint8)aMovementComponent.MovementMode)
+		<< MovementState.ForwardBackLocks(locks.GetLockCount(EDeftLock::MoveInputForwardBack))
+		<< MovementState.RightLeftLocks(locks.GetLockCount(EDeftLock::MoveInputRightLeft))
+		<< MovementState.Flags(flags);
+}
+#endif//DEFT_MOVEMENT_TRACE_ENABLED
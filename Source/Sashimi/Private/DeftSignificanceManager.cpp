@@ -0,0 +1,119 @@
+#include "DeftSignificanceManager.h"
+#include "DeftMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<float> CVarLODHighDistance(TEXT("d.LOD.HighDistance"), 2500.f, TEXT("characters closer than this (cm) to a viewer move at full LOD"));
+static TAutoConsoleVariable<float> CVarLODMediumDistance(TEXT("d.LOD.MediumDistance"), 6000.f, TEXT("characters closer than this (cm) to a viewer move at medium LOD, further away is low"));
+static TAutoConsoleVariable<float> CVarLODDormantDistance(TEXT("d.LOD.DormantDistance"), 10000.f, TEXT("characters behind every viewer and further than this (cm) go dormant, keep it above d.LOD.MediumDistance or there's no low bucket behind the viewer"));
+static TAutoConsoleVariable<float> CVarLODHysteresis(TEXT("d.LOD.Hysteresis"), 0.1f, TEXT("fraction of a bucket distance a character has to move past it before changing buckets"));
+
+const FName UDeftSignificanceManager::MovementTag(TEXT("DeftMovement"));
+
+const FDeftMovementLODSettings& FDeftMovementLODSettings::Get(EDeftMovementLOD aLOD)
+{
+	static const FDeftMovementLODSettings settings[(int32)EDeftMovementLOD::COUNT] =
+	{
+		//	tick interval	find ledge	ledge debug	simulate
+		{	0.f,			true,		true,		true	},	// High
+		{	1.f / 30.f,		true,		false,		true	},	// Medium
+		{	1.f / 15.f,		false,		false,		false	},	// Low
+		{	0.25f,			false,		false,		false	},	// Dormant
+	};
+	return settings[FMath::Min((int32)aLOD, (int32)EDeftMovementLOD::COUNT - 1)];
+}
+
+void UDeftSignificanceManager::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (!IsTemplate())
+		m_PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UDeftSignificanceManager::OnWorldPostActorTick);
+}
+
+void UDeftSignificanceManager::BeginDestroy()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(m_PostActorTickHandle);
+	Super::BeginDestroy();
+}
+
+void UDeftSignificanceManager::RegisterMovement(UDeftMovementComponent* aMovement)
+{
+	RegisterObject(aMovement, MovementTag, &UDeftSignificanceManager::CalculateSignificance, EPostSignificanceType::Sequential, &UDeftSignificanceManager::OnSignificanceChanged);
+}
+
+void UDeftSignificanceManager::UnregisterMovement(UDeftMovementComponent* aMovement)
+{
+	UnregisterObject(aMovement);
+}
+
+void UDeftSignificanceManager::OnWorldPostActorTick(UWorld* aWorld, ELevelTick aTickType, float aDeltaSeconds)
+{
+	if (aWorld != GetWorld())
+		return;
+
+	m_Viewpoints.Reset();
+	for (FConstPlayerControllerIterator it = aWorld->GetPlayerControllerIterator(); it; ++it)
+	{
+		if (const APlayerController* playerController = it->Get())
+		{
+			FVector location;
+			FRotator rotation;
+			playerController->GetPlayerViewPoint(location, rotation);
+			m_Viewpoints.Emplace(rotation, location);
+		}
+	}
+
+	// dedicated servers have no viewers, everything stays at whatever it was registered with
+	if (m_Viewpoints.Num() > 0)
+		Update(m_Viewpoints);
+}
+
+float UDeftSignificanceManager::CalculateSignificance(FManagedObjectInfo* aObjectInfo, const FTransform& aViewpoint)
+{
+	// significance is the bucket, inverted so the most significant bucket is the highest value
+	constexpr float highest = (float)EDeftMovementLOD::COUNT - 1;
+
+	const UDeftMovementComponent* movement = Cast<UDeftMovementComponent>(aObjectInfo->GetObject());
+	const ACharacter* character = movement ? movement->GetCharacterOwner() : nullptr;
+	if (!character)
+		return 0.f;
+	if (character->IsLocallyControlled())
+		return highest;
+
+	const FVector toCharacter = character->GetActorLocation() - aViewpoint.GetLocation();
+	const float distance = toCharacter.Size();
+	const bool bInFront = (toCharacter | aViewpoint.GetRotation().GetForwardVector()) >= 0.f;
+
+	// stretch the current bucket's bounds so a character hovering on a boundary doesn't flicker between buckets
+	const EDeftMovementLOD currentLOD = (EDeftMovementLOD)FMath::RoundToInt(highest - aObjectInfo->GetSignificance());
+	const float hysteresis = 1.f + CVarLODHysteresis.GetValueOnGameThread();
+	const float highDistance = CVarLODHighDistance.GetValueOnGameThread() * (currentLOD == EDeftMovementLOD::High ? hysteresis : 1.f);
+	const float mediumDistance = CVarLODMediumDistance.GetValueOnGameThread() * (currentLOD == EDeftMovementLOD::Medium ? hysteresis : 1.f);
+	// dormant lies past its distance, so a dormant character has to come back inside it by the same margin to wake up
+	float dormantDistance = CVarLODDormantDistance.GetValueOnGameThread();
+	if (currentLOD == EDeftMovementLOD::Dormant)
+		dormantDistance /= hysteresis;
+	else if (currentLOD == EDeftMovementLOD::Low)
+		dormantDistance *= hysteresis;
+
+	EDeftMovementLOD lod = EDeftMovementLOD::Low;
+	if (distance < highDistance)
+		lod = EDeftMovementLOD::High;
+	else if (!bInFront && distance > dormantDistance)
+		lod = EDeftMovementLOD::Dormant;
+	else if (distance < mediumDistance)
+		lod = EDeftMovementLOD::Medium;
+
+	return highest - (float)lod;
+}
+
+void UDeftSignificanceManager::OnSignificanceChanged(FManagedObjectInfo* aObjectInfo, float aOldSignificance, float aSignificance, bool bFinal)
+{
+	if (aOldSignificance == aSignificance)
+		return;
+
+	if (UDeftMovementComponent* movement = Cast<UDeftMovementComponent>(aObjectInfo->GetObject()))
+		movement->SetMovementLOD((EDeftMovementLOD)FMath::RoundToInt((float)EDeftMovementLOD::COUNT - 1 - aSignificance));
+}
@@ -0,0 +1,363 @@
+#include "DeftStressBenchmark.h"
+#include "DeftMovementComponent.h"
+#include "DeftMovementStats.h"
+#include "DeftJumpKinematics.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/StaticMesh.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/ConstructorHelpers.h"
+
+DEFINE_LOG_CATEGORY(LogDeftStress);
+
+namespace DeftStress
+{
+	// lanes are laid out in rows along +X, far above the loaded level so they don't touch its geometry
+	static const FVector Origin(0.f, 0.f, 50000.f);
+	static constexpr int32 LanesPerRow = 25;
+	static constexpr float LaneLength = 3000.f;
+	static constexpr float LaneWidth = 300.f;
+	static constexpr float LaneSpacing = 400.f;
+	static constexpr float RowSpacing = LaneLength + 1000.f;
+	static constexpr float LedgeStart = 1200.f;
+	static constexpr float LedgeLength = 1000.f;
+	static constexpr float CubeSize = 100.f;		// /Engine/BasicShapes/Cube is 100 units, centered
+
+	static constexpr float MoveDuration = 1.25f;
+	static constexpr float TapTime = 0.1f;
+	static constexpr float DashTime = 0.3f;
+	static constexpr float LedgeUpHoldTime = 1.2f;
+}
+
+
+ADeftStressController::ADeftStressController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bAttachToPawn = false;
+}
+
+void ADeftStressController::SetLane(const FVector& aStart, float aLength, int32 aSeed)
+{
+	m_LaneStart = aStart;
+	m_LaneLength = aLength;
+	m_Random.Initialize(aSeed);
+	StartMove((EStressMove)m_Random.RandHelper((int32)EStressMove::COUNT));
+}
+
+void ADeftStressController::StartMove(EStressMove aMove)
+{
+	if (m_bJumpHeld)
+		ReleaseJump();
+
+	m_Move = aMove;
+	m_MoveTime = 0.f;
+	m_bSecondActionDone = false;
+	switch (m_Move)
+	{
+		case EStressMove::VariableJump:	m_ReleaseTime = m_Random.FRandRange(0.05f, 0.35f); break;
+		case EStressMove::DoubleJump:	m_ReleaseTime = 0.15f; break;
+		case EStressMove::LedgeUp:		m_ReleaseTime = DeftStress::LedgeUpHoldTime; break;
+		default:						m_ReleaseTime = DeftStress::TapTime; break;
+	}
+	PressJump();
+}
+
+void ADeftStressController::PressJump()
+{
+	// same entry points as APlayerCharacter::OnJumpPressed
+	if (ACharacter* character = Cast<ACharacter>(GetPawn()))
+	{
+		character->Jump();
+		if (UDeftMovementComponent* deftMovement = Cast<UDeftMovementComponent>(character->GetCharacterMovement()))
+			deftMovement->OnJumpPressed();
+	}
+	m_bJumpHeld = true;
+}
+
+void ADeftStressController::ReleaseJump()
+{
+	if (ACharacter* character = Cast<ACharacter>(GetPawn()))
+	{
+		if (UDeftMovementComponent* deftMovement = Cast<UDeftMovementComponent>(character->GetCharacterMovement()))
+			deftMovement->OnJumpReleased();
+	}
+	m_bJumpHeld = false;
+}
+
+void ADeftStressController::Tick(float aDeltaSeconds)
+{
+	Super::Tick(aDeltaSeconds);
+
+	ACharacter* character = Cast<ACharacter>(GetPawn());
+	UDeftMovementComponent* deftMovement = character ? Cast<UDeftMovementComponent>(character->GetCharacterMovement()) : nullptr;
+	if (!deftMovement)
+		return;
+
+	// back to the start once we run off the end of the lane (or fall off it)
+	const FVector location = character->GetActorLocation();
+	if (location.X > m_LaneStart.X + m_LaneLength || location.Z < m_LaneStart.Z - 500.f)
+	{
+		character->TeleportTo(m_LaneStart, FRotator::ZeroRotator);
+		deftMovement->Velocity = FVector::ZeroVector;
+		++m_MovesCompleted;
+		StartMove((EStressMove)(((int32)m_Move + 1) % (int32)EStressMove::COUNT));
+		return;
+	}
+
+	m_MoveTime += aDeltaSeconds;
+	if (m_MoveTime >= DeftStress::MoveDuration)
+	{
+		++m_MovesCompleted;
+		StartMove((EStressMove)(((int32)m_Move + 1) % (int32)EStressMove::COUNT));
+		return;
+	}
+
+	if (m_bJumpHeld && m_MoveTime >= m_ReleaseTime)
+		ReleaseJump();
+
+	if (!m_bSecondActionDone)
+	{
+		if (m_Move == EStressMove::DoubleJump && !m_bJumpHeld && deftMovement->IsFalling() && deftMovement->Velocity.Z <= 0.f)
+		{
+			PressJump();
+			m_ReleaseTime = m_MoveTime + 0.15f;
+			m_bSecondActionDone = true;
+		}
+		else if (m_Move == EStressMove::AirDash && m_MoveTime >= DeftStress::DashTime)
+		{
+			deftMovement->OnAirDash();
+			m_bSecondActionDone = true;
+		}
+	}
+
+	// respect the movement locks like APlayerCharacter::Move does
+	if (!deftMovement->GetDeftLocks().IsMoveInputForwardBackLocked())
+		character->AddMovementInput(FVector::ForwardVector, 1.f);
+}
+
+
+ADeftStressBenchmark::ADeftStressBenchmark()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	// after every movement component has ticked so the frame's counters are complete
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	m_LaneGeometry = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("LaneGeometry"));
+	// movable so the lanes are always traced, they aren't in any baked ledge index
+	m_LaneGeometry->SetMobility(EComponentMobility::Movable);
+	m_LaneGeometry->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	RootComponent = m_LaneGeometry;
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> cubeMesh(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (cubeMesh.Succeeded())
+		m_LaneGeometry->SetStaticMesh(cubeMesh.Object);
+}
+
+bool ADeftStressBenchmark::Start(int32 aCharacterCount, float aDurationSeconds, bool bExitWhenDone)
+{
+	const AGameModeBase* gameMode = GetWorld()->GetAuthGameMode();
+	TSubclassOf<APawn> pawnClass = gameMode ? gameMode->DefaultPawnClass : nullptr;
+	const ACharacter* pawnCDO = pawnClass ? Cast<ACharacter>(pawnClass->GetDefaultObject()) : nullptr;
+	if (!pawnCDO || !Cast<UDeftMovementComponent>(pawnCDO->GetCharacterMovement()))
+	{
+		UE_LOG(LogDeftStress, Error, TEXT("the default pawn class (%s) doesn't use UDeftMovementComponent"), *GetNameSafe(pawnClass));
+		return false;
+	}
+
+	aCharacterCount = FMath::Clamp(aCharacterCount, 1, MaxCharacters);
+	m_DurationSeconds = aDurationSeconds;
+	m_bExitWhenDone = bExitWhenDone;
+	m_Elapsed = 0.f;
+	m_Samples.Reset();
+	m_Results = Results();
+	m_bFinished = false;
+	m_Samples.Reserve(FMath::CeilToInt(aDurationSeconds * 120.f));
+
+	BuildLanes(pawnClass, aCharacterCount);
+
+	m_bRunning = true;
+	SetActorTickEnabled(true);
+	UE_LOG(LogDeftStress, Display, TEXT("running %d characters for %.1f s (%.1f s warmup)"), m_Pawns.Num(), m_DurationSeconds, m_WarmupSeconds);
+	return true;
+}
+
+void ADeftStressBenchmark::BuildLanes(TSubclassOf<APawn> aPawnClass, int32 aCharacterCount)
+{
+	const ACharacter* pawnCDO = CastChecked<ACharacter>(aPawnClass->GetDefaultObject());
+	const UDeftMovementComponent* deftMovementCDO = CastChecked<UDeftMovementComponent>(pawnCDO->GetCharacterMovement());
+	const float capsuleHalfHeight = pawnCDO->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const float jumpHeight = deftMovementCDO->GetJumpTuning().m_JumpMaxHeight > 0.f ? deftMovementCDO->GetJumpTuning().m_JumpMaxHeight : 200.f;
+
+	FRandomStream random(aCharacterCount);
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 lane = 0; lane < aCharacterCount; ++lane)
+	{
+		const FVector laneOrigin = DeftStress::Origin + FVector((lane / DeftStress::LanesPerRow) * DeftStress::RowSpacing, (lane % DeftStress::LanesPerRow) * DeftStress::LaneSpacing, 0.f);
+
+		// floor, top at the lane origin
+		const FVector floorScale(DeftStress::LaneLength / DeftStress::CubeSize, DeftStress::LaneWidth / DeftStress::CubeSize, 1.f);
+		m_LaneGeometry->AddInstance(FTransform(FQuat::Identity, laneOrigin + FVector(DeftStress::LaneLength * 0.5f, 0.f, -DeftStress::CubeSize * 0.5f), floorScale), true);
+
+		// ledge block, a mix of heights from easy to the edge of what a full jump can grab
+		const float ledgeHeight = capsuleHalfHeight + jumpHeight * random.FRandRange(0.5f, 0.9f);
+		const FVector ledgeScale(DeftStress::LedgeLength / DeftStress::CubeSize, DeftStress::LaneWidth / DeftStress::CubeSize, ledgeHeight / DeftStress::CubeSize);
+		m_LaneGeometry->AddInstance(FTransform(FQuat::Identity, laneOrigin + FVector(DeftStress::LedgeStart + DeftStress::LedgeLength * 0.5f, 0.f, ledgeHeight * 0.5f), ledgeScale), true);
+
+		const FVector start = laneOrigin + FVector(100.f, 0.f, capsuleHalfHeight + 2.f);
+		APawn* pawn = GetWorld()->SpawnActor<APawn>(aPawnClass, start, FRotator::ZeroRotator, spawnParams);
+		ADeftStressController* controller = GetWorld()->SpawnActor<ADeftStressController>(spawnParams);
+		if (!pawn || !controller)
+			continue;
+
+		controller->Possess(pawn);
+		controller->SetControlRotation(FRotator::ZeroRotator);
+		controller->SetLane(start, DeftStress::LaneLength, lane);
+		m_Pawns.Add(pawn);
+		m_Controllers.Add(controller);
+	}
+}
+
+void ADeftStressBenchmark::Tick(float aDeltaSeconds)
+{
+	Super::Tick(aDeltaSeconds);
+	if (!m_bRunning)
+		return;
+
+	m_Elapsed += aDeltaSeconds;
+	if (m_Elapsed < m_WarmupSeconds)
+		return;
+
+	// GGameThreadTime is the previous frame, the counters are this frame's
+	FrameSample& sample = m_Samples.AddDefaulted_GetRef();
+	sample.m_Frame = GFrameCounter;
+	sample.m_GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	sample.m_SceneQueries = DeftMovementStats::GetCount(EDeftMovementCounter::SceneQueries, GFrameCounter);
+	sample.m_MovementMs = (float)DeftMovementStats::GetMovementTickMs(GFrameCounter);
+
+	if (m_Elapsed >= m_WarmupSeconds + m_DurationSeconds)
+		Finish();
+}
+
+void ADeftStressBenchmark::Finish()
+{
+	m_bRunning = false;
+	SetActorTickEnabled(false);
+
+	const int32 characterCount = FMath::Max(m_Pawns.Num(), 1);
+	TArray<float> gameThreadMs;
+	double gameThreadTotal = 0.0, movementTotal = 0.0;
+	uint64 queryTotal = 0;
+	for (const FrameSample& sample : m_Samples)
+	{
+		gameThreadMs.Add(sample.m_GameThreadMs);
+		gameThreadTotal += sample.m_GameThreadMs;
+		movementTotal += sample.m_MovementMs;
+		queryTotal += sample.m_SceneQueries;
+	}
+	gameThreadMs.Sort();
+	const int32 frames = FMath::Max(m_Samples.Num(), 1);
+	const float p95Ms = gameThreadMs.Num() > 0 ? gameThreadMs[FMath::Min(gameThreadMs.Num() - 1, (int32)(gameThreadMs.Num() * 0.95f))] : 0.f;
+
+	UE_LOG(LogDeftStress, Display, TEXT("%d characters, %d frames: game thread avg %.3f ms (p95 %.3f ms), %.1f scene queries/frame, movement %.3f ms/frame (%.4f ms/character)"),
+		m_Pawns.Num(), m_Samples.Num(), gameThreadTotal / frames, p95Ms, (double)queryTotal / frames, movementTotal / frames, movementTotal / frames / characterCount);
+
+	m_Results.m_Frames = m_Samples.Num();
+	for (const AController* controller : m_Controllers)
+	{
+		const ADeftStressController* stressController = Cast<ADeftStressController>(controller);
+		m_Results.m_MovesCompleted.Add(stressController ? stressController->GetMovesCompleted() : 0);
+	}
+
+	WriteCsv();
+	Cleanup();
+	m_bFinished = true;
+
+	if (m_bExitWhenDone)
+		FPlatformMisc::RequestExit(false, TEXT("d.Stress.Run"));
+}
+
+void ADeftStressBenchmark::WriteCsv()
+{
+	const int32 characterCount = FMath::Max(m_Pawns.Num(), 1);
+	FString csv = TEXT("frame,game_thread_ms,scene_queries,movement_ms,movement_ms_per_character\n");
+	for (const FrameSample& sample : m_Samples)
+		csv += FString::Printf(TEXT("%llu,%.4f,%u,%.4f,%.6f\n"), sample.m_Frame, sample.m_GameThreadMs, sample.m_SceneQueries, sample.m_MovementMs, sample.m_MovementMs / characterCount);
+
+	const FString path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), FString::Printf(TEXT("DeftStress_%d_%s.csv"), m_Pawns.Num(), *FDateTime::Now().ToString()));
+	if (FFileHelper::SaveStringToFile(csv, *path))
+	{
+		m_Results.m_CsvPath = path;
+		UE_LOG(LogDeftStress, Display, TEXT("wrote %s"), *path);
+	}
+	else
+		UE_LOG(LogDeftStress, Error, TEXT("failed to write %s"), *path);
+}
+
+void ADeftStressBenchmark::Cleanup()
+{
+	for (AController* controller : m_Controllers)
+	{
+		if (IsValid(controller))
+			controller->Destroy();
+	}
+	for (APawn* pawn : m_Pawns)
+	{
+		if (IsValid(pawn))
+			pawn->Destroy();
+	}
+	m_Controllers.Reset();
+	m_Pawns.Reset();
+	m_LaneGeometry->ClearInstances();
+}
+
+void ADeftStressBenchmark::EndPlay(const EEndPlayReason::Type aEndPlayReason)
+{
+	Cleanup();
+	Super::EndPlay(aEndPlayReason);
+}
+
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs CmdStressRun(
+	TEXT("d.Stress.Run"),
+	TEXT("spawns movement pawns on generated ledge lanes and writes per frame timings to Saved/Benchmarks. args: [count=100 (1-500)] [seconds=30] [exit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& aArgs, UWorld* aWorld)
+	{
+		if (!aWorld)
+			return;
+
+		for (TActorIterator<ADeftStressBenchmark> it(aWorld); it; ++it)
+			it->Destroy();
+
+		const int32 count = aArgs.Num() > 0 ? FCString::Atoi(*aArgs[0]) : 100;
+		const float seconds = aArgs.Num() > 1 ? FMath::Max(1.f, FCString::Atof(*aArgs[1])) : 30.f;
+		const bool bExit = aArgs.Num() > 2 && aArgs[2].Equals(TEXT("exit"), ESearchCase::IgnoreCase);
+
+		ADeftStressBenchmark* benchmark = aWorld->SpawnActor<ADeftStressBenchmark>();
+		if (!benchmark || !benchmark->Start(count, seconds, bExit))
+		{
+			if (benchmark)
+				benchmark->Destroy();
+			if (bExit)
+				FPlatformMisc::RequestExitWithStatus(false, 1, TEXT("d.Stress.Run"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdStressStop(
+	TEXT("d.Stress.Stop"),
+	TEXT("removes any running stress benchmark without writing results"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* aWorld)
+	{
+		for (TActorIterator<ADeftStressBenchmark> it(aWorld); it; ++it)
+			it->Destroy();
+	}));
+#endif
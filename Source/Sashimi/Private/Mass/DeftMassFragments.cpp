@@ -0,0 +1,16 @@
+#include "Mass/DeftMassFragments.h"
+
+FDeftJumpTuning FDeftMassJumpTuningFragment::GetJumpTuning() const
+{
+	FDeftJumpTuning tuning;
+	tuning.m_JumpMaxHeight = JumpMaxHeight;
+	tuning.m_TimeToJumpMaxHeight = TimeToJumpMaxHeight;
+	tuning.m_JumpMinHeight = JumpMinHeight;
+	tuning.m_PostTimeToJumpMaxHeight = PostTimeToJumpMaxHeight;
+	tuning.m_JumpKeyMaxHoldTime = JumpKeyMaxHoldTime;
+	tuning.m_AirDashDistance = AirDashDistance;
+	tuning.m_AirDashTime = AirDashTime;
+	tuning.m_AirDashVerticalHeight = AirDashVerticalHeight;
+	tuning.m_DefaultGravityZ = DefaultGravityZ;
+	return tuning;
+}
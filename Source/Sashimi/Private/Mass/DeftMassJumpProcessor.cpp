@@ -0,0 +1,248 @@
+#include "Mass/DeftMassJumpProcessor.h"
+#include "Mass/DeftMassFragments.h"
+#include "DeftJumpKinematics.h"
+#include "DeftMovementStats.h"
+#include "MassCommonFragments.h"
+#include "MassCommonTypes.h"
+#include "MassExecutionContext.h"
+#include "Engine/World.h"
+#include "CollisionQueryParams.h"
+#include "Async/ParallelFor.h"
+
+static TAutoConsoleVariable<int32> CVarMassJumpMinParallel(TEXT("d.Mass.JumpMinParallel"), 32, TEXT("chunks with fewer agents than this sweep on the game thread, below it the ParallelFor overhead outweighs the queries"));
+
+namespace DeftMassJump
+{
+	// UDeftMovementComponent::ResetJump, minus the ledge and lock state Mass agents don't have
+	void ResetJump(FDeftMassJumpFragment& outJump, const FDeftMassJumpTuningFragment& aTuning)
+	{
+		outJump.bAirDashing = false;
+		outJump.bAirDashExit = false;
+		outJump.bInPlatformJump = false;
+		outJump.bJumpApexReached = false;
+		outJump.GravityScale = aTuning.DefaultGravityScale;
+	}
+
+	// UDeftMovementComponent::OnJumpApexReached
+	void ReachApex(FDeftMassJumpFragment& outJump, const FDeftJumpGravityScales& aScales)
+	{
+		if (outJump.bJumpApexReached)
+			return;
+
+		outJump.bJumpApexReached = true;
+		outJump.bIncrementJumpInputHoldTime = false;
+		outJump.JumpKeyHoldTime = 0.f;
+		outJump.GravityScale = aScales.m_PostJump;
+	}
+
+	// OnMovementModeChanged from falling to walking
+	void Land(FDeftMassJumpFragment& outJump, const FDeftMassJumpTuningFragment& aTuning)
+	{
+		ResetJump(outJump, aTuning);
+		outJump.bFalling = false;
+		outJump.bHasAirDashed = false;
+		outJump.JumpInputCounter = 0;
+		outJump.Velocity.Z = 0.f;
+	}
+
+	// EndAirDash: falling takes over from the top of the dash curve, the dash speed bleeds off until landing
+	void EndAirDash(FDeftMassJumpFragment& outJump, const FDeftJumpGravityScales& aScales)
+	{
+		outJump.bAirDashing = false;
+		outJump.bAirDashExit = true;
+		outJump.bFalling = true;
+		ReachApex(outJump, aScales);
+	}
+
+	// HandleJumpPressed/DoJump, HandleJumpReleased and PerformAirDash
+	void ApplyMoveInput(FDeftMassJumpFragment& outJump, const FQuat& aRotation, const FDeftMassJumpTuningFragment& aTuning, const FDeftJumpTuning& aJumpTuning, const FDeftJumpGravityScales& aScales)
+	{
+		if (outJump.bJumpButtonDown != outJump.bWasJumpButtonDown)
+		{
+			outJump.bWasJumpButtonDown = outJump.bJumpButtonDown;
+			if (outJump.bJumpButtonDown)
+			{
+				outJump.JumpKeyHoldTime = 0.f;
+				outJump.bIncrementJumpInputHoldTime = true;
+				// CanAttemptJump: walking or falling, never mid dash
+				if (outJump.JumpInputCounter < aTuning.JumpInputMax && !outJump.bAirDashing)
+				{
+					const FDeftJumpLaunch jumpLaunch = DeftJumpKinematics::CalculateJumpLaunch(aJumpTuning, ++outJump.JumpInputCounter);
+					outJump.Velocity.Z = jumpLaunch.m_VelocityZ;
+					outJump.GravityScale = jumpLaunch.m_GravityScale;
+					outJump.bFalling = true;
+					outJump.bInPlatformJump = true;
+					outJump.bJumpApexReached = false;
+				}
+			}
+			else if (outJump.bIncrementJumpInputHoldTime)
+			{
+				// quantized like the character so a crowd agent and a player holding for as long jump as high
+				outJump.bIncrementJumpInputHoldTime = false;
+				const uint8 quantizedHoldTime = DeftJumpKinematics::QuantizeHoldTime(outJump.JumpKeyHoldTime, aTuning.JumpKeyMaxHoldTime);
+				const float holdTime = DeftJumpKinematics::DequantizeHoldTime(quantizedHoldTime, aTuning.JumpKeyMaxHoldTime);
+				outJump.GravityScale = DeftJumpKinematics::CalculateHoldTimeGravityScale(holdTime, aTuning.JumpKeyMaxHoldTime, aScales);
+			}
+		}
+
+		if (outJump.bWantsToAirDash)
+		{
+			outJump.bWantsToAirDash = false;
+			if (outJump.bFalling && !outJump.bAirDashing && !outJump.bHasAirDashed && aTuning.AirDashTime > 0.f)
+			{
+				ResetJump(outJump, aTuning);
+				outJump.bAirDashing = true;
+				outJump.bHasAirDashed = true;
+				outJump.AirDashElapsed = 0.f;
+				outJump.AirDashDirection = aRotation.GetForwardVector().GetSafeNormal2D();
+				outJump.Velocity = DeftJumpKinematics::CalculateAirDashVelocity(aJumpTuning, outJump.AirDashDirection, 0.f);
+			}
+		}
+	}
+
+	FVector Integrate(FDeftMassJumpFragment& outJump, const FQuat& aRotation, const FDeftMassJumpTuningFragment& aTuning, const FDeftJumpTuning& aJumpTuning, const FDeftJumpGravityScales& aScales, float aWorldGravityZ, float aDeltaTime)
+	{
+		ApplyMoveInput(outJump, aRotation, aTuning, aJumpTuning, aScales);
+
+		if (outJump.bAirDashing)
+		{
+			// exact at any frame rate, same curve as UDeftMovementComponent::PhysAirDash
+			const float previousElapsed = outJump.AirDashElapsed;
+			outJump.AirDashElapsed = FMath::Min(outJump.AirDashElapsed + aDeltaTime, aTuning.AirDashTime);
+			outJump.Velocity = DeftJumpKinematics::CalculateAirDashVelocity(aJumpTuning, outJump.AirDashDirection, outJump.AirDashElapsed);
+			return DeftJumpKinematics::CalculateAirDashOffset(aJumpTuning, outJump.AirDashDirection, outJump.AirDashElapsed) - DeftJumpKinematics::CalculateAirDashOffset(aJumpTuning, outJump.AirDashDirection, previousElapsed);
+		}
+
+		if (outJump.bFalling)
+		{
+			// PhysFalling: move by the average of the old and new velocity
+			const FVector oldVelocity = outJump.Velocity;
+			outJump.Velocity.Z = FMath::Max(outJump.Velocity.Z + aWorldGravityZ * outJump.GravityScale * aDeltaTime, -aTuning.TerminalVelocity);
+			return 0.5f * (oldVelocity + outJump.Velocity) * aDeltaTime;
+		}
+
+		// walking only looks for the floor under the agent, a step's height down
+		return FVector(0.f, 0.f, -aTuning.MaxStepHeight);
+	}
+
+	// UpdateInternalMoveMode after a falling move
+	void UpdateAfterFalling(FDeftMassJumpFragment& outJump, const FDeftMassJumpTuningFragment& aTuning, const FDeftJumpGravityScales& aScales, float aDeltaTime)
+	{
+		if (outJump.bInPlatformJump && outJump.bIncrementJumpInputHoldTime)
+			outJump.JumpKeyHoldTime += aDeltaTime;
+
+		if (outJump.Velocity.Z < 0.f && !outJump.bJumpApexReached)
+			ReachApex(outJump, aScales);
+
+		if (outJump.bAirDashExit)
+			outJump.Velocity = DeftJumpKinematics::CalculateDashExitVelocity(outJump.Velocity, aTuning.MaxSpeed, aTuning.AirDashExitDeceleration, aDeltaTime);
+	}
+}
+
+UDeftMassJumpProcessor::UDeftMassJumpProcessor()
+	: m_EntityQuery(*this)
+{
+	ExecutionFlags = (int32)(EProcessorExecutionFlags::Standalone | EProcessorExecutionFlags::Server);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Movement;
+}
+
+void UDeftMassJumpProcessor::ConfigureQueries()
+{
+	m_EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FDeftMassJumpFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddConstSharedRequirement<FDeftMassJumpTuningFragment>();
+}
+
+void UDeftMassJumpProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	DEFT_MOVEMENT_SCOPE(MassJump);
+
+	const UWorld* world = EntityManager.GetWorld();
+	if (!world)
+		return;
+
+	const float deltaTime = Context.GetDeltaTimeSeconds();
+	if (deltaTime < UE_SMALL_NUMBER)
+		return;
+
+	const float worldGravityZ = world->GetGravityZ();
+	// Mass may run the processor off the game thread
+	const int32 minParallel = CVarMassJumpMinParallel.GetValueOnAnyThread();
+
+	m_EntityQuery.ForEachEntityChunk(EntityManager, Context, [this, world, deltaTime, worldGravityZ, minParallel](FMassExecutionContext& aContext)
+	{
+		const int32 numEntities = aContext.GetNumEntities();
+		const TArrayView<FTransformFragment> transforms = aContext.GetMutableFragmentView<FTransformFragment>();
+		const TArrayView<FDeftMassJumpFragment> jumps = aContext.GetMutableFragmentView<FDeftMassJumpFragment>();
+		const FDeftMassJumpTuningFragment& tuning = aContext.GetConstSharedFragment<FDeftMassJumpTuningFragment>();
+
+		// the whole chunk shares its tuning, so the kernel input, shape and query params are only built once
+		const FDeftJumpTuning jumpTuning = tuning.GetJumpTuning();
+		const FDeftJumpGravityScales gravityScales = DeftJumpKinematics::CalculateGravityScales(jumpTuning);
+		const FCollisionShape capsule = FCollisionShape::MakeCapsule(tuning.CapsuleRadius, tuning.CapsuleHalfHeight);
+		const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(DeftMassJump), false);
+		const FVector capsuleOffset(0.f, 0.f, tuning.CapsuleHalfHeight);
+
+		m_MoveDeltas.SetNumUninitialized(numEntities, EAllowShrinking::No);
+		m_Hits.SetNum(numEntities, EAllowShrinking::No);
+		m_bHits.SetNumUninitialized(numEntities, EAllowShrinking::No);
+
+		// 1. input and integration, where every agent wants to go this step
+		for (int32 index = 0; index < numEntities; ++index)
+			m_MoveDeltas[index] = DeftMassJump::Integrate(jumps[index], transforms[index].GetTransform().GetRotation(), tuning, jumpTuning, gravityScales, worldGravityZ, deltaTime);
+
+		// 2. every scene query in the chunk, spread over the task graph, each only reads its own input and writes its own hit
+		const EParallelForFlags parallelFlags = numEntities < minParallel ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+		ParallelFor(numEntities, [this, world, &transforms, &tuning, &capsule, &queryParams, &capsuleOffset](int32 aIndex)
+		{
+			const FVector start = transforms[aIndex].GetTransform().GetLocation() + capsuleOffset;
+			m_bHits[aIndex] = world->SweepSingleByChannel(m_Hits[aIndex], start, start + m_MoveDeltas[aIndex], FQuat::Identity, tuning.CollisionChannel, capsule, queryParams);
+		}, parallelFlags);
+		DeftMovementStats::AddCount(EDeftMovementCounter::SceneQueries, numEntities);
+
+		// 3. move and resolve the hits
+		for (int32 index = 0; index < numEntities; ++index)
+		{
+			FDeftMassJumpFragment& jump = jumps[index];
+			FTransform& transform = transforms[index].GetMutableTransform();
+			const FHitResult& hit = m_Hits[index];
+			const bool bBlockingHit = m_bHits[index] && hit.bBlockingHit;
+			const bool bWalkableHit = bBlockingHit && hit.ImpactNormal.Z >= tuning.WalkableFloorZ;
+
+			if (!jump.bFalling && !jump.bAirDashing)
+			{
+				// walked off a ledge, not a platform jump so there's no hold time, the apex check still switches to post jump gravity
+				if (!bWalkableHit)
+				{
+					jump.bFalling = true;
+					jump.Velocity.Z = 0.f;
+				}
+				continue;
+			}
+
+			const FVector moveDelta = m_MoveDeltas[index];
+			transform.AddToTranslation(bBlockingHit ? moveDelta * hit.Time : moveDelta);
+
+			if (jump.bAirDashing)
+			{
+				// anything in the way ends the dash without the velocity into the surface
+				if (bBlockingHit)
+					jump.Velocity = FVector::VectorPlaneProject(jump.Velocity, hit.Normal);
+				if (bBlockingHit || jump.AirDashElapsed >= tuning.AirDashTime)
+					DeftMassJump::EndAirDash(jump, gravityScales);
+				continue;
+			}
+
+			if (bWalkableHit && jump.Velocity.Z <= 0.f)
+			{
+				DeftMassJump::Land(jump, tuning);
+				continue;
+			}
+
+			if (bBlockingHit)
+				jump.Velocity = FVector::VectorPlaneProject(jump.Velocity, hit.Normal);
+
+			DeftMassJump::UpdateAfterFalling(jump, tuning, gravityScales, deltaTime);
+		}
+	});
+}
@@ -0,0 +1,40 @@
+#include "Mass/DeftMassJumpTrait.h"
+#include "Mass/DeftMassFragments.h"
+#include "DeftMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "MassEntityTemplateRegistry.h"
+#include "MassEntityUtils.h"
+#include "MassCommonFragments.h"
+
+void UDeftMassJumpTrait::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const
+{
+	BuildContext.RequireFragment<FTransformFragment>();
+	BuildContext.AddFragment<FDeftMassJumpFragment>();
+
+	// tuning comes from the class defaults, the same values a spawned character's component would start with
+	const ACharacter* character = TuningCharacter ? TuningCharacter->GetDefaultObject<ACharacter>() : nullptr;
+	const UDeftMovementComponent* movement = character ? Cast<UDeftMovementComponent>(character->GetCharacterMovement()) : nullptr;
+	if (TuningCharacter && !movement)
+		UE_LOG(LogDeftMovement, Warning, TEXT("%s: %s has no deft movement component, using the defaults"), *GetName(), *TuningCharacter->GetName());
+	if (!movement)
+		movement = GetDefault<UDeftMovementComponent>();
+
+	FDeftMassJumpTuningFragment tuning;
+	movement->FillMassJumpTuning(tuning);
+	if (const UCapsuleComponent* capsule = character ? character->GetCapsuleComponent() : nullptr)
+	{
+		tuning.CapsuleRadius = capsule->GetScaledCapsuleRadius();
+		tuning.CapsuleHalfHeight = capsule->GetScaledCapsuleHalfHeight();
+		tuning.CollisionChannel = capsule->GetCollisionObjectType();
+	}
+	else
+	{
+		const UCapsuleComponent* defaultCapsule = GetDefault<UCapsuleComponent>();
+		tuning.CapsuleRadius = defaultCapsule->GetUnscaledCapsuleRadius();
+		tuning.CapsuleHalfHeight = defaultCapsule->GetUnscaledCapsuleHalfHeight();
+	}
+
+	FMassEntityManager& entityManager = UE::Mass::Utils::GetEntityManagerChecked(World);
+	BuildContext.AddConstSharedFragment(entityManager.GetOrCreateConstSharedFragment(tuning));
+}
@@ -0,0 +1,135 @@
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "Character/DeftInputReplayComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/FileManager.h"
+#include "Kismet/GameplayStatics.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DeftInputReplayTest
+{
+	static const TCHAR* MapName = TEXT("/Game/game/maps/playground");
+	static const TCHAR* ReplayName = TEXT("AutomationInputReplay");
+	static constexpr float FixedDeltaTime = 1.f / 60.f;
+	static constexpr uint32 ScriptFrames = 240;
+	// the same inputs on the same fixed step have to land in the same place, anything more is a replay bug
+	static constexpr float Tolerance = 0.1f;
+	static constexpr float TimeoutSeconds = 30.f;
+
+	struct TestState
+	{
+		TWeakObjectPtr<UDeftInputReplayComponent> m_Replay;
+		uint32 m_Frame = 0;
+		double m_StartTime = 0.0;
+	};
+
+	// Walks, turns, jumps and dashes, queued a frame at a time like Enhanced Input fires the handlers
+	void QueueScriptFrame(UDeftInputReplayComponent& aReplay, uint32 aFrame)
+	{
+		// move is repeated every frame it's held and sent once more as zero on release (ETriggerEvent::Completed)
+		if (aFrame < 150)
+			aReplay.QueueInput(EDeftReplayInput::Move, aFrame < 90 ? FVector2D(0.f, 1.f) : FVector2D(1.f, 0.5f));
+		else if (aFrame == 150)
+			aReplay.QueueInput(EDeftReplayInput::Move, FVector2D::ZeroVector);
+		// look changes the move direction, off by a frame it shows up as a deviation
+		if (aFrame >= 20 && aFrame < 80)
+			aReplay.QueueInput(EDeftReplayInput::Look, FVector2D(1.5f, 0.f));
+
+		switch (aFrame)
+		{
+			case 30:	aReplay.QueueInput(EDeftReplayInput::JumpPressed); break;
+			case 45:	aReplay.QueueInput(EDeftReplayInput::JumpReleased); break;
+			case 110:	aReplay.QueueInput(EDeftReplayInput::JumpPressed); break;
+			case 116:	aReplay.QueueInput(EDeftReplayInput::JumpReleased); break;
+			case 130:	aReplay.QueueInput(EDeftReplayInput::AirDash); break;
+			default:	break;
+		}
+	}
+}
+
+/**
+ * Records a scripted session with UDeftInputReplayComponent, plays it back and checks the character retraces the
+ * recorded trajectory, so d.Replay.Play reports determinism rather than the replay's own timing. Needs a game world,
+ * run it headless with
+ *   -game -nullrhi -unattended -ExecCmds="Automation RunTests Sashimi.Movement.InputReplay; Quit"
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeftInputReplayTest, "Sashimi.Movement.InputReplay", EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FDeftInputReplayTest::RunTest(const FString& aParameters)
+{
+	using namespace DeftInputReplayTest;
+
+	AutomationOpenMap(MapName);
+
+	TSharedRef<TestState> state = MakeShared<TestState>();
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, state]()
+	{
+		const ACharacter* character = UGameplayStatics::GetPlayerCharacter(AutomationCommon::GetAnyGameWorld(), 0);
+		UDeftInputReplayComponent* replay = character ? character->FindComponentByClass<UDeftInputReplayComponent>() : nullptr;
+		if (!replay)
+		{
+			AddError(TEXT("the player character has no UDeftInputReplayComponent"));
+			return true;
+		}
+
+		replay->StartRecording(ReplayName, FixedDeltaTime);
+		state->m_Replay = replay;
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([state]()
+	{
+		UDeftInputReplayComponent* replay = state->m_Replay.Get();
+		if (!replay || !replay->IsRecording())
+			return true;
+
+		if (state->m_Frame < ScriptFrames)
+		{
+			QueueScriptFrame(*replay, state->m_Frame++);
+			return false;
+		}
+
+		replay->Stop();
+		replay->StartPlayback(ReplayName, Tolerance);
+		state->m_StartTime = FPlatformTime::Seconds();
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, state]()
+	{
+		const UDeftInputReplayComponent* replay = state->m_Replay.Get();
+		if (!replay)
+			return true;
+
+		if (replay->IsPlayingBack())
+		{
+			if (FPlatformTime::Seconds() - state->m_StartTime < TimeoutSeconds)
+				return false;
+
+			AddError(FString::Printf(TEXT("the playback didn't finish within %.0f s"), TimeoutSeconds));
+			return true;
+		}
+
+		const UDeftInputReplayComponent::PlaybackResults* results = replay->GetPlaybackResults();
+		if (!TestNotNull(TEXT("the playback finished, see LogDeftReplay"), results))
+			return true;
+
+		TestTrue(FString::Printf(TEXT("%d frames played back"), results->m_Frames), results->m_Frames >= (int32)ScriptFrames);
+		TestTrue(FString::Printf(TEXT("max deviation %.3f cm at frame %u, under %.2f cm"), results->m_MaxDeviation, results->m_MaxDeviationFrame, Tolerance), results->m_MaxDeviation <= Tolerance);
+		TestEqual(TEXT("frames over tolerance"), results->m_FramesOverTolerance, 0u);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([]()
+	{
+		IFileManager::Get().Delete(*FDeftInputReplay::GetReplayPath(ReplayName));
+		return true;
+	}));
+
+	return true;
+}
+
+#endif
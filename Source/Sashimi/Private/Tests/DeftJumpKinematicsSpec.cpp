@@ -0,0 +1,161 @@
+#include "Misc/AutomationTest.h"
+#include "DeftJumpKinematics.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DeftJumpKinematicsSpec
+{
+	// the frame rates we ship at and the ends of the range we support
+	static const float FrameRates[] = { 30.f, 60.f, 120.f, 144.f, 240.f };
+
+	// slack for float accumulation over a whole jump
+	static constexpr float HeightEpsilon = 0.01f;
+
+	// a single vector lane, a partial one, exactly one, one plus a remainder and a crowd
+	static const int32 BatchSizes[] = { 1, 3, 4, 5, 1000 };
+	// relative, the vector and scalar paths may round differently but run the same formulas
+	static constexpr float BatchEpsilon = 1e-5f;
+
+	FDeftJumpTuning MakeTuning()
+	{
+		FDeftJumpTuning tuning;
+		tuning.m_JumpMaxHeight = 250.f;
+		tuning.m_TimeToJumpMaxHeight = 0.45f;
+		tuning.m_JumpMinHeight = 100.f;
+		tuning.m_PostTimeToJumpMaxHeight = 0.3f;
+		tuning.m_JumpKeyMaxHoldTime = 0.2f;
+		tuning.m_AirDashDistance = 500.f;
+		tuning.m_AirDashTime = 0.25f;
+		tuning.m_AirDashVerticalHeight = 20.f;
+		tuning.m_DefaultGravityZ = -980.f;
+		return tuning;
+	}
+
+	// Averaging the old and new velocity (PhysFalling) is exact under constant gravity at every step, the apex can only be
+	// missed by falling between two steps which loses at most g * dt^2 / 8
+	float GetApexTolerance(float aGravityZ, float aTimeStep)
+	{
+		return FMath::Abs(aGravityZ) * aTimeStep * aTimeStep / 8.f + HeightEpsilon;
+	}
+}
+
+BEGIN_DEFINE_SPEC(FDeftJumpKinematicsSpec, "Sashimi.Movement.JumpKinematics", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	FDeftJumpTuning m_Tuning;
+	FDeftJumpGravityScales m_Scales;
+
+	void TestBatchEqual(const TCHAR* aWhat, const TArray<float>& aScalar, const TArray<float>& aBatch)
+	{
+		for (int32 i = 0; i < aScalar.Num(); ++i)
+		{
+			const float tolerance = DeftJumpKinematicsSpec::BatchEpsilon * FMath::Max(FMath::Abs(aScalar[i]), 1.f);
+			if (!FMath::IsNearlyEqual(aScalar[i], aBatch[i], tolerance))
+			{
+				AddError(FString::Printf(TEXT("%s [%d of %d]: scalar %g, batch %g"), aWhat, i, aScalar.Num(), aScalar[i], aBatch[i]));
+				return;
+			}
+		}
+	}
+
+	void TestApex(const TCHAR* aWhat, float aVelocityZ, float aGravityScale, float aExpectedHeight, float aFrameRate)
+	{
+		const float gravityZ = m_Tuning.m_DefaultGravityZ * aGravityScale;
+		const float timeStep = 1.f / aFrameRate;
+		const float apex = DeftJumpKinematics::SimulateApexHeight(aVelocityZ, gravityZ, timeStep);
+		const float tolerance = DeftJumpKinematicsSpec::GetApexTolerance(gravityZ, timeStep);
+		TestTrue(FString::Printf(TEXT("%s apex %.3f cm never overshoots %.3f cm"), aWhat, apex, aExpectedHeight), apex <= aExpectedHeight + DeftJumpKinematicsSpec::HeightEpsilon);
+		TestNearlyEqual(FString::Printf(TEXT("%s apex at %.0f Hz"), aWhat, aFrameRate), apex, aExpectedHeight, tolerance);
+	}
+END_DEFINE_SPEC(FDeftJumpKinematicsSpec)
+
+void FDeftJumpKinematicsSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		m_Tuning = DeftJumpKinematicsSpec::MakeTuning();
+		m_Scales = DeftJumpKinematics::CalculateGravityScales(m_Tuning);
+	});
+
+	Describe("Apex height", [this]()
+	{
+		for (const float frameRate : DeftJumpKinematicsSpec::FrameRates)
+		{
+			It(FString::Printf(TEXT("single jump held to the apex reaches JumpMaxHeight at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				const FDeftJumpLaunch launch = DeftJumpKinematics::CalculateJumpLaunch(m_Tuning, 1);
+				TestApex(TEXT("single jump"), launch.m_VelocityZ, launch.m_GravityScale, m_Tuning.m_JumpMaxHeight, frameRate);
+			});
+
+			It(FString::Printf(TEXT("double jump reaches the scaled JumpMaxHeight at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				const FDeftJumpLaunch launch = DeftJumpKinematics::CalculateJumpLaunch(m_Tuning, 2);
+				TestApex(TEXT("double jump"), launch.m_VelocityZ, launch.m_GravityScale, m_Tuning.m_JumpMaxHeight * DeftJumpKinematics::DoubleJumpScale, frameRate);
+			});
+
+			It(FString::Printf(TEXT("single jump released immediately reaches JumpMinHeight at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				const FDeftJumpLaunch launch = DeftJumpKinematics::CalculateJumpLaunch(m_Tuning, 1);
+				const float releaseScale = DeftJumpKinematics::CalculateHoldTimeGravityScale(0.f, m_Tuning.m_JumpKeyMaxHoldTime, m_Scales);
+				TestApex(TEXT("min jump"), launch.m_VelocityZ, releaseScale, m_Tuning.m_JumpMinHeight, frameRate);
+			});
+		}
+	});
+
+	Describe("Batch kernels", [this]()
+	{
+		for (const int32 size : DeftJumpKinematicsSpec::BatchSizes)
+		{
+			It(FString::Printf(TEXT("match the scalar functions for %d characters"), size), [this, size]()
+			{
+				FRandomStream random(size);
+				TArray<float> time, height, holdTime, maxHoldTime, maxPreJump, minPreJump, velocityX, velocityY, forwardX, forwardY, boost, deltaTime;
+				for (TArray<float>* array : { &time, &height, &holdTime, &maxHoldTime, &maxPreJump, &minPreJump, &velocityX, &velocityY, &forwardX, &forwardY, &boost, &deltaTime })
+					array->SetNumZeroed(size);
+				for (int32 i = 0; i < size; ++i)
+				{
+					time[i] = random.FRandRange(0.2f, 0.6f);
+					height[i] = random.FRandRange(50.f, 300.f);
+					// past the max hold time too, the clamp has to match
+					holdTime[i] = random.FRandRange(0.f, 0.3f);
+					maxHoldTime[i] = m_Tuning.m_JumpKeyMaxHoldTime;
+					maxPreJump[i] = random.FRandRange(1.f, 2.f);
+					minPreJump[i] = maxPreJump[i] + random.FRandRange(0.5f, 1.5f);
+					velocityX[i] = random.FRandRange(-600.f, 600.f);
+					velocityY[i] = random.FRandRange(-600.f, 600.f);
+					const float yaw = random.FRandRange(0.f, 2.f * UE_PI);
+					forwardX[i] = FMath::Cos(yaw);
+					forwardY[i] = FMath::Sin(yaw);
+					// every other character isn't ledging up, a zero boost has to leave it alone
+					boost[i] = (i & 1) ? 0.f : random.FRandRange(0.f, 600.f);
+					deltaTime[i] = random.FRandRange(1.f / 240.f, 1.f / 30.f);
+				}
+
+				TArray<float> scalarVelocityZ, scalarGravityScale, scalarHoldScale, scalarVelocityX, scalarVelocityY;
+				for (int32 i = 0; i < size; ++i)
+				{
+					scalarVelocityZ.Add(DeftJumpKinematics::CalculateInitialVelocityZ(time[i], height[i]));
+					scalarGravityScale.Add(DeftJumpKinematics::CalculateGravityScale(time[i], height[i], m_Tuning.m_DefaultGravityZ));
+					scalarHoldScale.Add(DeftJumpKinematics::CalculateHoldTimeGravityScale(holdTime[i], maxHoldTime[i], { maxPreJump[i], minPreJump[i], 0.f }));
+					scalarVelocityX.Add(velocityX[i] + forwardX[i] * (boost[i] * deltaTime[i]));
+					scalarVelocityY.Add(velocityY[i] + forwardY[i] * (boost[i] * deltaTime[i]));
+				}
+
+				TArray<float> batchVelocityZ, batchGravityScale, batchHoldScale;
+				batchVelocityZ.SetNumZeroed(size);
+				batchGravityScale.SetNumZeroed(size);
+				batchHoldScale.SetNumZeroed(size);
+				DeftJumpKinematicsBatch::CalculateInitialVelocityZ(time.GetData(), height.GetData(), batchVelocityZ.GetData(), size);
+				DeftJumpKinematicsBatch::CalculateGravityScale(time.GetData(), height.GetData(), m_Tuning.m_DefaultGravityZ, batchGravityScale.GetData(), size);
+				DeftJumpKinematicsBatch::CalculateHoldTimeGravityScale(holdTime.GetData(), maxHoldTime.GetData(), maxPreJump.GetData(), minPreJump.GetData(), batchHoldScale.GetData(), size);
+				DeftJumpKinematicsBatch::ApplyForwardBoost(velocityX.GetData(), velocityY.GetData(), forwardX.GetData(), forwardY.GetData(), boost.GetData(), deltaTime.GetData(), size);
+
+				TestBatchEqual(TEXT("initial velocity Z"), scalarVelocityZ, batchVelocityZ);
+				TestBatchEqual(TEXT("gravity scale"), scalarGravityScale, batchGravityScale);
+				TestBatchEqual(TEXT("hold time gravity scale"), scalarHoldScale, batchHoldScale);
+				TestBatchEqual(TEXT("boosted velocity X"), scalarVelocityX, velocityX);
+				TestBatchEqual(TEXT("boosted velocity Y"), scalarVelocityY, velocityY);
+			});
+		}
+	});
+}
+
+#endif//WITH_DEV_AUTOMATION_TESTS
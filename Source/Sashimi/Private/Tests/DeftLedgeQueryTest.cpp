@@ -0,0 +1,127 @@
+#include "Misc/AutomationTest.h"
+#include "Character/PlayerCharacter.h"
+#include "DeftMovementComponent.h"
+#include "DeftLedgeProbe.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "UObject/UnrealType.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DeftLedgeQueryTest
+{
+	static constexpr int32 Iterations = 100;
+	static constexpr float CubeSize = 100.f;		// /Engine/BasicShapes/Cube is 100 units, centered
+
+	// ledge tuning normally comes from the character blueprint
+	static constexpr float WallReach = 100.f;
+	static constexpr float LedgeHeightOrigin = 150.f;
+	static constexpr float LedgeHeightForwardReach = 100.f;
+
+	// a block whose near face is WallDistance in front of the character and whose top is LedgeHeight above the floor,
+	// inside the wall ray's reach and under the space ray
+	static constexpr float WallDistance = 60.f;
+	static constexpr float LedgeHeight = 150.f;
+	// small enough to stay clear of the wall, space and surface rays while still inside the clearance capsule
+	static constexpr float BlockerSize = 20.f;
+
+	AStaticMeshActor* SpawnBlock(UWorld& aWorld, UStaticMesh& aCube, const FVector& aMin, const FVector& aMax)
+	{
+		AStaticMeshActor* block = aWorld.SpawnActor<AStaticMeshActor>((aMin + aMax) * 0.5f, FRotator::ZeroRotator);
+		if (!block)
+			return nullptr;
+
+		UStaticMeshComponent* mesh = block->GetStaticMeshComponent();
+		mesh->SetMobility(EComponentMobility::Movable);
+		mesh->SetStaticMesh(&aCube);
+		mesh->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		block->SetActorScale3D((aMax - aMin) / CubeSize);
+		return block;
+	}
+
+	void SetTuning(UDeftMovementComponent& outMovement, const TCHAR* aName, float aValue)
+	{
+		if (FFloatProperty* property = FindFProperty<FFloatProperty>(UDeftMovementComponent::StaticClass(), aName))
+			property->SetPropertyValue_InContainer(&outMovement, aValue);
+	}
+}
+
+/**
+ * Builds a floor and a ledge in an empty world and measures ledge detection from in front of it (what d.Ledge.CountQueries
+ * logs). Every path has to find the ledge and the coherence cache has to answer repeats with fewer queries than tracing.
+ * Then a blocker is placed where the capsule would stand on the ledge, and the sweep and overlap clearance tests both
+ * have to turn the ledge down.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeftLedgeQueryTest, "Sashimi.Movement.LedgeQueries", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDeftLedgeQueryTest::RunTest(const FString& aParameters)
+{
+	using namespace DeftLedgeQueryTest;
+
+	UStaticMesh* cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("cube mesh"), cube))
+		return false;
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("DeftLedgeQueryTest"));
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+	world->InitializeActorsForPlay(FURL());
+	world->BeginPlay();
+
+	// floor with its top at z = 0, the ledge block in front of the character along +X
+	SpawnBlock(*world, *cube, FVector(-500.f, -500.f, -CubeSize), FVector(1000.f, 500.f, 0.f));
+	SpawnBlock(*world, *cube, FVector(WallDistance, -200.f, 0.f), FVector(WallDistance + 400.f, 200.f, LedgeHeight));
+	world->Tick(LEVELTICK_All, 1.f / 60.f);
+
+	const float capsuleHalfHeight = GetDefault<APlayerCharacter>()->GetSimpleCollisionHalfHeight();
+	APlayerCharacter* character = world->SpawnActor<APlayerCharacter>(FVector(0.f, 0.f, capsuleHalfHeight + 1.f), FRotator::ZeroRotator);
+	UDeftMovementComponent* movement = character ? Cast<UDeftMovementComponent>(character->GetCharacterMovement()) : nullptr;
+	if (TestNotNull(TEXT("Deft character"), movement))
+	{
+		SetTuning(*movement, TEXT("WallReach"), WallReach);
+		SetTuning(*movement, TEXT("LedgeHeightOrigin"), LedgeHeightOrigin);
+		SetTuning(*movement, TEXT("LedgeHeightForwardReach"), LedgeHeightForwardReach);
+
+		const UDeftMovementComponent::LedgeQueryMeasurement sweep = movement->MeasureLedgeQueries(Iterations, true, false);
+		const UDeftMovementComponent::LedgeQueryMeasurement overlap = movement->MeasureLedgeQueries(Iterations, true, true);
+		const UDeftMovementComponent::LedgeQueryMeasurement cached = movement->MeasureLedgeQueries(Iterations, false, true);
+
+		TestTrue(TEXT("the sweep clearance finds the ledge"), sweep.m_bLedgeFound);
+		TestTrue(TEXT("the overlap clearance finds the ledge"), overlap.m_bLedgeFound);
+		TestTrue(TEXT("the coherence cache finds the ledge"), cached.m_bLedgeFound);
+		// wall, space, surface and clearance, the clearance is one query either way
+		TestEqual(TEXT("traced ledge detection with the sweep clearance"), sweep.m_QueriesPerFindLedge, 4.f);
+		TestTrue(FString::Printf(TEXT("coherence cache %.2f queries/FindLedge, fewer than tracing's %.2f"), cached.m_QueriesPerFindLedge, overlap.m_QueriesPerFindLedge), cached.m_QueriesPerFindLedge < overlap.m_QueriesPerFindLedge);
+
+		// where the clearance test puts the capsule on the ledge surface, the surface ray lands LedgeHeightForwardReach ahead
+		const UCapsuleComponent* capsule = character->GetCapsuleComponent();
+		FDeftLedgeProbe probe;
+		probe.m_CapsuleHalfHeight = capsule->GetScaledCapsuleHalfHeight();
+		FVector clearanceCenter, clearanceEnd;
+		probe.GetClearanceSweep(FVector(LedgeHeightForwardReach, 0.f, LedgeHeight), clearanceCenter, clearanceEnd);
+
+		// in the lower half of the capsule, pushed away from the wall by half its radius
+		const FVector blockerCenter = clearanceCenter + FVector(capsule->GetScaledCapsuleRadius() * 0.5f, 0.f, -probe.m_CapsuleHalfHeight * 0.5f);
+		const FVector blockerExtent(BlockerSize * 0.5f);
+		SpawnBlock(*world, *cube, blockerCenter - blockerExtent, blockerCenter + blockerExtent);
+		world->Tick(LEVELTICK_All, 1.f / 60.f);
+
+		const UDeftMovementComponent::LedgeQueryMeasurement blockedSweep = movement->MeasureLedgeQueries(1, true, false);
+		const UDeftMovementComponent::LedgeQueryMeasurement blockedOverlap = movement->MeasureLedgeQueries(1, true, true);
+		TestFalse(TEXT("the sweep clearance turns down a ledge with no room to stand"), blockedSweep.m_bLedgeFound);
+		TestFalse(TEXT("the overlap clearance turns down a ledge with no room to stand"), blockedOverlap.m_bLedgeFound);
+		// the edge is still there, it's the clearance test that failed
+		TestEqual(TEXT("the blocker doesn't get in the way of the edge rays"), blockedOverlap.m_QueriesPerFindLedge, 4.f);
+	}
+
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	return true;
+}
+
+#endif
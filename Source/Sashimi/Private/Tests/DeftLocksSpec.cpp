@@ -0,0 +1,112 @@
+#include "Misc/AutomationTest.h"
+#include "DeftLocks.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FDeftLocksSpec, "Sashimi.Movement.DeftLocks", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	TUniquePtr<DeftLocks> m_Locks;
+END_DEFINE_SPEC(FDeftLocksSpec)
+
+void FDeftLocksSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		m_Locks = MakeUnique<DeftLocks>();
+	});
+
+	AfterEach([this]()
+	{
+		m_Locks.Reset();
+	});
+
+	Describe("Handles", [this]()
+	{
+		It("release their locks when they go out of scope", [this]()
+		{
+			{
+				DeftLockHandle handle = m_Locks->Acquire(EDeftLock::AllMoveInput, TEXT("Test"));
+				TestTrue(TEXT("forward/back locked while held"), m_Locks->IsMoveInputForwardBackLocked());
+				TestTrue(TEXT("right/left locked while held"), m_Locks->IsMoveInputRightLeftLocked());
+			}
+			TestFalse(TEXT("nothing locked after the handle is gone"), m_Locks->IsLocked(EDeftLock::AllMoveInput));
+		});
+
+		It("count overlapping holds on the same lock", [this]()
+		{
+			DeftLockHandle first = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("First"));
+			DeftLockHandle second = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("Second"));
+			TestEqual(TEXT("two holds"), m_Locks->GetLockCount(EDeftLock::MoveInputForwardBack), (uint8)2);
+
+			first.Release();
+			TestTrue(TEXT("still locked by the second handle"), m_Locks->IsMoveInputForwardBackLocked());
+			second.Release();
+			TestFalse(TEXT("unlocked once both are released"), m_Locks->IsMoveInputForwardBackLocked());
+		});
+
+		It("release only part of their locks when asked", [this]()
+		{
+			DeftLockHandle handle = m_Locks->Acquire(EDeftLock::AllMoveInput, TEXT("Test"));
+			handle.Release(EDeftLock::MoveInputForwardBack);
+			TestFalse(TEXT("forward/back released"), m_Locks->IsMoveInputForwardBackLocked());
+			TestTrue(TEXT("right/left still held"), m_Locks->IsMoveInputRightLeftLocked());
+			TestTrue(TEXT("handle still holds right/left"), handle.IsHeld(EDeftLock::MoveInputRightLeft));
+
+			handle.Release(EDeftLock::MoveInputForwardBack);
+			TestEqual(TEXT("releasing the same lock twice doesn't touch the count"), m_Locks->GetLockCount(EDeftLock::MoveInputRightLeft), (uint8)1);
+		});
+
+		It("release what they held when reassigned", [this]()
+		{
+			DeftLockHandle handle = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("First"));
+			handle = m_Locks->Acquire(EDeftLock::MoveInputRightLeft, TEXT("Second"));
+			TestFalse(TEXT("first lock released"), m_Locks->IsMoveInputForwardBackLocked());
+			TestTrue(TEXT("second lock held"), m_Locks->IsMoveInputRightLeftLocked());
+		});
+
+		It("hand ownership over when moved", [this]()
+		{
+			DeftLockHandle source = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("Test"));
+			DeftLockHandle destination(MoveTemp(source));
+			TestFalse(TEXT("moved from handle holds nothing"), source.IsHeld());
+			source.Release();
+			TestTrue(TEXT("still locked by the moved to handle"), m_Locks->IsMoveInputForwardBackLocked());
+		});
+	});
+
+	Describe("UnlockAll", [this]()
+	{
+		It("turns handles acquired before it into no-ops", [this]()
+		{
+			DeftLockHandle stale = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("Stale"));
+			m_Locks->UnlockAll();
+			TestFalse(TEXT("unlocked"), m_Locks->IsMoveInputForwardBackLocked());
+
+			DeftLockHandle fresh = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("Fresh"));
+			stale.Release();
+			TestTrue(TEXT("the stale release didn't take the fresh hold"), m_Locks->IsMoveInputForwardBackLocked());
+			TestEqual(TEXT("stale release counted"), m_Locks->GetStats().m_StaleReleases, 1u);
+		});
+	});
+
+	Describe("CheckForLeaks", [this]()
+	{
+		It("reports nothing when every handle was released", [this]()
+		{
+			m_Locks->Acquire(EDeftLock::AllMoveInput, TEXT("Test")).Release();
+			TestFalse(TEXT("no leak"), m_Locks->CheckForLeaks(TEXT("testing")));
+			TestEqual(TEXT("no leak counted"), m_Locks->GetStats().m_LeaksDetected, 0u);
+		});
+
+		It("reports and clears a lock that is still held", [this]()
+		{
+			AddExpectedError(TEXT("lock 0 still held 1 time\\(s\\) when testing, last acquired by Leaker"), EAutomationExpectedErrorFlags::Contains, 1);
+
+			DeftLockHandle leaked = m_Locks->Acquire(EDeftLock::MoveInputForwardBack, TEXT("Leaker"));
+			TestTrue(TEXT("leak found"), m_Locks->CheckForLeaks(TEXT("testing")));
+			TestFalse(TEXT("cleared"), m_Locks->IsMoveInputForwardBackLocked());
+			TestEqual(TEXT("leak counted"), m_Locks->GetStats().m_LeaksDetected, 1u);
+		});
+	});
+}
+
+#endif//WITH_DEV_AUTOMATION_TESTS
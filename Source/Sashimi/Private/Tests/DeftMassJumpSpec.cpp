@@ -0,0 +1,152 @@
+#include "Misc/AutomationTest.h"
+#include "DeftJumpKinematics.h"
+#include "Mass/DeftMassFragments.h"
+#include "Mass/DeftMassJumpProcessor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DeftMassJumpSpec
+{
+	// the frame rates we ship at and the ends of the range we support
+	static const float FrameRates[] = { 30.f, 60.f, 120.f, 144.f, 240.f };
+
+	// the processor and the kernel run the same steps, only the float accumulation differs
+	static constexpr float HeightEpsilon = 0.01f;
+
+	// way past the apex of any jump below
+	static constexpr int32 MaxSteps = 1000;
+
+	// Same tuning as DeftJumpKinematicsSpec, in the shape UDeftMassJumpTrait builds it
+	FDeftMassJumpTuningFragment MakeTuning()
+	{
+		FDeftMassJumpTuningFragment tuning;
+		tuning.JumpMaxHeight = 250.f;
+		tuning.TimeToJumpMaxHeight = 0.45f;
+		tuning.JumpMinHeight = 100.f;
+		tuning.PostTimeToJumpMaxHeight = 0.3f;
+		tuning.JumpKeyMaxHoldTime = 0.2f;
+		tuning.AirDashDistance = 500.f;
+		tuning.AirDashTime = 0.25f;
+		tuning.AirDashVerticalHeight = 20.f;
+		tuning.AirDashExitDeceleration = 2000.f;
+		tuning.DefaultGravityZ = -980.f;
+		tuning.DefaultGravityScale = 1.f;
+		tuning.MaxSpeed = 600.f;
+		tuning.TerminalVelocity = 4000.f;
+		return tuning;
+	}
+
+	// Steps a grounded agent through a jump in open air the way UDeftMassJumpProcessor does, releasing jump before
+	// step aReleaseStep (INDEX_NONE holds it). Returns the highest the agent got above where it jumped from
+	float SimulateJump(const FDeftMassJumpTuningFragment& aTuning, int32 aReleaseStep, float aTimeStep)
+	{
+		const FDeftJumpTuning jumpTuning = aTuning.GetJumpTuning();
+		const FDeftJumpGravityScales scales = DeftJumpKinematics::CalculateGravityScales(jumpTuning);
+
+		FDeftMassJumpFragment jump;
+		jump.GravityScale = aTuning.DefaultGravityScale;
+		jump.bJumpButtonDown = true;
+
+		float height = 0.f;
+		float apex = 0.f;
+		for (int32 step = 0; step < MaxSteps && !jump.bJumpApexReached; ++step)
+		{
+			if (step == aReleaseStep)
+				jump.bJumpButtonDown = false;
+
+			height += DeftMassJump::Integrate(jump, FQuat::Identity, aTuning, jumpTuning, scales, jumpTuning.m_DefaultGravityZ, aTimeStep).Z;
+			apex = FMath::Max(apex, height);
+			DeftMassJump::UpdateAfterFalling(jump, aTuning, scales, aTimeStep);
+		}
+		return apex;
+	}
+
+	// The kernel's answer for the same jump: launch gravity until the release, then the quantized hold time's gravity to the apex
+	float CalculateExpectedApex(const FDeftMassJumpTuningFragment& aTuning, int32 aReleaseStep, float aTimeStep)
+	{
+		const FDeftJumpTuning jumpTuning = aTuning.GetJumpTuning();
+		const FDeftJumpGravityScales scales = DeftJumpKinematics::CalculateGravityScales(jumpTuning);
+		const FDeftJumpLaunch launch = DeftJumpKinematics::CalculateJumpLaunch(jumpTuning, 1);
+		const float launchGravityZ = jumpTuning.m_DefaultGravityZ * launch.m_GravityScale;
+		if (aReleaseStep == INDEX_NONE)
+			return DeftJumpKinematics::SimulateApexHeight(launch.m_VelocityZ, launchGravityZ, aTimeStep);
+
+		// averaging the old and new velocity is exact under constant gravity, so the held part has a closed form
+		const float holdTime = aReleaseStep * aTimeStep;
+		const float releaseHeight = launch.m_VelocityZ * holdTime + 0.5f * launchGravityZ * holdTime * holdTime;
+		const float releaseVelocityZ = launch.m_VelocityZ + launchGravityZ * holdTime;
+
+		const uint8 quantizedHoldTime = DeftJumpKinematics::QuantizeHoldTime(holdTime, aTuning.JumpKeyMaxHoldTime);
+		const float releaseScale = DeftJumpKinematics::CalculateHoldTimeGravityScale(DeftJumpKinematics::DequantizeHoldTime(quantizedHoldTime, aTuning.JumpKeyMaxHoldTime), aTuning.JumpKeyMaxHoldTime, scales);
+		return releaseHeight + DeftJumpKinematics::SimulateApexHeight(releaseVelocityZ, jumpTuning.m_DefaultGravityZ * releaseScale, aTimeStep);
+	}
+}
+
+BEGIN_DEFINE_SPEC(FDeftMassJumpSpec, "Sashimi.Movement.MassJump", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	FDeftMassJumpTuningFragment m_Tuning;
+
+	void TestApex(const TCHAR* aWhat, int32 aReleaseStep, float aFrameRate)
+	{
+		const float timeStep = 1.f / aFrameRate;
+		const float apex = DeftMassJumpSpec::SimulateJump(m_Tuning, aReleaseStep, timeStep);
+		const float expected = DeftMassJumpSpec::CalculateExpectedApex(m_Tuning, aReleaseStep, timeStep);
+		TestNearlyEqual(FString::Printf(TEXT("%s apex at %.0f Hz"), aWhat, aFrameRate), apex, expected, DeftMassJumpSpec::HeightEpsilon);
+	}
+END_DEFINE_SPEC(FDeftMassJumpSpec)
+
+void FDeftMassJumpSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		m_Tuning = DeftMassJumpSpec::MakeTuning();
+	});
+
+	Describe("Apex height", [this]()
+	{
+		for (const float frameRate : DeftMassJumpSpec::FrameRates)
+		{
+			It(FString::Printf(TEXT("jump held to the apex matches the kernel at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				TestApex(TEXT("held jump"), INDEX_NONE, frameRate);
+			});
+
+			It(FString::Printf(TEXT("jump released after one step matches the kernel at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				TestApex(TEXT("tapped jump"), 1, frameRate);
+			});
+
+			It(FString::Printf(TEXT("jump released halfway through the hold time matches the kernel at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				TestApex(TEXT("half held jump"), FMath::RoundToInt(0.5f * m_Tuning.JumpKeyMaxHoldTime * frameRate), frameRate);
+			});
+		}
+	});
+
+	Describe("Hold time cutoff", [this]()
+	{
+		for (const float frameRate : DeftMassJumpSpec::FrameRates)
+		{
+			It(FString::Printf(TEXT("holding past JumpKeyMaxHoldTime jumps as high as never releasing at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				const float timeStep = 1.f / frameRate;
+				const float heldApex = DeftMassJumpSpec::SimulateJump(m_Tuning, INDEX_NONE, timeStep);
+				const int32 cutoffStep = FMath::CeilToInt(m_Tuning.JumpKeyMaxHoldTime * frameRate);
+				for (const int32 releaseStep : { cutoffStep, cutoffStep + 1, cutoffStep + 5 })
+				{
+					const float apex = DeftMassJumpSpec::SimulateJump(m_Tuning, releaseStep, timeStep);
+					TestNearlyEqual(FString::Printf(TEXT("released at step %d (%.3f s)"), releaseStep, releaseStep * timeStep), apex, heldApex, DeftMassJumpSpec::HeightEpsilon);
+				}
+			});
+
+			It(FString::Printf(TEXT("releasing before JumpKeyMaxHoldTime jumps lower at %.0f Hz"), frameRate), [this, frameRate]()
+			{
+				const float timeStep = 1.f / frameRate;
+				const float heldApex = DeftMassJumpSpec::SimulateJump(m_Tuning, INDEX_NONE, timeStep);
+				const float tappedApex = DeftMassJumpSpec::SimulateJump(m_Tuning, 1, timeStep);
+				TestTrue(FString::Printf(TEXT("tapped apex %.3f cm under held apex %.3f cm"), tappedApex, heldApex), tappedApex < heldApex - DeftMassJumpSpec::HeightEpsilon);
+			});
+		}
+	});
+}
+
+#endif//WITH_DEV_AUTOMATION_TESTS
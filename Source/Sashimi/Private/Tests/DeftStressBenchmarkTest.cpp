@@ -0,0 +1,100 @@
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "DeftStressBenchmark.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DeftStressBenchmarkTest
+{
+	static const TCHAR* MapName = TEXT("/Game/game/maps/playground");
+	static constexpr int32 CharacterCount = 50;
+	// after the 2 s warmup, long enough for every pawn to get through each move at least once (5 moves of 1.25 s)
+	static constexpr float DurationSeconds = 8.f;
+	static constexpr float TimeoutSeconds = 60.f;
+
+	struct TestState
+	{
+		TWeakObjectPtr<ADeftStressBenchmark> m_Benchmark;
+		double m_StartTime = 0.0;
+	};
+}
+
+/**
+ * d.Stress.Run as a test: runs the benchmark on a small crowd and checks it wrote its CSV and every pawn went through
+ * the whole move set. Needs a game world, run it headless with
+ *   -game -nullrhi -unattended -ExecCmds="Automation RunTests Sashimi.Movement.StressBenchmark; Quit"
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeftStressBenchmarkTest, "Sashimi.Movement.StressBenchmark", EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FDeftStressBenchmarkTest::RunTest(const FString& aParameters)
+{
+	using namespace DeftStressBenchmarkTest;
+
+	AutomationOpenMap(MapName);
+
+	TSharedRef<TestState> state = MakeShared<TestState>();
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, state]()
+	{
+		UWorld* world = AutomationCommon::GetAnyGameWorld();
+		ADeftStressBenchmark* benchmark = world ? world->SpawnActor<ADeftStressBenchmark>() : nullptr;
+		if (!benchmark)
+		{
+			AddError(TEXT("no game world to run the benchmark in"));
+			return true;
+		}
+
+		if (!benchmark->Start(CharacterCount, DurationSeconds, false))
+		{
+			AddError(TEXT("the benchmark didn't start, see LogDeftStress"));
+			benchmark->Destroy();
+			return true;
+		}
+
+		state->m_Benchmark = benchmark;
+		state->m_StartTime = FPlatformTime::Seconds();
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, state]()
+	{
+		const ADeftStressBenchmark* benchmark = state->m_Benchmark.Get();
+		if (!benchmark)
+			return true;
+
+		const ADeftStressBenchmark::Results* results = benchmark->GetResults();
+		if (!results)
+		{
+			if (FPlatformTime::Seconds() - state->m_StartTime < TimeoutSeconds)
+				return false;
+
+			AddError(FString::Printf(TEXT("the benchmark didn't finish within %.0f s"), TimeoutSeconds));
+			return true;
+		}
+
+		TestTrue(TEXT("frames were sampled"), results->m_Frames > 0);
+		TestFalse(TEXT("the CSV was written"), results->m_CsvPath.IsEmpty());
+		TestTrue(FString::Printf(TEXT("%s exists and isn't empty"), *results->m_CsvPath), IFileManager::Get().FileSize(*results->m_CsvPath) > 0);
+		TestEqual(TEXT("every character was spawned"), results->m_MovesCompleted.Num(), CharacterCount);
+		for (int32 index = 0; index < results->m_MovesCompleted.Num(); ++index)
+		{
+			const int32 movesCompleted = results->m_MovesCompleted[index];
+			if (movesCompleted < (int32)ADeftStressController::EStressMove::COUNT)
+				AddError(FString::Printf(TEXT("character %d only completed %d of %d moves"), index, movesCompleted, (int32)ADeftStressController::EStressMove::COUNT));
+		}
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([state]()
+	{
+		if (ADeftStressBenchmark* benchmark = state->m_Benchmark.Get())
+			benchmark->Destroy();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif
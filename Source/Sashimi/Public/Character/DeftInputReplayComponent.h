@@ -0,0 +1,132 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DeftInputReplayComponent.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogDeftReplay, Log, All);
+
+// APlayerCharacter input handlers that can be recorded
+enum class EDeftReplayInput : uint8
+{
+	JumpPressed,
+	JumpReleased,
+	Move,
+	Look,
+	AirDash
+};
+
+struct FDeftReplayInputEvent
+{
+	uint32 m_Frame = 0;
+	EDeftReplayInput m_Input = EDeftReplayInput::Move;
+	FVector2f m_Value = FVector2f::ZeroVector;
+
+	friend FArchive& operator<<(FArchive& aAr, FDeftReplayInputEvent& aEvent);
+};
+
+struct FDeftReplaySample
+{
+	FVector3f m_Location = FVector3f::ZeroVector;
+	FVector3f m_Velocity = FVector3f::ZeroVector;
+
+	friend FArchive& operator<<(FArchive& aAr, FDeftReplaySample& aSample);
+};
+
+/**
+ * A recorded session: where it started, the input events by fixed step frame and the resulting (golden) trajectory.
+ * Move input is only stored when it changes, playback keeps feeding the held value every frame like Enhanced Input does.
+ */
+struct FDeftInputReplay
+{
+	static constexpr uint32 Magic = 0x50455244;	// "DREP"
+	static constexpr uint32 Version = 1;
+
+	float m_FixedDeltaTime = 1.f / 60.f;
+	FVector m_StartLocation = FVector::ZeroVector;
+	FVector m_StartVelocity = FVector::ZeroVector;
+	FRotator m_StartRotation = FRotator::ZeroRotator;
+	FRotator m_StartControlRotation = FRotator::ZeroRotator;
+	uint8 m_StartMovementMode = 0;
+	TArray<FDeftReplayInputEvent> m_Events;
+	TArray<FDeftReplaySample> m_Trajectory;			// one sample per frame, taken before that frame's input is applied
+
+	static FString GetReplayPath(const FString& aName);
+	bool Save(const FString& aName) const;
+	bool Load(const FString& aName);
+
+	friend FArchive& operator<<(FArchive& aAr, FDeftInputReplay& aReplay);
+};
+
+/**
+ * Records APlayerCharacter's input and trajectory on a fixed timestep and plays it back, comparing against the recorded
+ * trajectory and reporting game thread time per frame. Driven by the d.Replay.* console commands.
+ */
+UCLASS()
+class SASHIMI_API UDeftInputReplayComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDeftInputReplayComponent();
+
+	virtual void TickComponent(float aDeltaTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction) override;
+	virtual void EndPlay(const EEndPlayReason::Type aEndPlayReason) override;
+
+	void StartRecording(const FString& aName, float aFixedDeltaTime);
+	void StartPlayback(const FString& aName, float aTolerance);
+	// Saves a recording or abandons a playback
+	void Stop();
+
+	bool IsRecording() const { return m_State == EReplayState::Recording; }
+	bool IsPlayingBack() const { return m_State == EReplayState::Playback; }
+
+	void RecordInput(EDeftReplayInput aInput, const FVector2D& aValue = FVector2D::ZeroVector);
+	// Scripted recordings: sends the input through APlayerCharacter's handlers on the next recorded frame, where playback will send it
+	void QueueInput(EDeftReplayInput aInput, const FVector2D& aValue = FVector2D::ZeroVector);
+
+	struct PlaybackResults
+	{
+		float m_MaxDeviation = 0.f;
+		uint32 m_MaxDeviationFrame = 0;
+		uint32 m_FramesOverTolerance = 0;
+		int32 m_Frames = 0;
+	};
+	// The last finished playback, null until one finishes
+	const PlaybackResults* GetPlaybackResults() const { return m_bPlaybackFinished ? &m_PlaybackResults : nullptr; }
+
+private:
+	enum class EReplayState : uint8
+	{
+		Idle,
+		Recording,
+		Playback
+	};
+
+	void Begin(EReplayState aState);
+	void End();
+	FDeftReplaySample MakeSample() const;
+	void DispatchInput(const FDeftReplayInputEvent& aEvent);
+	// Input has to reach the character before its controller applies look input (UpdateRotation) and before it moves
+	void AddTickPrerequisites();
+	void RemoveTickPrerequisites();
+	void FinishPlayback();
+
+	EReplayState m_State = EReplayState::Idle;
+	FString m_ReplayName;
+	FDeftInputReplay m_Replay;
+	uint32 m_Frame = 0;
+	int32 m_NextEvent = 0;
+	FVector2f m_HeldMoveValue = FVector2f::ZeroVector;
+	TArray<FDeftReplayInputEvent> m_QueuedInputs;
+	TWeakObjectPtr<AController> m_PrerequisiteController;
+
+	// Playback results
+	float m_Tolerance = 0.f;
+	PlaybackResults m_PlaybackResults;
+	bool m_bPlaybackFinished = false;
+	TArray<float> m_FrameTimesMs;
+
+	bool m_bPreviousUseFixedTimeStep = false;
+	double m_PreviousFixedDeltaTime = 0.0;
+};
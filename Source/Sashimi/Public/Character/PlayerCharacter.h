@@ -9,6 +9,8 @@
 
 #include "PlayerCharacter.generated.h"
 
+enum class EDeftMovementEvent : uint8;
+
 //DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnJumpPressed);
 //DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnJumpReleased);
 
@@ -17,6 +19,8 @@ class SASHIMI_API APlayerCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend class UDeftInputReplayComponent;
+
 public:
 	// Sets default values for this character's properties
 	APlayerCharacter(const FObjectInitializer& aObjectInitializer);
@@ -36,6 +40,8 @@ protected:
 	void OnJumpPressed();
 	void OnJumpReleased();
 	void AirDash();
+	// Feedback for the movement events of this character (UDeftMovementComponent::OnMovementEvent)
+	void OnMovementEvent(class UDeftMovementComponent* aMovement, EDeftMovementEvent aEvent);
 
 protected:
 
@@ -46,6 +52,10 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Camera)
 	class UCameraComponent* CameraComp;
 
+	// Records/plays back input for regression and performance runs (d.Replay.*)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Debug)
+	class UDeftInputReplayComponent* InputReplayComp;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input)
 	class UInputMappingContext* DefaultMappingContext;
 
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "DeftMovementComponent.h"
+#include "DeftAnimInstance.generated.h"
+
+// What the Deft move set is doing, as far as animation cares
+UENUM(BlueprintType)
+enum class EDeftAnimMoveMode : uint8
+{
+	Grounded,
+	Jumping,	// platform jump before the apex
+	Falling,
+	LedgeUp,
+	LedgeHang,
+	AirDash,
+};
+
+// Movement state for anim graphs, packed by UDeftMovementComponent::FillAnimState once per anim update
+USTRUCT(BlueprintType)
+struct SASHIMI_API FDeftAnimMovementState
+{
+	GENERATED_BODY()
+
+	FDeftAnimMovementState()
+		: bIsJumpButtonDown(false)
+		, bJumpApexReached(false)
+		, bHasAirDashed(false)
+	{
+	}
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	FVector Velocity = FVector::ZeroVector;
+
+	// Ledge being climbed or hung from, otherwise the last one detected
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	FVector LedgeEdge = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	float GroundSpeed = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	float VerticalSpeed = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	EDeftAnimMoveMode MoveMode = EDeftAnimMoveMode::Grounded;
+
+	// Jumps used since leaving the ground, 2 is a double jump
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	uint8 JumpCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	uint8 bIsJumpButtonDown : 1;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	uint8 bJumpApexReached : 1;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	uint8 bHasAirDashed : 1;
+
+	// EDeftMovementEvent bits raised since the previous anim update, see UDeftAnimInstance::WasMovementEventRaised
+	uint16 m_Events = 0;
+};
+
+/**
+ * Game thread side of UDeftAnimInstance. PreUpdate is the only place the movement component is read,
+ * everything after it (native and Blueprint thread safe update, the anim graph) runs off the copy.
+ */
+USTRUCT()
+struct SASHIMI_API FDeftAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FDeftAnimInstanceProxy() = default;
+	FDeftAnimInstanceProxy(UAnimInstance* aInstance) : FAnimInstanceProxy(aInstance) {}
+
+	const FDeftAnimMovementState& GetMovementState() const { return m_MovementState; }
+
+protected:
+	virtual void PreUpdate(UAnimInstance* aInstance, float aDeltaSeconds) override;
+
+private:
+	FDeftAnimMovementState m_MovementState;
+};
+
+/**
+ * Native base for Deft character anim blueprints. Bind MovementState with property access or read it from
+ * BlueprintThreadSafeUpdateAnimation so the graph updates on worker threads instead of pulling from the
+ * movement component on the game thread.
+ */
+UCLASS(Transient, Blueprintable)
+class SASHIMI_API UDeftAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+	friend struct FDeftAnimInstanceProxy;
+
+public:
+	// Copy of the proxy's state for this update, safe to read from any thread during the update
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Deft Movement")
+	FDeftAnimMovementState MovementState;
+
+	// Whether aEvent happened since the previous anim update
+	UFUNCTION(BlueprintPure, Category = "Deft Movement", meta=(BlueprintThreadSafe))
+	bool WasMovementEventRaised(EDeftMovementEvent aEvent) const;
+
+protected:
+	virtual void NativeInitializeAnimation() override;
+	virtual void NativeUninitializeAnimation() override;
+	virtual void NativeThreadSafeUpdateAnimation(float aDeltaSeconds) override;
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* aProxy) override;
+
+private:
+	void OnMovementEvent(UDeftMovementComponent* aMovement, EDeftMovementEvent aEvent);
+
+	TWeakObjectPtr<UDeftMovementComponent> m_Movement;
+	FDelegateHandle m_MovementEventHandle;
+	uint16 m_PendingEvents = 0;		// game thread, handed to the proxy and cleared in PreUpdate
+};
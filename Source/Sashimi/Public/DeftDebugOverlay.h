@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Sashimi/Sashimi.h"
+
+#if DEBUG_VIEW
+/**
+ * On screen debug text for the Deft systems (d.DebugOverlay).
+ * Lines are stored unformatted in a fixed size ring buffer and only turned into strings when the overlay is drawn,
+ * callers check IsEnabled() first so nothing at all runs while the overlay is hidden.
+ * Labels and text values are stored by pointer and must be string literals.
+ */
+class SASHIMI_API DeftDebugOverlay
+{
+	public:
+		static constexpr int32 Capacity = 128;
+
+		static bool IsEnabled() { return m_bEnabled; }
+
+		static void AddHeader(const TCHAR* aLabel, FColor aColor = FColor::Cyan);
+		static void AddText(const TCHAR* aLabel, const TCHAR* aText, FColor aColor = FColor::White);
+		static void AddBool(const TCHAR* aLabel, bool aValue, FColor aColor = FColor::White);
+		static void AddInt(const TCHAR* aLabel, int32 aValue, FColor aColor = FColor::White);
+		static void AddFloat(const TCHAR* aLabel, float aValue, FColor aColor = FColor::White);
+		static void AddVector(const TCHAR* aLabel, const FVector& aValue, FColor aColor = FColor::White);
+
+	private:
+		enum class EValueType : uint8
+		{
+			Header,
+			Text,
+			Bool,
+			Int,
+			Float,
+			Vector
+		};
+
+		struct Entry
+		{
+			const TCHAR* m_Label;
+			FColor m_Color;
+			EValueType m_Type;
+			union
+			{
+				const TCHAR* m_Text;
+				bool m_Bool;
+				int32 m_Int;
+				float m_Float;
+				float m_Vector[3];
+			};
+		};
+
+		static Entry& AddEntry(const TCHAR* aLabel, FColor aColor, EValueType aType);
+		static void OnEnabledChanged(IConsoleVariable* aVariable);
+		static void Draw(class UCanvas* aCanvas, class APlayerController* aPlayerController);
+
+		static Entry m_Entries[Capacity];
+		static uint32 m_Head;			// total number of entries added this frame, the buffer keeps the newest Capacity
+		static uint64 m_Frame;			// GFrameCounter of the entries in the buffer
+		static bool m_bEnabled;
+		static FDelegateHandle m_DrawHandle;
+		static FAutoConsoleVariableRef m_CVarEnabled;
+};
+#endif//DEBUG_VIEW
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Jump and air dash tuning in the form the kinematics kernel needs, copied out of UDeftMovementComponent
+ * so the math can run without a component, world or physics settings.
+ */
+struct FDeftJumpTuning
+{
+	float m_JumpMaxHeight = 0.f;
+	float m_TimeToJumpMaxHeight = 0.f;
+	float m_JumpMinHeight = 0.f;
+	float m_PostTimeToJumpMaxHeight = 0.f;
+	float m_JumpKeyMaxHoldTime = 0.f;
+	float m_AirDashDistance = 0.f;
+	float m_AirDashTime = 0.f;
+	float m_AirDashVerticalHeight = 0.f;
+	float m_DefaultGravityZ = 0.f;			// UPhysicsSettings::DefaultGravityZ, negative
+};
+
+struct FDeftJumpGravityScales
+{
+	float m_MaxPreJump = 0.f;		// gravity scale to reach max height
+	float m_MinPreJump = 0.f;		// gravity scale to reach min height
+	float m_PostJump = 0.f;			// constant "falling" gravity scale once the apex of a jump has been reached
+};
+
+struct FDeftJumpLaunch
+{
+	float m_VelocityZ = 0.f;
+	float m_GravityScale = 0.f;
+};
+
+struct FDeftAirDashLaunch
+{
+	FVector m_Velocity = FVector::ZeroVector;
+	float m_GravityScale = 0.f;
+	float m_DashSpeed = 0.f;
+};
+
+/**
+ * Pure, allocation free jump/dash kinematics. Everything here is a function of its arguments only.
+ */
+namespace DeftJumpKinematics
+{
+	// double jumps are slightly less powerful
+	constexpr float DoubleJumpScale = 0.75f;
+
+	// Initial velocity needed to achieve the desired height in the desired time
+	FORCEINLINE float CalculateInitialVelocityZ(float aTime, float aHeight)
+	{
+		return (2 * aHeight) / aTime;
+	}
+
+	// Gravity scale needed to achieve the desired height in the desired time
+	FORCEINLINE float CalculateGravityScale(float aTime, float aHeight, float aDefaultGravityZ)
+	{
+		return ((-2 * aHeight) / (aTime * aTime)) / aDefaultGravityZ;
+	}
+
+	FORCEINLINE FDeftJumpGravityScales CalculateGravityScales(const FDeftJumpTuning& aTuning)
+	{
+		FDeftJumpGravityScales scales;
+		scales.m_MaxPreJump = CalculateGravityScale(aTuning.m_TimeToJumpMaxHeight, aTuning.m_JumpMaxHeight, aTuning.m_DefaultGravityZ);
+		// We need to scale time by the same factor as height since
+		// if it takes 1s to reach 4m, then it would take 0.5s to reach 2m
+		// so if the max height is 4m in 1s, and the min height is 2m we shouldn't use gravity that takes us to 2m over 1s, it should take us 0.5s instead
+		const float timeScale = aTuning.m_JumpMaxHeight / aTuning.m_JumpMinHeight;
+		scales.m_MinPreJump = CalculateGravityScale(aTuning.m_TimeToJumpMaxHeight / timeScale, aTuning.m_JumpMinHeight, aTuning.m_DefaultGravityZ);
+		scales.m_PostJump = CalculateGravityScale(aTuning.m_PostTimeToJumpMaxHeight, aTuning.m_JumpMaxHeight, aTuning.m_DefaultGravityZ);
+		return scales;
+	}
+
+	// Velocity and gravity for the aJumpCount'th jump since leaving the ground (1 == first jump)
+	FORCEINLINE FDeftJumpLaunch CalculateJumpLaunch(const FDeftJumpTuning& aTuning, uint8 aJumpCount)
+	{
+		float jumpTime = aTuning.m_TimeToJumpMaxHeight;
+		float jumpHeight = aTuning.m_JumpMaxHeight;
+		if (aJumpCount > 1)
+		{
+			jumpTime *= DoubleJumpScale;
+			jumpHeight *= DoubleJumpScale;
+		}
+
+		FDeftJumpLaunch launch;
+		launch.m_VelocityZ = CalculateInitialVelocityZ(jumpTime, jumpHeight);
+		launch.m_GravityScale = CalculateGravityScale(jumpTime, jumpHeight, aTuning.m_DefaultGravityZ);
+		return launch;
+	}
+
+	// Gravity scale after releasing jump having held it for aHoldTime
+	FORCEINLINE float CalculateHoldTimeGravityScale(float aHoldTime, float aMaxHoldTime, const FDeftJumpGravityScales& aScales)
+	{
+		// ex: max time is 2s, we hold for 1s, we get 1/2s = 0.5 == 50% of the max jump
+		// val == 1 that means we held it max time and shouldn't change gravity at all.
+		// val == 0 means we want the min height (more gravity applied)
+		const float val = FMath::Clamp(aHoldTime / aMaxHoldTime, 0.f, 1.f);
+		return (val * (aScales.m_MaxPreJump - aScales.m_MinPreJump)) + aScales.m_MinPreJump;
+	}
+
+	// Hold time is replicated as a byte over [0, aMaxHoldTime], both client and server release with the quantized value so their gravity matches
+	FORCEINLINE uint8 QuantizeHoldTime(float aHoldTime, float aMaxHoldTime)
+	{
+		return aMaxHoldTime > 0.f ? (uint8)FMath::RoundToInt(FMath::Clamp(aHoldTime / aMaxHoldTime, 0.f, 1.f) * MAX_uint8) : 0;
+	}
+
+	FORCEINLINE float DequantizeHoldTime(uint8 aQuantizedHoldTime, float aMaxHoldTime)
+	{
+		return aQuantizedHoldTime * aMaxHoldTime / MAX_uint8;
+	}
+
+	FORCEINLINE FDeftAirDashLaunch CalculateAirDashLaunch(const FDeftJumpTuning& aTuning, const FVector& aForward)
+	{
+		FDeftAirDashLaunch dash;
+		dash.m_DashSpeed = aTuning.m_AirDashDistance / aTuning.m_AirDashTime;
+		dash.m_GravityScale = CalculateGravityScale(aTuning.m_AirDashTime, aTuning.m_AirDashVerticalHeight, aTuning.m_DefaultGravityZ);
+		dash.m_Velocity = FVector(aForward.X * dash.m_DashSpeed, aForward.Y * dash.m_DashSpeed, CalculateInitialVelocityZ(aTuning.m_AirDashTime, aTuning.m_AirDashVerticalHeight));
+		return dash;
+	}
+
+	// Closed form of the dash above: constant speed along aForward while rising to AirDashVerticalHeight at AirDashTime.
+	// z = H * a * (2 - a) with a = t / AirDashTime is where the launch velocity and gravity scale would have taken it
+	FORCEINLINE FVector CalculateAirDashOffset(const FDeftJumpTuning& aTuning, const FVector& aForward, float aTime)
+	{
+		if (aTuning.m_AirDashTime <= 0.f)
+			return FVector::ZeroVector;
+
+		const float time = FMath::Clamp(aTime, 0.f, aTuning.m_AirDashTime);
+		const float alpha = time / aTuning.m_AirDashTime;
+		const float horizontal = aTuning.m_AirDashDistance * alpha;
+		return FVector(aForward.X * horizontal, aForward.Y * horizontal, aTuning.m_AirDashVerticalHeight * alpha * (2.f - alpha));
+	}
+
+	FORCEINLINE FVector CalculateAirDashVelocity(const FDeftJumpTuning& aTuning, const FVector& aForward, float aTime)
+	{
+		if (aTuning.m_AirDashTime <= 0.f)
+			return FVector::ZeroVector;
+
+		const float alpha = FMath::Clamp(aTime / aTuning.m_AirDashTime, 0.f, 1.f);
+		const float dashSpeed = aTuning.m_AirDashDistance / aTuning.m_AirDashTime;
+		return FVector(aForward.X * dashSpeed, aForward.Y * dashSpeed, CalculateInitialVelocityZ(aTuning.m_AirDashTime, aTuning.m_AirDashVerticalHeight) * (1.f - alpha));
+	}
+
+	// Horizontal velocity left over from a dash bleeding off at aDeceleration until it's back down to aMaxSpeed, Z is untouched
+	FORCEINLINE FVector CalculateDashExitVelocity(const FVector& aVelocity, float aMaxSpeed, float aDeceleration, float aDeltaTime)
+	{
+		const float horizontalSpeed = FVector(aVelocity.X, aVelocity.Y, 0.f).Size();
+		if (horizontalSpeed <= aMaxSpeed)
+			return aVelocity;
+
+		const float scale = FMath::Max(horizontalSpeed - aDeceleration * aDeltaTime, aMaxSpeed) / horizontalSpeed;
+		return FVector(aVelocity.X * scale, aVelocity.Y * scale, aVelocity.Z);
+	}
+
+	// Height reached when integrating the launch at a fixed step the way PhysFalling does (average of old and new velocity)
+	SASHIMI_API float SimulateApexHeight(float aVelocityZ, float aGravityZ, float aTimeStep);
+};
+
+/**
+ * The same formulas over arrays of characters (structure of arrays), four at a time in VectorRegister4Float
+ * with the remainder falling back to the scalar functions above. Outputs may alias inputs.
+ */
+namespace DeftJumpKinematicsBatch
+{
+	SASHIMI_API void CalculateInitialVelocityZ(const float* aTime, const float* aHeight, float* outVelocityZ, int32 aNum);
+	SASHIMI_API void CalculateGravityScale(const float* aTime, const float* aHeight, float aDefaultGravityZ, float* outGravityScale, int32 aNum);
+	SASHIMI_API void CalculateHoldTimeGravityScale(const float* aHoldTime, const float* aMaxHoldTime, const float* aMaxPreJumpScale, const float* aMinPreJumpScale, float* outGravityScale, int32 aNum);
+	// Ledge up boost: adds aForward * aBoost * aDeltaTime to the horizontal velocity, a zero boost leaves an entry alone
+	SASHIMI_API void ApplyForwardBoost(float* ioVelocityX, float* ioVelocityY, const float* aForwardX, const float* aForwardY, const float* aBoost, const float* aDeltaTime, int32 aNum);
+};
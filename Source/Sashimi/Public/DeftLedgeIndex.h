@@ -0,0 +1,127 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DeftLedgeProbe.h"
+#include "Sashimi/Sashimi.h"
+#include "DeftLedgeIndex.generated.h"
+
+class UBoxComponent;
+
+enum EDeftLedgeSegmentFlags : uint32
+{
+	LSF_None			= 0,
+	LSF_CapsuleFits		= 1 << 0,	// CheckSpaceForCapsule passed against static geometry when baked
+};
+
+/**
+ * Baked ledge edge. Plain fixed size data with no pointers so a cell's segments can be bulk serialized
+ * and read straight out of a mapped file.
+ */
+struct FDeftLedgeSegment
+{
+	FVector3f m_Start = FVector3f::ZeroVector;
+	FVector3f m_End = FVector3f::ZeroVector;
+	FVector3f m_SurfaceNormal = FVector3f::UpVector;
+	FVector3f m_WallNormal = FVector3f::ZeroVector;	// points away from the wall face, towards where the character approaches from
+	uint32 m_Flags = LSF_None;
+
+	friend FArchive& operator<<(FArchive& Ar, FDeftLedgeSegment& aSegment)
+	{
+		Ar << aSegment.m_Start << aSegment.m_End << aSegment.m_SurfaceNormal << aSegment.m_WallNormal << aSegment.m_Flags;
+		return Ar;
+	}
+};
+static_assert(TIsTriviallyCopyable<FDeftLedgeSegment>::Value, "FDeftLedgeSegment must stay POD so it can be bulk serialized");
+
+template<> struct TCanBulkSerialize<FDeftLedgeSegment> { enum { Value = true }; };
+
+// Layout of the index ADeftLedgeIndexActor serializes after its properties, bump it whenever FDeftLedgeSegment or the grid changes
+struct FDeftLedgeIndexVersion
+{
+	enum Type
+	{
+		// appended straight after the actor's properties without a version
+		BeforeCustomVersionWasAdded = 0,
+		// same layout, written as one size prefixed blob so a layout this build stops reading can be skipped
+		VersionedBlob,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	// Blobs older than this are skipped on load, the actor's ledges are traced again until it's re-baked
+	static constexpr int32 OldestReadableVersion = BeforeCustomVersionWasAdded;
+
+	static const FGuid GUID;
+};
+
+struct FDeftLedgeIndexHit
+{
+	FVector m_LedgeEdge = FVector::ZeroVector;
+	FVector m_SurfaceLocation = FVector::ZeroVector;	// where the surface ray would have hit, used for the clearance check
+	FVector m_SurfaceNormal = FVector::UpVector;
+	FVector m_WallNormal = FVector::ZeroVector;
+	FVector m_SegmentStart = FVector::ZeroVector;		// the baked segment the edge lies on
+	FVector m_SegmentEnd = FVector::ZeroVector;
+	float m_Distance = 0.f;								// along the wall ray
+	bool m_bCapsuleFits = false;
+};
+
+/**
+ * Ledge index for the static geometry inside its bounds. Runs the same wall/space/surface/clearance checks
+ * as UDeftMovementComponent ahead of time and stores the resulting edges in a small 2D grid.
+ * Spatially loaded so under World Partition it streams in and out with the cell it's placed in.
+ */
+UCLASS()
+class SASHIMI_API ADeftLedgeIndexActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ADeftLedgeIndexActor();
+
+	virtual void Serialize(FArchive& Ar) override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type aEndPlayReason) override;
+
+	bool Covers(const FVector& aLocation) const;
+	// Finds the closest baked edge the probe's wall ray would reach
+	bool FindLedge(const FDeftLedgeProbe& aProbe, FDeftLedgeIndexHit& outHit) const;
+	int32 GetNumSegments() const { return m_Segments.Num(); }
+
+#if WITH_EDITOR
+	// Re-runs the ledge checks against the static geometry currently loaded inside the bounds
+	UFUNCTION(CallInEditor, Category = "Ledge Index")
+	void BuildLedgeIndex();
+#endif
+
+#if DEBUG_VIEW
+	void DrawIndex() const;
+#endif
+
+protected:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Ledge Index")
+	TObjectPtr<UBoxComponent> IndexBounds;
+
+	UPROPERTY(EditAnywhere, Category = "Ledge Index | Bake", meta=(ToolTip="Character whose movement component ledge tuning and capsule the bake mirrors"))
+	TSubclassOf<class ACharacter> CharacterClass;
+	UPROPERTY(EditAnywhere, Category = "Ledge Index | Bake", meta=(ClampMin="5.0", ToolTip="Distance (cm) between surface samples, smaller finds narrower ledges but bakes slower"))
+	float SampleSpacing = 20.f;
+	UPROPERTY(EditAnywhere, Category = "Ledge Index | Bake", meta=(ClampMin="50.0", ToolTip="Size (cm) of the lookup grid cells, segments are split so they never span more than one"))
+	float GridCellSize = 200.f;
+	UPROPERTY(EditAnywhere, Category = "Ledge Index | Bake", meta=(ToolTip="Max height difference (cm) between neighbouring edge samples to still be merged into one segment"))
+	float MergeHeightTolerance = 5.f;
+
+private:
+	int32 GetCellIndex(int32 aX, int32 aY) const { return aY * m_GridDims.X + aX; }
+	// Segments and grid in the layout of aVersion (FDeftLedgeIndexVersion)
+	void SerializeIndex(FArchive& Ar, int32 aVersion);
+	void ResetIndex();
+
+	TArray<FDeftLedgeSegment> m_Segments;	// sorted by grid cell
+	TArray<uint32> m_CellStarts;			// m_Segments[m_CellStarts[i], m_CellStarts[i + 1]) live in cell i
+	FVector2f m_GridOrigin = FVector2f::ZeroVector;
+	FIntPoint m_GridDims = FIntPoint::ZeroValue;
+	float m_GridCellSize = 0.f;
+};
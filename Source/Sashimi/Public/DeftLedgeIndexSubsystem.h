@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DeftLedgeIndex.h"
+#include "DeftLedgeIndexSubsystem.generated.h"
+
+/**
+ * Keeps track of the ledge indices currently loaded in the world so ledge detection can look up baked
+ * static edges instead of tracing for them.
+ */
+UCLASS()
+class SASHIMI_API UDeftLedgeIndexSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterIndex(ADeftLedgeIndexActor* aIndex);
+	void UnregisterIndex(ADeftLedgeIndexActor* aIndex);
+
+	// True when a loaded index covers aLocation, static geometry there doesn't need to be traced
+	bool IsCovered(const FVector& aLocation) const;
+	bool FindLedge(const FDeftLedgeProbe& aProbe, FDeftLedgeIndexHit& outHit) const;
+
+	const TArray<TObjectPtr<ADeftLedgeIndexActor>>& GetIndices() const { return m_Indices; }
+
+private:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ADeftLedgeIndexActor>> m_Indices;
+};
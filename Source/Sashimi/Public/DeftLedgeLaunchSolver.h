@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FDeftLedgeLaunchSolution
+{
+	float m_Angle = 0.f;				// launch angle above the horizon (degrees)
+	float m_Speed = 0.f;				// initial speed along the launch angle
+	float m_HorizontalSpeed = 0.f;
+	float m_VerticalSpeed = 0.f;
+	float m_FlightTime = FLT_MAX;
+	bool m_bValid = false;
+};
+
+/**
+ * Solves the ledge up launch: which angle and speed lands the capsule base on the hop up location in the
+ * shortest flight time while the apex still clears the ledge height.
+ * All distances are relative to the launch point, gravity is positive.
+ * Only UDeftMovementComponent::PerformLedgeUp uses it, which is currently not called (see StartLedgeUp for the live ledge up).
+ */
+namespace DeftLedgeLaunch
+{
+	// angle range the launch is allowed to use
+	constexpr float MinAngle = 10.f;
+	constexpr float MaxAngle = 80.f;
+	// flight times within this many seconds of the shortest are considered equal, the steeper angle wins
+	constexpr float FlightTimeTolerance = 0.01f;
+	// grid the original numerical search used
+	constexpr float SweepAngleStep = 5.f;
+
+	// Constant time: solves the launch quadratic for the optimal angle directly
+	SASHIMI_API FDeftLedgeLaunchSolution SolveMinFlightTime(float aHorizontalDistance, float aVerticalDistance, float aGravity);
+
+	// Reference numerical search over SweepAngleStep increments, kept to benchmark and validate against
+	SASHIMI_API FDeftLedgeLaunchSolution SolveAngleSweep(float aHorizontalDistance, float aVerticalDistance, float aGravity);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Ray and sweep layout of the ledge checks (wall, ledge space, ledge surface, capsule clearance).
+ * Shared by the runtime sync/async ledge detection and the ledge index bake so they can't drift apart.
+ */
+struct SASHIMI_API FDeftLedgeProbe
+{
+	FVector m_Origin = FVector::ZeroVector;		// capsule center of the (real or virtual) character
+	FVector m_Forward = FVector::ForwardVector;
+	FVector m_Up = FVector::UpVector;
+	float m_WallReach = 0.f;
+	float m_LedgeHeightOrigin = 0.f;
+	float m_LedgeHeightForwardReach = 0.f;
+	float m_CapsuleHalfHeight = 0.f;
+
+	// inside actor capsule at half height extending in forward direction outwards
+	void GetWallRay(FVector& outStart, FVector& outEnd) const;
+	// raised up by LedgeHeightOrigin extending forward, a hit means there's no open space above the wall
+	void GetSpaceRay(FVector& outStart, FVector& outEnd) const;
+	// from the end of the space ray straight down twice as far as it was raised
+	void GetSurfaceRay(FVector& outStart, FVector& outEnd) const;
+	// tiny upward sweep with the capsule base just above the floor location (center positions)
+	void GetClearanceSweep(const FVector& aFloorLocation, FVector& outStart, FVector& outEnd) const;
+
+	// Projects the wall hit onto the ledge surface to find where the edge is
+	static FVector GetLedgeEdge(const FVector& aViewerLocation, const FVector& aFloorLocation, const FVector& aFloorNormal, const FVector& aWallLocation);
+};
@@ -1,28 +1,98 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include <atomic>
 
+enum class EDeftLock : uint8
+{
+	None					= 0,
+	MoveInputForwardBack	= 1 << 0,
+	MoveInputRightLeft		= 1 << 1,
+	AllMoveInput			= MoveInputForwardBack | MoveInputRightLeft,
+};
+ENUM_CLASS_FLAGS(EDeftLock)
+
+class DeftLocks;
+
+// Scoped hold on one or more locks. Released when it goes out of scope, is overwritten or Release is called
+class SASHIMI_API DeftLockHandle
+{
+	public:
+		DeftLockHandle() {}
+		~DeftLockHandle() { Release(); }
+
+		DeftLockHandle(DeftLockHandle&& aOther);
+		DeftLockHandle& operator=(DeftLockHandle&& aOther);
+		DeftLockHandle(const DeftLockHandle&) = delete;
+		DeftLockHandle& operator=(const DeftLockHandle&) = delete;
+
+		// Releases every lock still held by this handle
+		void Release() { Release(m_Locks); }
+		// Releases only some of the locks, the rest stay held
+		void Release(EDeftLock aLocks);
+
+		bool IsHeld() const { return m_Locks != EDeftLock::None; }
+		bool IsHeld(EDeftLock aLocks) const { return EnumHasAnyFlags(m_Locks, aLocks); }
+
+	private:
+		friend class DeftLocks;
+		DeftLockHandle(DeftLocks* aOwner, EDeftLock aLocks, uint32 aGeneration) : m_Owner(aOwner), m_Locks(aLocks), m_Generation(aGeneration) {}
+
+		DeftLocks* m_Owner = nullptr;
+		EDeftLock m_Locks = EDeftLock::None;
+		uint32 m_Generation = 0;
+};
+
+/**
+ * Movement input locks owned by a single character. Every lock is a reference count packed into one atomic
+ * word so it can be queried and changed from any thread, callers hold them through DeftLockHandle.
+ */
 class SASHIMI_API DeftLocks
 {
 	public:
+		static constexpr int32 NumLocks = 2;
+
+		struct Stats
+		{
+			uint32 m_Acquires = 0;
+			uint32 m_Releases = 0;
+			uint32 m_StaleReleases = 0;		// handles released after UnlockAll already cleared them
+			uint32 m_LeaksDetected = 0;
+		};
+
 		DeftLocks() {}
-		virtual ~DeftLocks(){}
+		~DeftLocks();
+		DeftLocks(const DeftLocks&) = delete;
+		DeftLocks& operator=(const DeftLocks&) = delete;
+
+		[[nodiscard]] DeftLockHandle Acquire(EDeftLock aLocks, const TCHAR* aDebugName);
 
-		static bool IsMoveInputForwardBackLocked();
-		static void IncrementMoveInputForwardBackLockRef();
-		static void DecrementMoveInputForwardBackLockRef();
+		bool IsLocked(EDeftLock aLocks) const;
+		bool IsMoveInputForwardBackLocked() const { return IsLocked(EDeftLock::MoveInputForwardBack); }
+		bool IsMoveInputRightLeftLocked() const { return IsLocked(EDeftLock::MoveInputRightLeft); }
+		uint8 GetLockCount(EDeftLock aLock) const;
 
-		static bool IsMoveInputRightLeftLocked();
-		static void IncrementMoveInputRightLeftockRef();
-		static void DecrementMoveInputRightLeftLockRef();
+		// Call at points where nothing should be locked anymore (ex: landing), reports and clears anything left over
+		bool CheckForLeaks(const TCHAR* aContext);
+		// Clears every lock, handles acquired before this become no-ops
+		void UnlockAll();
+
+		Stats GetStats() const;
 
 	private:
-		static int8 m_MoveInputForwardBackLock;
-		static int8 m_MoveInputRightLeftLock;
-
-#if !UE_BUILD_SHIPPING
-public:
-	static void DrawLockDebug();
-	static void UnlockAll();
-#endif
-};
\ No newline at end of file
+		friend class DeftLockHandle;
+		void Release(EDeftLock aLocks, uint32 aGeneration);
+
+		static constexpr uint64 CountBits = 8;
+		static constexpr uint64 CountMask = (1ull << CountBits) - 1;
+		static constexpr uint64 GenerationShift = 32;
+
+		// low 32 bits: an 8 bit count per lock, high 32 bits: generation bumped by UnlockAll
+		std::atomic<uint64> m_State{ 0 };
+
+		std::atomic<uint32> m_Acquires{ 0 };
+		std::atomic<uint32> m_Releases{ 0 };
+		std::atomic<uint32> m_StaleReleases{ 0 };
+		std::atomic<uint32> m_LeaksDetected{ 0 };
+		std::atomic<const TCHAR*> m_LastAcquiredBy[NumLocks] = {};
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponentAsync.h"
+#include "DeftMovementComponent.h"
+#include "DeftJumpKinematics.h"
+#include "DeftLedgeProbe.h"
+
+/**
+ * Async character movement (p.AsyncCharacterMovement) runs the move on the physics thread from a snapshot of the
+ * component, so UDeftMovementComponent's DoJump/PhysFalling/OnMovementUpdated overrides never run there.
+ * The Deft move set is carried through these instead: the game thread fills FDeftCharacterAsyncInput, the physics
+ * thread steps FDeftAsyncMoveState from its CheckJumpInput hook (which runs at the start of every sim step) and
+ * publishes the result, and UDeftMovementComponent::ApplyAsyncOutput copies it back and applies what has to stay
+ * on the game thread (gravity scale, input locks, force feedback).
+ * The sim has no custom movement modes, so CustomMovement::LedgeHang is sync only: here a ledge is only taken with
+ * jump held (ledge up), without it the character falls past like it does with d.Ledge.Hang off.
+ */
+
+// Edges the physics thread raised since the game thread last consumed the state
+enum EDeftAsyncMoveEvent : uint8
+{
+	DAME_None			= 0,
+	DAME_Jumped			= 1 << 0,
+	DAME_ApexReached	= 1 << 1,
+	DAME_LedgeUp		= 1 << 2,
+	DAME_AirDash		= 1 << 3,
+	DAME_Landed			= 1 << 4,
+};
+
+// Jump-hold, apex, dash and ledge state of the move in progress, the async counterpart of the component's members
+struct FDeftAsyncMoveState
+{
+	float m_GravityScale = 1.f;
+	float m_JumpKeyHoldTime = 0.f;
+	uint8 m_JumpInputCounter = 0;
+	bool m_bWasJumpButtonDown = false;
+	bool m_bIncrementJumpInputHoldTime = false;
+	bool m_bInPlatformJump = false;
+	bool m_bJumpApexReached = false;
+	bool m_bHasAirDashed = false;
+	bool m_bAirDashing = false;
+	bool m_bIsLedgingUp = false;
+	bool m_bWasFalling = false;
+	EInternalMoveMode m_InternalMoveMode = IMOVE_None;
+	float m_AirDashElapsed = 0.f;
+	FVector m_AirDashStart = FVector::ZeroVector;
+	FVector m_AirDashDirection = FVector::ZeroVector;
+	FVector m_LedgeEdge = FVector::ZeroVector;
+	FVector m_HopUpLocation = FVector::ZeroVector;
+	uint8 m_Events = DAME_None;
+};
+
+// Owned by the component, referenced by every async input it fills
+struct FDeftAsyncSimState
+{
+	FDeftAsyncMoveState m_Sim;				// physics thread only
+	FCollisionQueryParams m_QueryParams;	// set once on the game thread before the first input is filled
+
+	// Copies m_Sim out for the game thread, events accumulate until consumed
+	void Publish();
+	FDeftAsyncMoveState Consume();
+
+private:
+	FCriticalSection m_PublishLock;
+	FDeftAsyncMoveState m_Published;
+};
+
+struct FDeftCharacterAsyncInput : public FCharacterAsyncInput
+{
+	FDeftJumpTuning m_JumpTuning;
+	FDeftJumpGravityScales m_GravityScales;
+	FDeftLedgeProbe m_LedgeProbe;			// tuning only, placed at the character on the physics thread
+	FName m_CollisionProfile;
+	float m_CapsuleRadius = 0.f;
+	float m_DefaultGravityScale = 1.f;
+	float m_GravityZ = 0.f;					// what the sim integrates this input's steps with, GravityScale already applied
+	float m_MaxSpeed = 0.f;
+	float m_AirDashExitDeceleration = 0.f;
+	float m_LedgeUpAdditionalHeightOffset = 0.f;
+	float m_TimeToReachLedgeUpHeight = 0.f;
+	float m_LedgeUpForwardMinBoost = 0.f;
+	uint8 m_JumpInputMax = 2;
+	bool m_bClearanceOverlap = true;		// d.Ledge.ClearanceOverlap
+	bool m_bJumpButtonDown = false;
+	bool m_bWantsToAirDash = false;
+	TSharedPtr<FDeftAsyncSimState, ESPMode::ThreadSafe> m_SimState;
+
+	virtual void CheckJumpInput(float DeltaSeconds, const FCharacterMovementComponentAsyncInput& Input, FCharacterMovementComponentAsyncOutput& Output) const override;
+
+private:
+	// Hold time, apex, landing, the end of a dash and ledge up, using where the previous step left the character
+	void UpdateAfterMovement(float aDeltaSeconds, const FCharacterMovementComponentAsyncInput& aInput, FCharacterMovementComponentAsyncOutput& aOutput, FDeftAsyncMoveState& outState) const;
+	// Press/release edges and the dash request for this step
+	void ApplyMoveInput(const FCharacterMovementComponentAsyncInput& aInput, FCharacterMovementComponentAsyncOutput& aOutput, FDeftAsyncMoveState& outState) const;
+	// Sets this step's velocity so the falling move lands on the dash curve, UDeftMovementComponent::PhysAirDash
+	void StepAirDash(float aDeltaSeconds, const FCharacterMovementComponentAsyncInput& aInput, FCharacterMovementComponentAsyncOutput& aOutput, FDeftAsyncMoveState& outState) const;
+	void EndAirDash(FDeftAsyncMoveState& outState) const;
+	void ReachApex(FDeftAsyncMoveState& outState) const;
+	void ResetJump(FDeftAsyncMoveState& outState) const;
+	// Same checks as UDeftMovementComponent::FindLedgeSync, issued from the physics thread
+	bool FindLedge(const UWorld& aWorld, const FDeftLedgeProbe& aProbe, const FQuat& aRotation, const FDeftAsyncSimState& aSimState, FVector& outLedgeEdge, FVector& outHopUpLocation) const;
+};
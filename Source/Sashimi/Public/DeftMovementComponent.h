@@ -4,6 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "WorldCollision.h"
+#include "DeftLocks.h"
+#include "DeftLedgeProbe.h"
+#include "DeftMovementNetworking.h"
+#include "DeftSignificanceManager.h"
 #include "Sashimi/Sashimi.h"
 #include "DeftMovementComponent.generated.h"
 
@@ -32,6 +37,25 @@ enum EInternalMoveMode
 	IMOVE_None
 };
 
+// Transitions of the Deft move set, each raised once when it happens (see UDeftMovementComponent::OnMovementEvent)
+UENUM(BlueprintType)
+enum class EDeftMovementEvent : uint8
+{
+	JumpStarted,
+	ApexReached,
+	Landed,
+	LedgeFound,			// a ledge came into reach, raised again only after losing it
+	LedgeUpStarted,
+	LedgeUpEnded,
+	LedgeGrabbed,		// entered CustomMovement::LedgeHang
+	LedgeReleased,
+	AirDashStarted,
+	AirDashEnded,
+	COUNT				UMETA(Hidden)
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDeftMovementEvent, class UDeftMovementComponent*, EDeftMovementEvent);
+
 /**
  * 
  */
@@ -40,10 +64,14 @@ class SASHIMI_API UDeftMovementComponent : public UCharacterMovementComponent
 {
 	GENERATED_BODY()
 	
+	friend class FSavedMove_Deft;
+	friend struct FDeftMovementTrace;
+	friend class UDeftMovementSubsystem;
 	
 public:
 	UDeftMovementComponent();
 	virtual void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type aEndPlayReason) override;
 	virtual void TickComponent(float aDeltaTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction) override;
 
 	// Apply instantaneous velocity in Z direction then set to Falling
@@ -54,31 +82,175 @@ public:
 	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity);
 	// We manually track jump input
 	virtual bool CanAttemptJump() const override;
+	// Applies the jump and dash inputs inside the move so the server and replays see them where the client did
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	// Networking
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void OnClientCorrectionReceived(class FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection) override;
+	virtual void ServerMovePacked_ServerReceive(const FCharacterServerMovePackedBits& PackedBits) override;
+	virtual void ClientMoveResponsePacked_ClientReceive(const FCharacterMoveResponsePackedBits& PackedBits) override;
+
+	// Async movement (p.AsyncCharacterMovement), see DeftMovementAsync.h
+	virtual void FillAsyncInput(const FVector& InputVector, FCharacterMovementComponentAsyncInput& AsyncInput) override;
+	virtual void ApplyAsyncOutput(FCharacterMovementComponentAsyncOutput& Output) override;
+
+	struct NetworkStats
+	{
+		uint32 m_Corrections = 0;			// client: corrections received from the server
+		uint32 m_ServerMoves = 0;			// server: packed moves received from the client
+		uint64 m_ServerMoveBits = 0;
+		uint64 m_MoveResponseBits = 0;		// client: packed move responses received from the server
+		double m_StartTime = 0.0;
+	};
+	const NetworkStats& GetNetworkStats() const { return m_NetworkStats; }
 
 	// Jump Input has been pressed
 	void OnJumpPressed();
 	// Jump Input has been released
 	void OnJumpReleased();
 
+	// Requests an air dash, performed on the next move
 	void OnAirDash();
 
+	// Hanging from a ledge (CustomMovement::LedgeHang), jump climbs up and pulling away from the wall drops
+	bool IsLedgeHanging() const { return MovementMode == MOVE_Custom && CustomMovementMode == CustomMovement::LedgeHang; }
+	// In the dash itself (CustomMovement::AirDash), the deceleration after it happens while falling
+	bool IsAirDashing() const { return MovementMode == MOVE_Custom && CustomMovementMode == CustomMovement::AirDash; }
+
+	// Copies the ledge reach/height tuning into a probe (used by the ledge index bake on the CDO)
+	void FillLedgeProbeTuning(struct FDeftLedgeProbe& outProbe) const;
+	// Jump/dash tuning for the kinematics kernel, gravity is only valid after BeginPlay
+	struct FDeftJumpTuning GetJumpTuning() const;
+	// Copies the jump/dash tuning for Mass agents (UDeftMassJumpTrait), works on the CDO since gravity comes straight from the physics settings
+	void FillMassJumpTuning(struct FDeftMassJumpTuningFragment& outTuning) const;
+
+	// Applies a significance bucket, the tick interval blends towards the bucket's over d.LOD.BlendTime
+	void SetMovementLOD(EDeftMovementLOD aLOD);
+	EDeftMovementLOD GetMovementLOD() const { return m_MovementLOD; }
+
+	// Packs everything animation reads, called once per anim update from the game thread (FDeftAnimInstanceProxy::PreUpdate)
+	void FillAnimState(struct FDeftAnimMovementState& outState) const;
+
+	// Animation, audio, VFX and feedback subscribe here instead of polling the movement state.
+	// Replayed moves don't raise anything, events fire once for the move as it was first simulated
+	FOnDeftMovementEvent& OnMovementEvent() { return m_OnMovementEvent; }
+	// Played by the owner on EDeftMovementEvent::LedgeUpStarted
+	class UForceFeedbackEffect* GetLedgeUpFeedback() const { return LedgeUpFeedback; }
+
+	// Movement input locks held by this character's moves
+	DeftLocks& GetDeftLocks() { return m_DeftLocks; }
+	const DeftLocks& GetDeftLocks() const { return m_DeftLocks; }
+
+#if !UE_BUILD_SHIPPING
+	struct LedgeQueryMeasurement
+	{
+		float m_QueriesPerFindLedge = 0.f;
+		double m_MicrosecondsPerFindLedge = 0.0;
+		bool m_bLedgeFound = false;
+	};
+	// Repeats ledge detection from where the character is now (d.Ledge.CountQueries). Traced bypasses the coherence cache,
+	// otherwise the cache is cleared once and every repeat after the first can be answered from it
+	LedgeQueryMeasurement MeasureLedgeQueries(int32 aIterations, bool bTraced, bool bClearanceOverlap);
+#endif
+
 protected:
 	virtual void PhysFalling(float aDeltaTime, int32 aIterations) override;
+	virtual void PhysCustom(float aDeltaTime, int32 aIterations) override;
+	virtual void PhysicsRotation(float aDeltaTime) override;
+	virtual float GetSimulationTimeStep(float aRemainingTime, int32 aIterations) const override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
 
 	// Applies any movement updates necessary each frame after the standard CharacterMovementMode is applied
 	void UpdateInternalMoveMode(float aDeltaTime);
 
+	// Everything the ledge checks need from the owner, fetched once per ledge query instead of once per check
+	struct LedgeQueryContext
+	{
+		FDeftLedgeProbe m_Probe;
+		FQuat m_Rotation = FQuat::Identity;
+		FName m_CollisionProfile;
+		const FCollisionQueryParams* m_QueryParams = nullptr;
+		bool m_bClearanceOverlap = true;	// d.Ledge.ClearanceOverlap
+	};
+	LedgeQueryContext MakeLedgeQueryContext(const FCollisionQueryParams& aQueryParams) const;
+
+	// Probes for a ledge along the path from aOldLocation to where the move ended (d.Ledge.Swept) and grabs or ledges up onto it
+	void SweepForLedge(const FVector& aOldLocation, float aDeltaTime);
+	bool ShouldSweepForLedge() const;
+	void BroadcastMovementEvent(EDeftMovementEvent aEvent);
+	// Runs ledge detection either synchronously or through the async trace pipeline (d.Ledge.Async)
 	bool FindLedge();
+	// Answers from the coherence cache when possible, otherwise traces (TraceLedge) and refreshes the cache
+	bool FindLedgeSync(const FCollisionQueryParams& aQueryParams);
+	bool TraceLedge(const LedgeQueryContext& aContext);
+	// Wall, ledge space and ledge surface checks, everything but the capsule clearance
+	bool TraceLedgeEdge(const LedgeQueryContext& aContext, FHitResult& outWallHit, FHitResult& outSurfaceHit, FVector& outLedgeEdge);
+	bool IsLedgeCacheValid(const struct FDeftLedgeProbe& aProbe, const FCollisionQueryParams& aQueryParams) const;
+	// Looks up static ledges in the baked ledge index and only traces movable geometry
+	bool FindLedgeIndexed(const class UDeftLedgeIndexSubsystem& aLedgeIndex);
+	// Consumes the last finished async ledge query (if still fresh) and starts the next one
+	bool FindLedgeAsync();
+	void StartLedgeAsyncQuery();
+	void StartLedgeClearanceQuery();
+	void CancelLedgeAsyncQuery();
+	void OnLedgeTraceCompleted(const FTraceHandle& aTraceHandle, FTraceDatum& aTraceDatum);
+	// The clearance as an overlap (d.Ledge.ClearanceOverlap)
+	void OnLedgeOverlapCompleted(const FTraceHandle& aTraceHandle, FOverlapDatum& aOverlapDatum);
+	// Counts down the stage's pending queries and moves on to the next stage when they're all back
+	void OnLedgeAsyncQueryReturned();
+	// Ballistic ledge up onto m_ledgeHopUpLocationCache (DeftLedgeLaunch::SolveMinFlightTime). Not called: its call site was
+	// disabled in favor of StartLedgeUp's vertical launch, kept until the ballistic variant is wired back in
 	void PerformLedgeUp();
+	// Launches up onto m_ledgeEdgeCache, from falling or from a ledge hang. This is the live ledge up
+	void StartLedgeUp();
 
-	bool CheckForWall(FVector& outWallLocation);
-	bool CheckForLedge(const FVector& aWallLocation, FVector& outHeightDistance);
-	bool CheckLedgeSurface(const FVector& aFloorCheckHeightOrigin, FVector& outFloorLocation, FVector& outFloorNormal);
-	bool CheckSpaceForCapsule(const FVector& aFloorLocation);
-	void GetLedgeEdge(const FVector& aFloorLocation, const FVector& aFloorNormal, FVector& aWallLocation, FVector& outLedgeEdge);
+	// Probe positioned at the character's current location (or the SweepForLedge probe in progress) facing forward
+	struct FDeftLedgeProbe MakeLedgeProbe() const;
+	bool CheckForWall(const LedgeQueryContext& aContext, FVector& outWallLocation, FHitResult* outHit = nullptr);
+	bool CheckForLedge(const LedgeQueryContext& aContext, const FVector& aWallLocation, FVector& outHeightDistance);
+	bool CheckLedgeSurface(const LedgeQueryContext& aContext, const FVector& aFloorCheckHeightOrigin, FVector& outFloorLocation, FVector& outFloorNormal, FHitResult* outHit = nullptr);
+	bool CheckSpaceForCapsule(const LedgeQueryContext& aContext, const FVector& aFloorLocation);
+	void GetLedgeEdge(const FVector& aViewerLocation, const FVector& aFloorLocation, const FVector& aFloorNormal, FVector& aWallLocation, FVector& outLedgeEdge);
 	void GetHopUpLocation(const FVector& aLedgeEdge, FVector& outHopUpLocation);
 
+	// Ledge Hang
+	// The character is placed from the stored edge segment every frame without any floor finding or sweeps,
+	// the ledge is only looked up again when shimmying past one of the segment's ends
+	struct LedgeSegment
+	{
+		FVector m_Start = FVector::ZeroVector;
+		FVector m_End = FVector::ZeroVector;
+		FVector m_WallNormal = FVector::ZeroVector;		// flattened, points away from the wall
+		FVector m_SurfaceNormal = FVector::UpVector;
+		bool m_bBaked = false;							// the ends are a baked ledge index segment's, otherwise as far as a traced ledge is trusted to continue
+	};
+	LedgeSegment MakeTracedLedgeSegment(const FVector& aLedgeEdge, const FVector& aWallNormal, const FVector& aSurfaceNormal) const;
+	void PhysLedgeHang(float aDeltaTime, int32 aIterations);
+	void EnterLedgeHang();
+	void ClimbFromLedgeHang();
+	void DropFromLedgeHang();
+	// Looks for the ledge continuing past aSegmentEnd and makes it the hang segment
+	bool ExtendLedgeHangSegment(const FVector& aSegmentEnd, const FVector& aDirection);
+	// Capsule center hanging from aLedgeEdge
+	FVector GetLedgeHangLocation(const FVector& aLedgeEdge, const FVector& aWallNormal) const;
+
 private:
+	// Fixed rate simulation (d.FixedStep.Hz), the mesh location and rotation are interpolated between the last two steps.
+	// Each step is a full CMC tick, see TickFixedStep for what runs per step and what once per frame
+	bool ShouldUseFixedStep() const;
+	void TickFixedStep(float aDeltaTime, float aStepTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction);
+	void StopFixedStepInterpolation();
+
+	void HandleJumpPressed();
+	void HandleJumpReleased();
+	void PerformAirDash();
+	// Follows the dash curve with one sweep per step, see DeftJumpKinematics::CalculateAirDashOffset
+	void PhysAirDash(float aDeltaTime, int32 aIterations);
+	void EndAirDash();
+	// High speed substepping, steps are sized from the capsule radius so only fast moves pay for extra sweeps
+	float GetHighSpeedMaxStepDistance() const;
+	int32 GetHighSpeedSubsteps(float aMoveDistance) const;
 	void OnJumpApexReached();
 	// Calculates the initial velocity needed to achieve the desired height in the desired time
 	FVector CalculateJumpInitialVelocity(float aTime, float aHeight);
@@ -86,6 +258,8 @@ private:
 	float CalculateJumpGravityScale(float aTime, float aHeight);
 	bool IsAttemptingDoubleJump() const { return m_bInPlatformJump && m_bIsFallOriginSet; }
 	void ResetJump();
+	// Takes or releases the ledge up and air dash locks to match the move state, for replays that set it without the transitions
+	void RestoreMoveLocks();
 
 protected:
 	// Max Jump height if the player holds the button the required max time
@@ -116,6 +290,10 @@ protected:
 	float LedgeHeightOrigin;
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Control | Ledge Height Reach", meta=(ToolTip="Maximum reach distance a ledge can be in front of the player"))
 	float LedgeHeightForwardReach;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Control | Sweep", meta=(ClampMin="1", ToolTip="Max ledge probes along one move, bounds the ledge queries per move however far the character travelled. Longer moves space the probes further apart and widen each one by the gap, so the whole move is always checked"))
+	int32 LedgeSweepMaxProbes = 4;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Control | Sweep", meta=(ClampMin="1.0", ToolTip="How far the wall reach may grow with forward speed, as a multiple of WallReach"))
+	float LedgeProbeMaxReachScale = 2.f;
 
 	// ledge up 2.0
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Control v2 ", meta=(ToolTip="Additional offset to apply to the minimum height the ledge up jumps the player (which is high enough for the capsule to be just above ledge) "))
@@ -127,6 +305,18 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Control v2 ", meta=(ToolTip="Force Feedback Effect to use for ledge up"))
 	TObjectPtr<class UForceFeedbackEffect> LedgeUpFeedback;
 
+	// Ledge Hang
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Hang", meta=(ToolTip="How far (cm) below the ledge edge the capsule center hangs"))
+	float LedgeHangHeightOffset = 60.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Hang", meta=(ToolTip="Speed (cm/s) of shimmying along a ledge at full input"))
+	float LedgeHangShimmySpeed = 150.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Hang", meta=(ToolTip="How far (cm) a traced ledge is trusted to continue either side of where it was found before it's traced again"))
+	float LedgeHangTracedSegmentExtent = 25.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Hang", meta=(ClampMin="0.0", ClampMax="1.0", ToolTip="How directly the move input has to point away from the wall to drop"))
+	float LedgeHangDropInputThreshold = 0.7f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ledge Hang", meta=(ToolTip="Time (s) after dropping before a ledge can be grabbed again"))
+	float LedgeHangRegrabDelay = 0.3f;
+
 	// Air Dash
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Air Dash", meta=(ToolTip="How far (cm) should air dashing send you"))
 	float AirDashDistance;
@@ -134,6 +324,12 @@ protected:
 	float AirDashTime;
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Air Dash", meta=(ToolTip="(optional) vertical force for a very slight curve"))
 	float AirDashVerticalHeight;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Air Dash", meta=(ToolTip="Deceleration (cm/s^2) bleeding the dash speed off once the dash ends, down to the normal max speed"))
+	float AirDashExitDeceleration = 2000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Air Dash", meta=(ClampMin="0.05", ToolTip="Fraction of the capsule radius the dash (and the speed left over from it) may move per substep, lower is safer against thin geometry but sweeps more"))
+	float HighSpeedSubstepRadiusFraction = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Air Dash", meta=(ClampMin="1", ToolTip="Cap on the substeps of one dash frame"))
+	int32 HighSpeedMaxSubsteps = 8;
 
 private:
 	// Jump Physics
@@ -160,9 +356,134 @@ private:
 	bool m_bIsLedgingUp;
 	float m_ledgeBoostTime;
 	float m_ledgeBoostMaxTime;
+	LedgeSegment m_ledgeSegmentCache;			// segment through m_ledgeEdgeCache, set with it by every ledge detection path
+	LedgeSegment m_LedgeHangSegment;			// segment being hung from
+	struct LedgeSweepProbe
+	{
+		bool m_bActive = false;
+		FVector m_Origin = FVector::ZeroVector;
+		float m_ExtraReach = 0.f;
+		float m_ExtraHeight = 0.f;			// how much further apart the probes are than LedgeHeightOrigin
+	} m_LedgeSweepProbe;						// only set while SweepForLedge is probing, read by MakeLedgeProbe
+	bool m_bLedgeInReach = false;				// the last ledge sweep found a ledge, LedgeFound is raised on the edge
+	float m_LedgeHangRegrabTime = 0.f;			// counts down after a drop, no grabbing until it runs out
+
+	// Async Ledge Detection
+	// Wall, ledge space and ledge surface only depend on where the query started so they are issued together,
+	// the capsule clearance sweep depends on the surface hit so it's chained off of their results
+	enum class ELedgeAsyncStage : uint8
+	{
+		Idle,		// nothing in flight, a new query can be started
+		Probe,		// wall, ledge space and ledge surface traces in flight
+		Clearance,	// capsule clearance sweep or overlap in flight
+		Complete	// result is waiting to be consumed by PhysFalling
+	};
+	enum ELedgeAsyncTrace : uint8
+	{
+		LAT_Wall,
+		LAT_Space,
+		LAT_Surface,
+		LAT_Clearance
+	};
+	struct LedgeAsyncQuery
+	{
+		ELedgeAsyncStage m_Stage = ELedgeAsyncStage::Idle;
+		uint32 m_QueryId = 0;						// stamped into the trace user data so results of abandoned queries are ignored
+		uint64 m_StartFrame = 0;
+		FVector m_Origin = FVector::ZeroVector;		// actor location when the query was issued
+		FVector m_Up = FVector::UpVector;
+		FQuat m_Rotation = FQuat::Identity;
+		uint8 m_PendingTraces = 0;
+		bool m_bWallHit = false;
+		bool m_bSpaceHit = false;
+		bool m_bSurfaceHit = false;
+		bool m_bEdgeFound = false;					// wall, space and surface passed so the ledge edge is valid
+		bool m_bLedgeFound = false;					// edge found and the capsule fits on top
+		FVector m_WallLocation = FVector::ZeroVector;
+		FVector m_WallNormal = FVector::ZeroVector;
+		FVector m_SurfaceLocation = FVector::ZeroVector;
+		FVector m_SurfaceNormal = FVector::ZeroVector;
+		FVector m_LedgeEdge = FVector::ZeroVector;
+		FVector m_HopUpLocation = FVector::ZeroVector;
+	} m_LedgeAsyncQuery;
+	FTraceDelegate m_LedgeTraceDelegate;
+	FOverlapDelegate m_LedgeOverlapDelegate;
+
+	// Ledge Coherence Cache
+	// Falling next to a wall repeats the same traces frame after frame, the last traced result is reused while the
+	// character stays close to where it was traced and nothing it hit has moved (d.Ledge.Coherence*)
+	struct LedgeCacheHit
+	{
+		TWeakObjectPtr<const UPrimitiveComponent> m_Component;
+		FTransform m_ComponentTransform;
+		FVector m_Location = FVector::ZeroVector;
+		FVector m_Normal = FVector::ZeroVector;
+		bool m_bHit = false;
+
+		void Set(const FHitResult& aHit);
+		bool IsUnmoved() const;
+	};
+	struct LedgeCoherenceCache
+	{
+		bool m_bValid = false;
+		uint64 m_Frame = 0;
+		const FCollisionQueryParams* m_QueryParams = nullptr;
+		FVector m_Origin = FVector::ZeroVector;
+		FVector m_Forward = FVector::ZeroVector;
+		// the sweep probes widen the reach, a result from a shorter probe can't answer a longer one
+		float m_WallReach = 0.f;
+		float m_LedgeHeightForwardReach = 0.f;
+		float m_LedgeHeightOrigin = 0.f;
+		LedgeCacheHit m_Wall;
+		LedgeCacheHit m_Surface;
+		bool m_bEdgeFound = false;
+		bool m_bClearance = false;
+		FVector m_LedgeEdge = FVector::ZeroVector;
+		FVector m_HopUpLocation = FVector::ZeroVector;
+		uint32 m_Hits = 0;
+		uint32 m_Misses = 0;
+	} m_LedgeCache;
+
+	FOnDeftMovementEvent m_OnMovementEvent;
 
 	// Air Dash Physics
 	bool m_bHasAirDashed = false;
+	bool m_bWantsToAirDash = false;
+	float m_AirDashElapsed = 0.f;					// time into the dash curve
+	FVector m_AirDashDirection = FVector::ZeroVector;	// flattened forward when the dash started
+
+	// Networking
+	bool m_bWasJumpButtonDown = false;			// m_bIsJumpButtonDown as of the last move, used to find press/release edges
+	bool m_bLedgeUpThisMove = false;			// client: a ledge up or ledge grab started during the current move
+	bool m_bClientLedgeUpRequested = false;		// server: the remote client ledged up or grabbed a ledge during the move being performed
+	NetworkStats m_NetworkStats;
+	FDeftCharacterNetworkMoveDataContainer m_DeftNetworkMoveDataContainer;
+
+	// Significance LOD
+	EDeftMovementLOD m_MovementLOD = EDeftMovementLOD::High;
+	FDeftMovementLODSettings m_LODSettings;
+	float m_TickIntervalBlendRate = 0.f;		// tick interval change per second while blending to m_LODSettings.m_TickInterval
+
+	// Batched post move update (UDeftMovementSubsystem), what the frame's moves covered until the subsystem runs
+	FVector m_BatchPostMoveOldLocation = FVector::ZeroVector;
+	float m_BatchPostMoveDeltaTime = 0.f;
+	bool m_bBatchPostMovePending = false;
+
+	// Fixed Step
+	float m_FixedStepAccumulator = 0.f;
+	FVector m_FixedStepPreviousLocation = FVector::ZeroVector;	// UpdatedComponent location before the last simulated step
+	FQuat m_FixedStepPreviousRotation = FQuat::Identity;			// and its rotation
+	bool m_bFixedStepInterpolating = false;
+
+	// Async Movement
+	TSharedPtr<struct FDeftAsyncSimState, ESPMode::ThreadSafe> m_DeftAsyncSimState;
+	TArray<const struct FCharacterAsyncInput*, TInlineAllocator<4>> m_DeftAsyncInputs;	// pooled async inputs whose character input is already ours
+
+	// Input Locks
+	// handles must be declared after m_DeftLocks so they are released before it's destroyed
+	DeftLocks m_DeftLocks;
+	DeftLockHandle m_LedgeUpLock;
+	DeftLockHandle m_AirDashLock;
 
 	// Default Physics
 	float m_DefaultGravityZCache = 0.f;
@@ -173,11 +494,14 @@ private:
 	EInternalMoveMode m_InternalMoveMode = EInternalMoveMode::IMOVE_None;
 
 	FCollisionQueryParams m_CollisionQueryParams;
+	FCollisionQueryParams m_MovableCollisionQueryParams;	// same as m_CollisionQueryParams but ignores static geometry (covered by the ledge index)
 	FCollisionShape m_CapsuleCollisionShapeCache;
 	FCollisionShape m_SphereCollisionShape;
 
 #if DEBUG_VIEW
 	void DrawDebug();
+	void DrawLockDebug();
+	void DrawLedgeCacheDebug();
 	void DebugMovement();
 	void DebugPhysFalling();
 	void DebugLedgeLaunch(const FVector& aStartLocation, const FVector& aLaunchVelocity, float aFlightTime, float aTimestep, FColor aDrawColor);
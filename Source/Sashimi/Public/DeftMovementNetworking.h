@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/CharacterMovementReplication.h"
+
+/**
+ * Client side record of one Deft move. Inputs (jump held, dash request, ledge up) are packed into the custom compressed
+ * flags, the rest is the component state at the start of the move so a replay after a correction, or a move combined
+ * into the one before it, starts from the same place.
+ */
+class SASHIMI_API FSavedMove_Deft : public FSavedMove_Character
+{
+	typedef FSavedMove_Character Super;
+
+	public:
+		enum CompressedFlags
+		{
+			FLAG_JumpHeld		= FLAG_Custom_0,
+			FLAG_AirDash		= FLAG_Custom_1,
+			FLAG_LedgeUp		= FLAG_Custom_2,	// the client ledged up or grabbed a ledge during this move, the server only looks for ledges on these moves
+		};
+
+		virtual void Clear() override;
+		virtual uint8 GetCompressedFlags() const override;
+		virtual bool CanCombineWith(const FSavedMovePtr& aNewMove, ACharacter* aCharacter, float aMaxDelta) const override;
+		virtual void SetMoveFor(ACharacter* aCharacter, float aInDeltaTime, FVector const& aNewAccel, FNetworkPredictionData_Client_Character& aClientData) override;
+		virtual void SetInitialPosition(ACharacter* aCharacter) override;
+		virtual void CombineWith(const FSavedMove_Character* aOldMove, ACharacter* aCharacter, APlayerController* aPlayerController, const FVector& aOldStartLocation) override;
+		virtual void PostUpdate(ACharacter* aCharacter, EPostUpdateMode aPostUpdateMode) override;
+		virtual void PrepMoveFor(ACharacter* aCharacter) override;
+
+		// Inputs
+		bool m_bJumpHeld = false;
+		bool m_bWantsToAirDash = false;
+		bool m_bLedgeUp = false;
+		uint8 m_QuantizedJumpHoldTime = 0;
+
+		// Start state
+		bool m_bWasJumpButtonDown = false;
+		bool m_bIncrementJumpInputHoldTime = false;
+		bool m_bInPlatformJump = false;
+		bool m_bJumpApexReached = false;
+		bool m_bHasAirDashed = false;
+		uint8 m_JumpInputCounter = 0;
+		float m_AirDashElapsed = 0.f;
+		FVector m_AirDashDirection = FVector::ZeroVector;
+		float m_JumpKeyHoldTime = 0.f;
+		float m_GravityScale = 0.f;
+		bool m_bIsLedgingUp = false;
+		uint8 m_InternalMoveMode = 0;			// EInternalMoveMode
+		FVector m_LedgeHangStart = FVector::ZeroVector;
+		FVector m_LedgeHangEnd = FVector::ZeroVector;
+		FVector m_LedgeHangWallNormal = FVector::ZeroVector;
+		FVector m_LedgeHangSurfaceNormal = FVector::UpVector;
+		bool m_bLedgeHangBaked = false;
+
+	private:
+		// Puts the start state back on the component, the input locks are derived from it
+		void RestoreStartState(class UDeftMovementComponent& outMovementComponent) const;
+};
+
+class SASHIMI_API FNetworkPredictionData_Client_Deft : public FNetworkPredictionData_Client_Character
+{
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	public:
+		FNetworkPredictionData_Client_Deft(const UCharacterMovementComponent& aClientMovement) : Super(aClientMovement) {}
+
+		virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+// Move data sent to the server, adds the quantized jump hold time (only serialized while it's non zero)
+struct SASHIMI_API FDeftCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& aClientMove, ENetworkMoveType aMoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& aCharacterMovement, FArchive& aAr, UPackageMap* aPackageMap, ENetworkMoveType aMoveType) override;
+
+	uint8 m_QuantizedJumpHoldTime = 0;
+};
+
+struct SASHIMI_API FDeftCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FDeftCharacterNetworkMoveDataContainer();
+
+	FDeftCharacterNetworkMoveData m_DeftMoveData[3];
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_STATS_GROUP(TEXT("DeftMovement"), STATGROUP_DeftMovement, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysFalling"), STAT_DeftPhysFalling, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysLedgeHang"), STAT_DeftPhysLedgeHang, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhysAirDash"), STAT_DeftPhysAirDash, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("BatchPostMove"), STAT_DeftBatchPostMove, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MassJump"), STAT_DeftMassJump, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateInternalMoveMode"), STAT_DeftUpdateInternalMoveMode, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SweepForLedge"), STAT_DeftSweepForLedge, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FindLedge"), STAT_DeftFindLedge, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckForWall"), STAT_DeftCheckForWall, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckForLedge"), STAT_DeftCheckForLedge, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckLedgeSurface"), STAT_DeftCheckLedgeSurface, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckSpaceForCapsule"), STAT_DeftCheckSpaceForCapsule, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PerformLedgeUp"), STAT_DeftPerformLedgeUp, STATGROUP_DeftMovement, SASHIMI_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Scene Queries"), STAT_DeftSceneQueries, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Candidates"), STAT_DeftLedgeCandidates, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock Transitions"), STAT_DeftLockTransitions, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Cache Hits"), STAT_DeftLedgeCacheHits, STATGROUP_DeftMovement, SASHIMI_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Cache Misses"), STAT_DeftLedgeCacheMisses, STATGROUP_DeftMovement, SASHIMI_API);
+
+UE_TRACE_CHANNEL_EXTERN(DeftMovementChannel, SASHIMI_API);
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(SASHIMI_API, DeftMovement);
+
+// Scoped timer visible in "stat DeftMovement", Insights (DeftMovement channel) and CSV captures. Name matches a STAT_Deft<Name> above
+#define DEFT_MOVEMENT_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Deft##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("Deft" #Name, DeftMovementChannel); \
+	CSV_SCOPED_TIMING_STAT(DeftMovement, Name)
+
+enum class EDeftMovementCounter : uint8
+{
+	SceneQueries,		// every trace/sweep issued by ledge detection (sync or async)
+	LedgeCandidates,	// ledge edges found, whether or not the capsule fit on top
+	LockTransitions,	// DeftLocks acquires and releases
+	LedgeCacheHits,		// traced ledge detections answered by the coherence cache
+	LedgeCacheMisses,	// traced ledge detections that had to query the scene
+	COUNT
+};
+
+namespace DeftMovementStats
+{
+	// Adds to a per frame counter, safe to call from any thread
+	SASHIMI_API void AddCount(EDeftMovementCounter aCounter, uint32 aAmount = 1);
+	// Value a counter reached on aFrame, only valid for the current frame (GFrameCounter)
+	SASHIMI_API uint32 GetCount(EDeftMovementCounter aCounter, uint64 aFrame);
+
+	// Time spent ticking every UDeftMovementComponent, read back per frame by benchmarks
+	SASHIMI_API void AddMovementTickCycles(uint64 aCycles);
+	SASHIMI_API double GetMovementTickMs(uint64 aFrame);
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DeftMovementSubsystem.generated.h"
+
+class UDeftMovementComponent;
+
+/**
+ * Opt-in (d.Movement.Batch) batched post move update for every Deft character in the world. Instead of each
+ * component doing its ledge sweep and UpdateInternalMoveMode at the end of its own move, the moves queue
+ * themselves and this runs the lot once per frame after all actors have ticked:
+ *	1. ledge queries, serial since they go to the scene and can change movement mode
+ *	2. gather the hot state into a structure of arrays
+ *	3. hold time, apex detection and the dash exit in a ParallelFor over those arrays, the ledge up boost through
+ *	   the DeftJumpKinematicsBatch vector kernel
+ *	4. write back, and raise the apex (locks, gravity, events) on the game thread
+ * Standalone only, networked moves have to finish inside the move so replays and the server see the same thing.
+ */
+UCLASS()
+class SASHIMI_API UDeftMovementSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Whether aMovement's post move work goes through the batch this frame
+	static bool ShouldBatch(const UDeftMovementComponent& aMovement);
+
+	// Called by a component's first move of the frame
+	void QueuePostMove(UDeftMovementComponent* aMovement);
+
+	virtual void Tick(float aDeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	enum EBatchFlags : uint8
+	{
+		BF_None					= 0,
+		BF_SimulateInternal		= 1 << 0,	// LOD runs the full UpdateInternalMoveMode, otherwise only hold time and apex
+		BF_InPlatformJump		= 1 << 1,
+		BF_IncrementHoldTime	= 1 << 2,
+		BF_JumpApexReached		= 1 << 3,
+		BF_AirDashExit			= 1 << 4,	// falling with dash speed left to bleed off
+		BF_ApexReachedNow		= 1 << 5,	// output: OnJumpApexReached has to run
+	};
+
+	// Hot post move state, one array per field so the parallel pass walks contiguous memory
+	struct MovementBatch
+	{
+		TArray<UDeftMovementComponent*> m_Components;
+		TArray<float> m_VelocityX;
+		TArray<float> m_VelocityY;
+		TArray<float> m_VelocityZ;
+		TArray<float> m_ForwardX;
+		TArray<float> m_ForwardY;
+		TArray<float> m_DeltaTime;
+		TArray<float> m_HeightAboveJumpStart;
+		TArray<float> m_MaxSpeed;
+		TArray<float> m_ExitDeceleration;
+		TArray<float> m_LedgeUpBoost;		// zero unless ledging up
+		TArray<float> m_JumpKeyHoldTime;
+		TArray<float> m_PlatformJumpApex;
+		TArray<uint8> m_Flags;
+
+		void Reset(int32 aExpectedNum);
+		int32 Num() const { return m_Components.Num(); }
+	};
+
+	void RunLedgeQueries();
+	void Gather();
+	void Simulate();
+	void Apply();
+
+	// UDeftMovementComponent::UpdateInternalMoveMode for one entry of the batch, all but the ledge up boost
+	static void SimulateEntry(MovementBatch& aBatch, int32 aIndex);
+
+	TArray<TWeakObjectPtr<UDeftMovementComponent>> m_Queued;
+	MovementBatch m_Batch;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObjectTrace.h"
+
+#define DEFT_MOVEMENT_TRACE_ENABLED (UE_TRACE_ENABLED && OBJECT_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+// Bits of the DeftMovement.MovementState Flags field (also read by the SashimiEditor analyzer)
+enum EDeftMovementTraceFlags : uint8
+{
+	DMTF_None				= 0,
+	DMTF_InPlatformJump		= 1 << 0,
+	DMTF_JumpApexReached	= 1 << 1,
+	DMTF_JumpButtonDown		= 1 << 2,
+	DMTF_LedgingUp			= 1 << 3,
+	DMTF_HasAirDashed		= 1 << 4,
+};
+
+#if DEFT_MOVEMENT_TRACE_ENABLED
+
+class UDeftMovementComponent;
+
+/**
+ * Binary per frame record of a UDeftMovementComponent's state on the DeftMovement trace channel, read back by the
+ * SashimiEditor Rewind Debugger track. Nothing is formatted at runtime, a record is a single fixed size event.
+ */
+struct SASHIMI_API FDeftMovementTrace
+{
+	static void OutputMovementState(const UDeftMovementComponent& aMovementComponent);
+};
+
+#define TRACE_DEFT_MOVEMENT_STATE(MovementComponent) FDeftMovementTrace::OutputMovementState(MovementComponent)
+
+#else
+
+#define TRACE_DEFT_MOVEMENT_STATE(MovementComponent)
+
+#endif//DEFT_MOVEMENT_TRACE_ENABLED
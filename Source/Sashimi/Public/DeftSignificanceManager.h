@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SignificanceManager.h"
+#include "DeftSignificanceManager.generated.h"
+
+// Movement LOD buckets, most significant first
+enum class EDeftMovementLOD : uint8
+{
+	High,		// near a viewer: full rate, ledge detection and debug
+	Medium,		// visible but further away: reduced rate, no ledge debug
+	Low,		// far: low rate, no ledge detection, internal move mode extrapolated
+	Dormant,	// far and behind every viewer
+	COUNT
+};
+
+// What a bucket runs, see UDeftMovementComponent::SetMovementLOD
+struct FDeftMovementLODSettings
+{
+	float m_TickInterval = 0.f;
+	bool m_bFindLedge = true;				// run FindLedge while falling
+	bool m_bLedgeUpDebug = true;			// PerformLedgeUp trajectory debug (only if the ballistic ledge up is in use)
+	bool m_bSimulateInternalMoveMode = true;	// otherwise UpdateInternalMoveMode only handles the apex transition
+
+	static const FDeftMovementLODSettings& Get(EDeftMovementLOD aLOD);
+};
+
+/**
+ * Buckets every UDeftMovementComponent by distance to (and whether it's in front of) the closest player viewpoint.
+ * Set as the SignificanceManagerClassName in DefaultEngine.ini, updated once per frame after actors tick.
+ */
+UCLASS()
+class SASHIMI_API UDeftSignificanceManager : public USignificanceManager
+{
+	GENERATED_BODY()
+
+public:
+	static const FName MovementTag;
+
+	virtual void PostInitProperties() override;
+	virtual void BeginDestroy() override;
+
+	void RegisterMovement(class UDeftMovementComponent* aMovement);
+	void UnregisterMovement(class UDeftMovementComponent* aMovement);
+
+private:
+	void OnWorldPostActorTick(UWorld* aWorld, ELevelTick aTickType, float aDeltaSeconds);
+
+	static float CalculateSignificance(FManagedObjectInfo* aObjectInfo, const FTransform& aViewpoint);
+	static void OnSignificanceChanged(FManagedObjectInfo* aObjectInfo, float aOldSignificance, float aSignificance, bool bFinal);
+
+	FDelegateHandle m_PostActorTickHandle;
+	TArray<FTransform> m_Viewpoints;
+};
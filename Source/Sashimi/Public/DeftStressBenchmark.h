@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Controller.h"
+#include "DeftStressBenchmark.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogDeftStress, Log, All);
+
+/**
+ * Drives a UDeftMovementComponent pawn down its benchmark lane, cycling through the moves the component implements.
+ * Input goes through the same entry points as APlayerCharacter so every move runs the real prediction/ledge code.
+ */
+UCLASS(NotPlaceable, Transient)
+class SASHIMI_API ADeftStressController : public AController
+{
+	GENERATED_BODY()
+
+public:
+	enum class EStressMove : uint8
+	{
+		Jump,
+		VariableJump,
+		DoubleJump,
+		AirDash,
+		LedgeUp,
+		COUNT
+	};
+
+	ADeftStressController();
+	virtual void Tick(float aDeltaSeconds) override;
+
+	void SetLane(const FVector& aStart, float aLength, int32 aSeed);
+	// Moves run to the end or cut short by the lane reset, the pawn has been through every move once this reaches EStressMove::COUNT
+	int32 GetMovesCompleted() const { return m_MovesCompleted; }
+
+private:
+	void StartMove(EStressMove aMove);
+	void PressJump();
+	void ReleaseJump();
+
+	FVector m_LaneStart = FVector::ZeroVector;
+	float m_LaneLength = 0.f;
+	FRandomStream m_Random;
+
+	EStressMove m_Move = EStressMove::Jump;
+	float m_MoveTime = 0.f;
+	float m_ReleaseTime = 0.f;		// when the (first) jump press is released
+	bool m_bJumpHeld = false;
+	bool m_bSecondActionDone = false;	// double jump / air dash fired
+	int32 m_MovesCompleted = 0;
+};
+
+/**
+ * Spawns N movement pawns on generated ledge lanes and measures them for a fixed duration (d.Stress.Run).
+ * After a warmup, per frame game thread ms, scene queries and movement ms per character are written to
+ * Saved/Benchmarks/DeftStress_<N>_<timestamp>.csv. Runs headless, e.g.
+ *   -game -nullrhi -unattended -ExecCmds="d.Stress.Run 500 30 exit"
+ */
+UCLASS(NotPlaceable, Transient)
+class SASHIMI_API ADeftStressBenchmark : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 MaxCharacters = 500;
+
+	ADeftStressBenchmark();
+	virtual void Tick(float aDeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type aEndPlayReason) override;
+
+	// Returns false if the game mode's default pawn doesn't use UDeftMovementComponent
+	bool Start(int32 aCharacterCount, float aDurationSeconds, bool bExitWhenDone);
+
+	struct Results
+	{
+		FString m_CsvPath;					// empty if it couldn't be written
+		int32 m_Frames = 0;
+		TArray<int32> m_MovesCompleted;		// per character, see ADeftStressController::GetMovesCompleted
+	};
+	// Only valid once the run has finished
+	const Results* GetResults() const { return m_bFinished ? &m_Results : nullptr; }
+
+private:
+	struct FrameSample
+	{
+		uint64 m_Frame = 0;
+		float m_GameThreadMs = 0.f;
+		uint32 m_SceneQueries = 0;
+		float m_MovementMs = 0.f;
+	};
+
+	void BuildLanes(TSubclassOf<APawn> aPawnClass, int32 aCharacterCount);
+	void Finish();
+	void WriteCsv();
+	void Cleanup();
+
+	UPROPERTY()
+	class UInstancedStaticMeshComponent* m_LaneGeometry = nullptr;
+	UPROPERTY()
+	TArray<APawn*> m_Pawns;
+	UPROPERTY()
+	TArray<AController*> m_Controllers;
+
+	TArray<FrameSample> m_Samples;
+	Results m_Results;
+	float m_Elapsed = 0.f;
+	float m_WarmupSeconds = 2.f;
+	float m_DurationSeconds = 0.f;
+	bool m_bExitWhenDone = false;
+	bool m_bRunning = false;
+	bool m_bFinished = false;
+};
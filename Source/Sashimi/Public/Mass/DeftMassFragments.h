@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "Engine/EngineTypes.h"
+#include "DeftJumpKinematics.h"
+#include "DeftMassFragments.generated.h"
+
+/**
+ * Per agent state of the Deft jump model for Mass crowds (UDeftMassJumpProcessor), the counterpart of
+ * UDeftMovementComponent's jump/dash members. Game code drives it through the two input fields, and sets the
+ * horizontal velocity to carry into a jump.
+ */
+USTRUCT()
+struct SASHIMI_API FDeftMassJumpFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// Input, set by whatever controls the agent
+	bool bJumpButtonDown = false;
+	bool bWantsToAirDash = false;		// consumed by the next step
+
+	FVector Velocity = FVector::ZeroVector;
+	FVector AirDashDirection = FVector::ZeroVector;
+	float GravityScale = 1.f;
+	float JumpKeyHoldTime = 0.f;
+	float AirDashElapsed = 0.f;
+	uint8 JumpInputCounter = 0;
+	bool bWasJumpButtonDown = false;
+	bool bFalling = false;
+	bool bAirDashing = false;			// CustomMovement::AirDash
+	bool bAirDashExit = false;			// IMOVE_AirDash while falling, the dash speed is bleeding off
+	bool bIncrementJumpInputHoldTime = false;
+	bool bInPlatformJump = false;
+	bool bJumpApexReached = false;
+	bool bHasAirDashed = false;
+};
+
+/**
+ * Tuning shared by every agent built from the same UDeftMassJumpTrait, copied from a UDeftMovementComponent's
+ * defaults. Everything is a UPROPERTY so agents with different tuning end up in different shared fragments.
+ */
+USTRUCT()
+struct SASHIMI_API FDeftMassJumpTuningFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float JumpMaxHeight = 0.f;
+	UPROPERTY()
+	float TimeToJumpMaxHeight = 0.f;
+	UPROPERTY()
+	float JumpMinHeight = 0.f;
+	UPROPERTY()
+	float PostTimeToJumpMaxHeight = 0.f;
+	UPROPERTY()
+	float JumpKeyMaxHoldTime = 0.f;
+	UPROPERTY()
+	float AirDashDistance = 0.f;
+	UPROPERTY()
+	float AirDashTime = 0.f;
+	UPROPERTY()
+	float AirDashVerticalHeight = 0.f;
+	UPROPERTY()
+	float AirDashExitDeceleration = 0.f;
+	UPROPERTY()
+	float DefaultGravityZ = 0.f;		// UPhysicsSettings::DefaultGravityZ, what the gravity scales are relative to
+	UPROPERTY()
+	float DefaultGravityScale = 1.f;
+	UPROPERTY()
+	float MaxSpeed = 0.f;				// MaxWalkSpeed, what the dash exit decelerates back down to
+	UPROPERTY()
+	float TerminalVelocity = 0.f;
+	UPROPERTY()
+	float CapsuleRadius = 0.f;
+	UPROPERTY()
+	float CapsuleHalfHeight = 0.f;
+	UPROPERTY()
+	float MaxStepHeight = 0.f;
+	UPROPERTY()
+	float WalkableFloorZ = 0.f;
+	UPROPERTY()
+	uint8 JumpInputMax = 2;
+	UPROPERTY()
+	TEnumAsByte<ECollisionChannel> CollisionChannel = ECC_Pawn;
+
+	// Same kernel input as UDeftMovementComponent::GetJumpTuning
+	FDeftJumpTuning GetJumpTuning() const;
+};
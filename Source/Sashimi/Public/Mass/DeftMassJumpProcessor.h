@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "DeftMassJumpProcessor.generated.h"
+
+struct FDeftMassJumpFragment;
+struct FDeftMassJumpTuningFragment;
+struct FDeftJumpTuning;
+struct FDeftJumpGravityScales;
+
+/**
+ * The per agent steps of UDeftMassJumpProcessor without the world, so the integration can be checked against
+ * DeftJumpKinematics on its own.
+ */
+namespace DeftMassJump
+{
+	// Applies the step's jump/dash input and integrates the agent's velocity, returns where it wants to move
+	SASHIMI_API FVector Integrate(FDeftMassJumpFragment& outJump, const FQuat& aRotation, const FDeftMassJumpTuningFragment& aTuning, const FDeftJumpTuning& aJumpTuning, const FDeftJumpGravityScales& aScales, float aWorldGravityZ, float aDeltaTime);
+	// Hold time, apex and dash exit after a falling move that didn't land
+	SASHIMI_API void UpdateAfterFalling(FDeftMassJumpFragment& outJump, const FDeftMassJumpTuningFragment& aTuning, const FDeftJumpGravityScales& aScales, float aDeltaTime);
+};
+
+/**
+ * The Deft jump model for Mass agents: variable height jumps with pre/post apex gravity, double jump and the
+ * analytic air dash, using the same DeftJumpKinematics kernel as UDeftMovementComponent. Agents move their
+ * FTransformFragment (feet location) while airborne and check for the floor while walking, walking movement
+ * itself is left to whatever else moves the agent.
+ *
+ * Each chunk is stepped in three passes so all of its scene queries are issued together with one shape and
+ * query params: integrate every agent, sweep every move in a ParallelFor (d.Mass.JumpMinParallel), then resolve the hits.
+ */
+UCLASS()
+class SASHIMI_API UDeftMassJumpProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UDeftMassJumpProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery m_EntityQuery;
+
+	// Per chunk scratch, chunks are processed one after the other, the sweeps write their own index
+	TArray<FVector> m_MoveDeltas;
+	TArray<FHitResult> m_Hits;
+	TArray<bool> m_bHits;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTraitBase.h"
+#include "DeftMassJumpTrait.generated.h"
+
+/**
+ * Gives a Mass agent the Deft jump model (UDeftMassJumpProcessor) with the tuning of a Deft character's movement
+ * component, so crowds jump and dash exactly like that character.
+ */
+UCLASS(meta=(DisplayName="Deft Jump"))
+class SASHIMI_API UDeftMassJumpTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+public:
+	// Character whose UDeftMovementComponent and capsule defaults are used, the component's own defaults if unset
+	UPROPERTY(EditAnywhere, Category = "Deft")
+	TSubclassOf<class ACharacter> TuningCharacter;
+
+protected:
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+};
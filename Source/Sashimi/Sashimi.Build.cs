@@ -8,7 +8,7 @@ public class Sashimi : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 	
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "SignificanceManager", "MassEntity", "MassCommon", "MassSpawner" });
 
 		PrivateDependencyModuleNames.AddRange(new string[] {  });
 
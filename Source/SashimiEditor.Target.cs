@@ -11,5 +11,6 @@ public class SashimiEditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_5;
 		ExtraModuleNames.Add("Sashimi");
+		ExtraModuleNames.Add("SashimiEditor");
 	}
 }
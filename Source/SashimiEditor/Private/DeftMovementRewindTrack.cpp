@@ -0,0 +1,132 @@
+#include "DeftMovementRewindTrack.h"
+#include "DeftMovementTraceProvider.h"
+#include "DeftMovementTrace.h"
+#include "IRewindDebugger.h"
+#include "TraceServices/Model/AnalysisSession.h"
+#include "Widgets/Text/STextBlock.h"
+#include "Styling/AppStyle.h"
+#include "Engine/EngineTypes.h"
+
+#define LOCTEXT_NAMESPACE "DeftMovementRewindTrack"
+
+namespace DeftMovementRewindTrack
+{
+	// matches EInternalMoveMode
+	static const TCHAR* InternalMoveModeNames[] = { TEXT("Jump"), TEXT("LedgeUp"), TEXT("AirDash"), TEXT("None") };
+
+	static const TCHAR* GetInternalMoveModeName(uint8 aInternalMoveMode)
+	{
+		return aInternalMoveMode < UE_ARRAY_COUNT(InternalMoveModeNames) ? InternalMoveModeNames[aInternalMoveMode] : TEXT("Unknown");
+	}
+
+	static const FDeftMovementTraceProvider* GetProvider(const TraceServices::IAnalysisSession* aSession)
+	{
+		return aSession ? aSession->ReadProvider<FDeftMovementTraceProvider>(FDeftMovementTraceProvider::ProviderName) : nullptr;
+	}
+};
+
+
+FDeftMovementTrack::FDeftMovementTrack(uint64 aObjectId)
+	: m_ObjectId(aObjectId)
+	, m_Icon(FAppStyle::GetAppStyleSetName(), "ClassIcon.CharacterMovementComponent")
+	, m_GravityScaleCurve(MakeShared<SCurveTimelineView::FTimelineCurveData>())
+{
+}
+
+FText FDeftMovementTrack::GetDisplayNameInternal() const
+{
+	return LOCTEXT("TrackName", "Deft Movement");
+}
+
+bool FDeftMovementTrack::UpdateInternal()
+{
+	IRewindDebugger* rewindDebugger = IRewindDebugger::Instance();
+	const TraceServices::IAnalysisSession* session = rewindDebugger->GetAnalysisSession();
+	if (!session)
+		return false;
+
+	TraceServices::FAnalysisSessionReadScope sessionReadScope(*session);
+	const FDeftMovementTraceProvider* provider = DeftMovementRewindTrack::GetProvider(session);
+	if (!provider)
+		return false;
+
+	// only the visible part of the curve is rebuilt
+	const TRange<double> viewRange = rewindDebugger->GetCurrentViewRange();
+	m_GravityScaleCurve->Points.Reset();
+	provider->EnumerateMovementStates(m_ObjectId, viewRange.GetLowerBoundValue(), viewRange.GetUpperBoundValue(), [this](const FDeftMovementStateMessage& aMessage)
+	{
+		m_GravityScaleCurve->Points.Add({ aMessage.m_Time, aMessage.m_GravityScale });
+	});
+
+	// details are the state at the scrub position
+	const FDeftMovementStateMessage* state = provider->FindMovementState(m_ObjectId, rewindDebugger->CurrentTraceTime());
+	if (!state)
+	{
+		m_DetailsText = FText::GetEmpty();
+		return false;
+	}
+
+	const UEnum* movementModeEnum = StaticEnum<EMovementMode>();
+	FString details;
+	details += FString::Printf(TEXT("Movement Mode: %s\n"), *movementModeEnum->GetNameStringByValue(state->m_MovementMode));
+	details += FString::Printf(TEXT("Internal Move Mode: %s\n"), DeftMovementRewindTrack::GetInternalMoveModeName(state->m_InternalMoveMode));
+	details += FString::Printf(TEXT("Gravity Scale: %.3f\n"), state->m_GravityScale);
+	details += FString::Printf(TEXT("Jump Apex: %.2f\n"), state->m_JumpApex);
+	details += FString::Printf(TEXT("Jump Hold Time: %.3f\n"), state->m_JumpHoldTime);
+	details += FString::Printf(TEXT("Locks Forward/Back: %u Right/Left: %u\n"), state->m_ForwardBackLocks, state->m_RightLeftLocks);
+	details += FString::Printf(TEXT("Ledge Edge: %s\n"), *state->m_LedgeEdge.ToString());
+	details += FString::Printf(TEXT("Hop Up Location: %s\n"), *state->m_HopUpLocation.ToString());
+	details += FString::Printf(TEXT("In Platform Jump: %d  Apex Reached: %d  Jump Held: %d  Ledging Up: %d  Air Dashed: %d\n"),
+		(state->m_Flags & DMTF_InPlatformJump) != 0, (state->m_Flags & DMTF_JumpApexReached) != 0, (state->m_Flags & DMTF_JumpButtonDown) != 0,
+		(state->m_Flags & DMTF_LedgingUp) != 0, (state->m_Flags & DMTF_HasAirDashed) != 0);
+	details += FString::Printf(TEXT("Recording Time: %.3f"), state->m_RecordingTime);
+	m_DetailsText = FText::FromString(details);
+
+	return false;
+}
+
+TSharedPtr<SWidget> FDeftMovementTrack::GetTimelineViewInternal()
+{
+	return SNew(SCurveTimelineView)
+		.FillColor(FLinearColor(0.1f, 0.3f, 0.5f, 0.5f))
+		.CurveColor(FLinearColor(0.2f, 0.6f, 1.f))
+		.RenderFill(true)
+		.ViewRange_Lambda([]() { return IRewindDebugger::Instance()->GetCurrentViewRange(); })
+		.CurveData_Lambda([this]() { return m_GravityScaleCurve; });
+}
+
+TSharedPtr<SWidget> FDeftMovementTrack::GetDetailsViewInternal()
+{
+	return SNew(STextBlock)
+		.Text_Lambda([this]() { return m_DetailsText; });
+}
+
+
+FName FDeftMovementTrackCreator::GetTargetTypeNameInternal() const
+{
+	static const FName targetTypeName("DeftMovementComponent");
+	return targetTypeName;
+}
+
+void FDeftMovementTrackCreator::GetTrackTypesInternal(TArray<RewindDebugger::FRewindDebuggerTrackType>& Types) const
+{
+	Types.Add({ GetNameInternal(), LOCTEXT("TrackTypeName", "Deft Movement") });
+}
+
+TSharedPtr<RewindDebugger::FRewindDebuggerTrack> FDeftMovementTrackCreator::CreateTrackInternal(uint64 ObjectId) const
+{
+	return MakeShared<FDeftMovementTrack>(ObjectId);
+}
+
+bool FDeftMovementTrackCreator::HasDebugInfoInternal(uint64 ObjectId) const
+{
+	const TraceServices::IAnalysisSession* session = IRewindDebugger::Instance()->GetAnalysisSession();
+	if (!session)
+		return false;
+
+	TraceServices::FAnalysisSessionReadScope sessionReadScope(*session);
+	const FDeftMovementTraceProvider* provider = DeftMovementRewindTrack::GetProvider(session);
+	return provider && provider->HasMovementStates(ObjectId);
+}
+
+#undef LOCTEXT_NAMESPACE
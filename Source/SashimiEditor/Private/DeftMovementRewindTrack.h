@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IRewindDebuggerTrackCreator.h"
+#include "RewindDebuggerTrack.h"
+#include "SCurveTimelineView.h"
+
+// Rewind Debugger track under a DeftMovementComponent: gravity scale curve on the timeline, full state at the scrub time in details
+class FDeftMovementTrack : public RewindDebugger::FRewindDebuggerTrack
+{
+	public:
+		explicit FDeftMovementTrack(uint64 aObjectId);
+
+	private:
+		virtual bool UpdateInternal() override;
+		virtual TSharedPtr<SWidget> GetTimelineViewInternal() override;
+		virtual TSharedPtr<SWidget> GetDetailsViewInternal() override;
+		virtual FSlateIcon GetIconInternal() override { return m_Icon; }
+		virtual FName GetNameInternal() const override { return "DeftMovement"; }
+		virtual FText GetDisplayNameInternal() const override;
+		virtual uint64 GetObjectIdInternal() const override { return m_ObjectId; }
+
+		uint64 m_ObjectId;
+		FSlateIcon m_Icon;
+		TSharedPtr<SCurveTimelineView::FTimelineCurveData> m_GravityScaleCurve;
+		FText m_DetailsText;
+};
+
+class FDeftMovementTrackCreator : public RewindDebugger::IRewindDebuggerTrackCreator
+{
+	private:
+		virtual FName GetTargetTypeNameInternal() const override;
+		virtual FName GetNameInternal() const override { return "DeftMovement"; }
+		virtual void GetTrackTypesInternal(TArray<RewindDebugger::FRewindDebuggerTrackType>& Types) const override;
+		virtual TSharedPtr<RewindDebugger::FRewindDebuggerTrack> CreateTrackInternal(uint64 ObjectId) const override;
+		virtual bool HasDebugInfoInternal(uint64 ObjectId) const override;
+};
@@ -0,0 +1,40 @@
+#include "DeftMovementTraceAnalyzer.h"
+#include "DeftMovementTraceProvider.h"
+#include "TraceServices/Model/AnalysisSession.h"
+
+void FDeftMovementTraceAnalyzer::OnAnalysisBegin(const FOnAnalysisContext& Context)
+{
+	Context.InterfaceBuilder.RouteEvent(RouteId_MovementState, "DeftMovement", "MovementState");
+}
+
+bool FDeftMovementTraceAnalyzer::OnEvent(uint16 RouteId, EStyle Style, const FOnEventContext& Context)
+{
+	TraceServices::FAnalysisSessionEditScope _(m_Session);
+
+	const FEventData& eventData = Context.EventData;
+	switch (RouteId)
+	{
+		case RouteId_MovementState:
+		{
+			FDeftMovementStateMessage message;
+			message.m_Time = Context.EventTime.AsSeconds(eventData.GetValue<uint64>("Cycle"));
+			message.m_RecordingTime = eventData.GetValue<double>("RecordingTime");
+			message.m_GravityScale = eventData.GetValue<float>("GravityScale");
+			message.m_JumpApex = eventData.GetValue<float>("JumpApex");
+			message.m_JumpHoldTime = eventData.GetValue<float>("JumpHoldTime");
+			message.m_LedgeEdge = FVector3f(eventData.GetValue<float>("LedgeEdgeX"), eventData.GetValue<float>("LedgeEdgeY"), eventData.GetValue<float>("LedgeEdgeZ"));
+			message.m_HopUpLocation = FVector3f(eventData.GetValue<float>("HopUpX"), eventData.GetValue<float>("HopUpY"), eventData.GetValue<float>("HopUpZ"));
+			message.m_InternalMoveMode = eventData.GetValue<uint8>("InternalMoveMode");
+			message.m_MovementMode = eventData.GetValue<uint8>("MovementMode");
+			message.m_ForwardBackLocks = eventData.GetValue<uint8>("ForwardBackLocks");
+			message.m_RightLeftLocks = eventData.GetValue<uint8>("RightLeftLocks");
+			message.m_Flags = eventData.GetValue<uint8>("Flags");
+
+			m_Provider.AppendMovementState(eventData.GetValue<uint64>("ComponentId"), message);
+			m_Session.UpdateDurationSeconds(message.m_Time);
+			break;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Analyzer.h"
+
+namespace TraceServices { class IAnalysisSession; }
+class FDeftMovementTraceProvider;
+
+// Routes the DeftMovement trace events into FDeftMovementTraceProvider
+class FDeftMovementTraceAnalyzer : public UE::Trace::IAnalyzer
+{
+	public:
+		FDeftMovementTraceAnalyzer(TraceServices::IAnalysisSession& aSession, FDeftMovementTraceProvider& aProvider) : m_Session(aSession), m_Provider(aProvider) {}
+
+		virtual void OnAnalysisBegin(const FOnAnalysisContext& Context) override;
+		virtual bool OnEvent(uint16 RouteId, EStyle Style, const FOnEventContext& Context) override;
+
+	private:
+		enum : uint16
+		{
+			RouteId_MovementState,
+		};
+
+		TraceServices::IAnalysisSession& m_Session;
+		FDeftMovementTraceProvider& m_Provider;
+};
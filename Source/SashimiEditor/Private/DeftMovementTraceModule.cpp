@@ -0,0 +1,24 @@
+#include "DeftMovementTraceModule.h"
+#include "DeftMovementTraceAnalyzer.h"
+#include "DeftMovementTraceProvider.h"
+#include "TraceServices/Model/AnalysisSession.h"
+
+const FName FDeftMovementTraceModule::ModuleName("DeftMovementTrace");
+
+void FDeftMovementTraceModule::GetModuleInfo(TraceServices::FModuleInfo& OutModuleInfo)
+{
+	OutModuleInfo.Name = ModuleName;
+	OutModuleInfo.DisplayName = TEXT("Deft Movement");
+}
+
+void FDeftMovementTraceModule::OnAnalysisBegin(TraceServices::IAnalysisSession& InSession)
+{
+	TSharedPtr<FDeftMovementTraceProvider> provider = MakeShared<FDeftMovementTraceProvider>(InSession);
+	InSession.AddProvider(FDeftMovementTraceProvider::ProviderName, provider);
+	InSession.AddAnalyzer(new FDeftMovementTraceAnalyzer(InSession, *provider));
+}
+
+void FDeftMovementTraceModule::GetLoggers(TArray<const TCHAR*>& OutLoggers)
+{
+	OutLoggers.Add(TEXT("DeftMovement"));
+}
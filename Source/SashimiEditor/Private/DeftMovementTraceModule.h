@@ -0,0 +1,16 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TraceServices/ModuleService.h"
+
+// Adds the DeftMovement analyzer and provider to every trace analysis session (Insights and the Rewind Debugger)
+class FDeftMovementTraceModule : public TraceServices::IModule
+{
+	public:
+		static const FName ModuleName;
+
+		virtual void GetModuleInfo(TraceServices::FModuleInfo& OutModuleInfo) override;
+		virtual void OnAnalysisBegin(TraceServices::IAnalysisSession& InSession) override;
+		virtual void GetLoggers(TArray<const TCHAR*>& OutLoggers) override;
+		virtual void GenerateReports(const TraceServices::IAnalysisSession& Session, const TCHAR* CmdLine, const TCHAR* OutputDirectory) override {}
+};
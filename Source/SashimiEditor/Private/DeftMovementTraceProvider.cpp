@@ -0,0 +1,42 @@
+#include "DeftMovementTraceProvider.h"
+#include "Algo/BinarySearch.h"
+
+const FName FDeftMovementTraceProvider::ProviderName("DeftMovementTraceProvider");
+
+void FDeftMovementTraceProvider::AppendMovementState(uint64 aComponentId, const FDeftMovementStateMessage& aMessage)
+{
+	m_Session.WriteAccessCheck();
+	m_MovementStates.FindOrAdd(aComponentId).Add(aMessage);
+}
+
+bool FDeftMovementTraceProvider::HasMovementStates(uint64 aComponentId) const
+{
+	m_Session.ReadAccessCheck();
+	return m_MovementStates.Contains(aComponentId);
+}
+
+const FDeftMovementStateMessage* FDeftMovementTraceProvider::FindMovementState(uint64 aComponentId, double aTime) const
+{
+	m_Session.ReadAccessCheck();
+
+	const TArray<FDeftMovementStateMessage>* states = m_MovementStates.Find(aComponentId);
+	if (!states)
+		return nullptr;
+
+	const int32 index = Algo::UpperBoundBy(*states, aTime, &FDeftMovementStateMessage::m_Time) - 1;
+	return states->IsValidIndex(index) ? &(*states)[index] : nullptr;
+}
+
+void FDeftMovementTraceProvider::EnumerateMovementStates(uint64 aComponentId, double aStartTime, double aEndTime, TFunctionRef<void(const FDeftMovementStateMessage&)> aCallback) const
+{
+	m_Session.ReadAccessCheck();
+
+	const TArray<FDeftMovementStateMessage>* states = m_MovementStates.Find(aComponentId);
+	if (!states)
+		return;
+
+	for (int32 i = Algo::LowerBoundBy(*states, aStartTime, &FDeftMovementStateMessage::m_Time); i < states->Num() && (*states)[i].m_Time <= aEndTime; ++i)
+	{
+		aCallback((*states)[i]);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TraceServices/Model/AnalysisSession.h"
+
+// One DeftMovement.MovementState trace event
+struct FDeftMovementStateMessage
+{
+	double m_Time = 0.0;				// trace time (seconds)
+	double m_RecordingTime = 0.0;		// world elapsed time when it was recorded
+	float m_GravityScale = 0.f;
+	float m_JumpApex = 0.f;
+	float m_JumpHoldTime = 0.f;
+	FVector3f m_LedgeEdge = FVector3f::ZeroVector;
+	FVector3f m_HopUpLocation = FVector3f::ZeroVector;
+	uint8 m_InternalMoveMode = 0;
+	uint8 m_MovementMode = 0;
+	uint8 m_ForwardBackLocks = 0;
+	uint8 m_RightLeftLocks = 0;
+	uint8 m_Flags = 0;					// EDeftMovementTraceFlags
+};
+
+/**
+ * Holds the analyzed movement state records per component. Reads need a FAnalysisSessionReadScope on the session.
+ */
+class FDeftMovementTraceProvider : public TraceServices::IProvider
+{
+	public:
+		static const FName ProviderName;
+
+		explicit FDeftMovementTraceProvider(TraceServices::IAnalysisSession& aSession) : m_Session(aSession) {}
+
+		void AppendMovementState(uint64 aComponentId, const FDeftMovementStateMessage& aMessage);
+
+		bool HasMovementStates(uint64 aComponentId) const;
+		// Latest record at or before aTime
+		const FDeftMovementStateMessage* FindMovementState(uint64 aComponentId, double aTime) const;
+		void EnumerateMovementStates(uint64 aComponentId, double aStartTime, double aEndTime, TFunctionRef<void(const FDeftMovementStateMessage&)> aCallback) const;
+
+	private:
+		TraceServices::IAnalysisSession& m_Session;
+		// records arrive in time order from the game thread so every array stays sorted by m_Time
+		TMap<uint64, TArray<FDeftMovementStateMessage>> m_MovementStates;
+};
@@ -0,0 +1,228 @@
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationEditorCommon.h"
+#include "DeftMovementComponent.h"
+#include "Editor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Settings/LevelEditorPlaySettings.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DeftNetworkPredictionTest
+{
+	static const TCHAR* MapName = TEXT("/Game/game/maps/playground");
+	static constexpr int32 LatencyMs = 60;				// each way, so the client is always a few moves ahead of the server
+	static constexpr float ConnectTimeoutSeconds = 30.f;
+	static constexpr float CycleSeconds = 2.f;
+	static constexpr int32 Cycles = 8;					// every move below twice, forward and back
+	// spawning drops the pawn onto the floor and the server can correct the moves in flight while it does
+	static constexpr uint32 MaxCorrections = 2;
+
+	enum class EMove : uint8
+	{
+		Jump,
+		HeldJump,
+		DoubleJump,
+		AirDash,
+		COUNT
+	};
+
+	UWorld* FindPlayWorld(ENetMode aNetMode)
+	{
+		for (const FWorldContext& context : GEngine->GetWorldContexts())
+		{
+			if (context.WorldType == EWorldType::PIE && context.World() && context.World()->GetNetMode() == aNetMode)
+				return context.World();
+		}
+		return nullptr;
+	}
+
+	ACharacter* FindClientCharacter()
+	{
+		UWorld* world = FindPlayWorld(NM_Client);
+		const APlayerController* playerController = world ? world->GetFirstPlayerController() : nullptr;
+		return playerController ? Cast<ACharacter>(playerController->GetPawn()) : nullptr;
+	}
+
+	// the client's character as the server sees it
+	ACharacter* FindRemoteCharacter()
+	{
+		UWorld* world = FindPlayWorld(NM_ListenServer);
+		if (!world)
+			return nullptr;
+
+		for (TActorIterator<ACharacter> it(world); it; ++it)
+		{
+			if (it->GetController() && !it->IsLocallyControlled())
+				return *it;
+		}
+		return nullptr;
+	}
+
+	/**
+	 * Presses the client's inputs like ADeftStressController, through the same entry points as APlayerCharacter. Every
+	 * cycle is one move of the Deft move set, walking forward on even cycles and back on odd ones to stay near the start.
+	 */
+	struct InputScript
+	{
+		float m_Time = 0.f;
+
+		// Returns false once every cycle has run
+		bool Tick(ACharacter& aCharacter, UDeftMovementComponent& aMovement, float aDeltaSeconds)
+		{
+			const float previousTime = m_Time;
+			m_Time += aDeltaSeconds;
+			const int32 cycle = FMath::FloorToInt32(m_Time / CycleSeconds);
+			if (cycle >= Cycles)
+			{
+				aMovement.OnJumpReleased();
+				return false;
+			}
+
+			const float cycleStart = cycle * CycleSeconds;
+			auto crossed = [previousTime, this, cycleStart](float aCycleTime)
+			{
+				return previousTime < cycleStart + aCycleTime && m_Time >= cycleStart + aCycleTime;
+			};
+			auto press = [&aCharacter, &aMovement]()
+			{
+				aCharacter.Jump();
+				aMovement.OnJumpPressed();
+			};
+
+			switch ((EMove)(cycle % (int32)EMove::COUNT))
+			{
+				case EMove::Jump:
+					if (crossed(0.1f))	press();
+					if (crossed(0.2f))	aMovement.OnJumpReleased();
+					break;
+				case EMove::HeldJump:
+					if (crossed(0.1f))	press();
+					if (crossed(0.6f))	aMovement.OnJumpReleased();
+					break;
+				case EMove::DoubleJump:
+					if (crossed(0.1f))	press();
+					if (crossed(0.25f))	aMovement.OnJumpReleased();
+					if (crossed(0.55f))	press();
+					if (crossed(0.75f))	aMovement.OnJumpReleased();
+					break;
+				case EMove::AirDash:
+					if (crossed(0.1f))	press();
+					if (crossed(0.2f))	aMovement.OnJumpReleased();
+					if (crossed(0.4f))	aMovement.OnAirDash();
+					break;
+				default:
+					break;
+			}
+
+			// respect the movement locks like APlayerCharacter::Move does
+			if (!aMovement.GetDeftLocks().IsMoveInputForwardBackLocked())
+				aCharacter.AddMovementInput(aCharacter.GetActorForwardVector(), cycle % 2 == 0 ? 1.f : -1.f);
+			return true;
+		}
+	};
+
+	struct TestState
+	{
+		TWeakObjectPtr<ACharacter> m_ClientCharacter;
+		TWeakObjectPtr<ACharacter> m_RemoteCharacter;
+		InputScript m_Script;
+		double m_ConnectStartTime = 0.0;
+	};
+}
+
+/**
+ * Runs a listen server and one client in PIE with emulated latency, plays every Deft move on the client and checks the
+ * server hardly ever has to correct it. A mismatch between the saved moves and the server's simulation shows up here
+ * as a correction per move.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeftNetworkPredictionTest, "Sashimi.Movement.NetworkPrediction", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FDeftNetworkPredictionTest::RunTest(const FString& aParameters)
+{
+	using namespace DeftNetworkPredictionTest;
+
+	if (!FAutomationEditorCommonUtils::LoadMap(MapName))
+	{
+		AddError(FString::Printf(TEXT("couldn't load %s"), MapName));
+		return false;
+	}
+
+	ULevelEditorPlaySettings* playSettings = DuplicateObject(GetDefault<ULevelEditorPlaySettings>(), GetTransientPackage());
+	playSettings->SetPlayNetMode(EPlayNetMode::PIE_ListenServer);
+	playSettings->SetPlayNumberOfClients(2);
+	playSettings->bLaunchSeparateServer = false;
+	playSettings->SetRunUnderOneProcess(true);
+	playSettings->NetworkEmulationSettings.bIsNetworkEmulationEnabled = true;
+	playSettings->NetworkEmulationSettings.EmulationTarget = NetworkEmulationTarget::Any;
+	playSettings->NetworkEmulationSettings.OutPackets.MinLatency = LatencyMs;
+	playSettings->NetworkEmulationSettings.OutPackets.MaxLatency = LatencyMs;
+	playSettings->NetworkEmulationSettings.InPackets.MinLatency = LatencyMs;
+	playSettings->NetworkEmulationSettings.InPackets.MaxLatency = LatencyMs;
+
+	FRequestPlaySessionParams params;
+	params.WorldType = EPlaySessionWorldType::PlayInEditor;
+	params.EditorPlaySettings = playSettings;
+	GEditor->RequestPlaySession(params);
+
+	TSharedRef<TestState> state = MakeShared<TestState>();
+	state->m_ConnectStartTime = FPlatformTime::Seconds();
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, state]()
+	{
+		state->m_ClientCharacter = FindClientCharacter();
+		state->m_RemoteCharacter = FindRemoteCharacter();
+		if (state->m_ClientCharacter.IsValid() && state->m_RemoteCharacter.IsValid())
+			return true;
+
+		if (FPlatformTime::Seconds() - state->m_ConnectStartTime > ConnectTimeoutSeconds)
+		{
+			AddError(TEXT("the client never possessed a character on the server"));
+			return true;
+		}
+		return false;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([state]()
+	{
+		ACharacter* character = state->m_ClientCharacter.Get();
+		UDeftMovementComponent* movement = character ? Cast<UDeftMovementComponent>(character->GetCharacterMovement()) : nullptr;
+		if (!movement)
+			return true;
+
+		return !state->m_Script.Tick(*character, *movement, character->GetWorld()->GetDeltaSeconds());
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, state]()
+	{
+		const ACharacter* clientCharacter = state->m_ClientCharacter.Get();
+		const ACharacter* remoteCharacter = state->m_RemoteCharacter.Get();
+		const UDeftMovementComponent* clientMovement = clientCharacter ? Cast<UDeftMovementComponent>(clientCharacter->GetCharacterMovement()) : nullptr;
+		const UDeftMovementComponent* remoteMovement = remoteCharacter ? Cast<UDeftMovementComponent>(remoteCharacter->GetCharacterMovement()) : nullptr;
+		if (!clientMovement || !remoteMovement)
+		{
+			AddError(TEXT("the default pawn doesn't use UDeftMovementComponent"));
+		}
+		else
+		{
+			const UDeftMovementComponent::NetworkStats& clientStats = clientMovement->GetNetworkStats();
+			const UDeftMovementComponent::NetworkStats& serverStats = remoteMovement->GetNetworkStats();
+			TestTrue(TEXT("the server received the client's moves"), serverStats.m_ServerMoves > 0);
+			TestTrue(FString::Printf(TEXT("%u corrections for %u server moves, at most %u"), clientStats.m_Corrections, serverStats.m_ServerMoves, MaxCorrections), clientStats.m_Corrections <= MaxCorrections);
+		}
+
+		GEditor->RequestEndPlayMap();
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([]()
+	{
+		return GEditor->PlayWorld == nullptr && !GEditor->IsPlaySessionRequestQueued();
+	}));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class SashimiEditor : ModuleRules
+{
+	public SashimiEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "Sashimi" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore", "TraceLog", "TraceAnalysis", "TraceServices", "RewindDebuggerInterface", "UnrealEd" });
+	}
+}
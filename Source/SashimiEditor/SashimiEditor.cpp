@@ -0,0 +1,17 @@
+#include "SashimiEditor.h"
+#include "Modules/ModuleManager.h"
+#include "Features/IModularFeatures.h"
+
+void FSashimiEditorModule::StartupModule()
+{
+	IModularFeatures::Get().RegisterModularFeature(TraceServices::ModuleFeatureName, &m_TraceModule);
+	IModularFeatures::Get().RegisterModularFeature(RewindDebugger::IRewindDebuggerTrackCreator::ModularFeatureName, &m_TrackCreator);
+}
+
+void FSashimiEditorModule::ShutdownModule()
+{
+	IModularFeatures::Get().UnregisterModularFeature(RewindDebugger::IRewindDebuggerTrackCreator::ModularFeatureName, &m_TrackCreator);
+	IModularFeatures::Get().UnregisterModularFeature(TraceServices::ModuleFeatureName, &m_TraceModule);
+}
+
+IMPLEMENT_MODULE(FSashimiEditorModule, SashimiEditor);
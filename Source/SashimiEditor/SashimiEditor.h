@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleInterface.h"
+#include "DeftMovementTraceModule.h"
+#include "DeftMovementRewindTrack.h"
+
+class FSashimiEditorModule : public IModuleInterface
+{
+	public:
+		virtual void StartupModule() override;
+		virtual void ShutdownModule() override;
+
+	private:
+		FDeftMovementTraceModule m_TraceModule;
+		FDeftMovementTrackCreator m_TrackCreator;
+};